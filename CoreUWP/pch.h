@@ -26,22 +26,12 @@
 #include <winrt/Windows.UI.Input.Spatial.h>
 #include <wrl/client.h>
 
-#define SSE2  //indicates we want SSE2
-#define SSE41 //indicates we want SSE4.1 instructions (floor and blend is available)
-#define AVX2 //indicates we want AVX2 instructions (double speed!)
-
-#ifndef AVX2
-#include <xmmintrin.h> //SSE
-#include <emmintrin.h> //SSE 2
-#endif
-
-#ifdef SSE41
-#include <smmintrin.h> // SSE4.1
-#endif
-
-#ifdef AVX2
-#include <immintrin.h> //avx2
+// Intrinsics for every instruction set are always available; which ones run is decided at runtime by
+// CpuFeatures, so nothing here may assume more than the baseline of the target architecture.
+#if defined(_M_IX86) || defined(_M_X64)
+#include <immintrin.h>
 #endif
+#include <intrin.h>
 
 #include <dxgi.h>
 #include <d3d11.h>
@@ -0,0 +1,310 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Archive.h"
+#include "Hash.h"
+#include <algorithm>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Utility;
+
+namespace
+{
+	const unsigned char kMagic[4] = { 'H', 'P', 'A', 'K' };
+
+	struct ArchiveHeader
+	{
+		unsigned char Magic[4];
+		uint32_t Version;
+		uint32_t NumEntries;
+		uint32_t TableChecksum;
+		uint64_t TableOffset;
+		uint64_t NamesOffset;
+		uint64_t NamesSize;
+	};
+
+	static_assert(sizeof(ArchiveHeader) == 40, "Archive header layout changed");
+	static_assert(sizeof(Archive::Entry) == 48, "Archive entry layout changed");
+
+	uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	bool HasPrefix(const string& Name, const char* Prefix)
+	{
+		return Name.compare(0, strlen(Prefix), Prefix) == 0;
+	}
+}
+
+string Archive::NormalizeName(const wstring& name)
+{
+	string Result;
+	if (!name.empty())
+	{
+		const int NumBytes = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), (int)name.size(), nullptr, 0, nullptr, nullptr);
+		Result.resize(NumBytes);
+		WideCharToMultiByte(CP_UTF8, 0, name.c_str(), (int)name.size(), &Result[0], NumBytes, nullptr, nullptr);
+	}
+
+	for (char& c : Result)
+	{
+		if (c == '\\')
+			c = '/';
+		else if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+	}
+
+	if (HasPrefix(Result, "ms-appx:///"))
+		Result.erase(0, 11);
+
+	while (HasPrefix(Result, "./") || HasPrefix(Result, "/"))
+		Result.erase(0, Result[0] == '.' ? 2 : 1);
+
+	return Result;
+}
+
+uint64_t Archive::HashName(const string& normalizedName)
+{
+	return Hash::Hash64(normalizedName.data(), normalizedName.size());
+}
+
+shared_ptr<Archive> Archive::Open(const wstring& fileName)
+{
+	// Entries are looked up in whatever order the caller needs them.
+	shared_ptr<MappedFile> File = MappedFile::Open(fileName, kMapRandom);
+	if (File == nullptr || File->Size() < sizeof(ArchiveHeader))
+		return nullptr;
+
+	const unsigned char* Base = File->View().Data();
+	const uint64_t FileSize = File->Size();
+
+	ArchiveHeader Header;
+	memcpy(&Header, Base, sizeof(Header));
+
+	if (memcmp(Header.Magic, kMagic, sizeof(kMagic)) != 0 || Header.Version != kVersion)
+		return nullptr;
+
+	if (Header.TableOffset % alignof(Entry) != 0 || Header.TableOffset > FileSize ||
+		(uint64_t)Header.NumEntries * sizeof(Entry) > FileSize - Header.TableOffset ||
+		Header.NamesOffset > FileSize || Header.NamesSize > FileSize - Header.NamesOffset)
+	{
+		return nullptr;
+	}
+
+	const uint32_t TableChecksum = Hash::Crc32C(Base + Header.NamesOffset, (size_t)Header.NamesSize,
+		Hash::Crc32C(Base + Header.TableOffset, Header.NumEntries * sizeof(Entry)));
+	if (TableChecksum != Header.TableChecksum)
+		return nullptr;
+
+	// The table is used in place, so it only has to be checked once.
+	const Entry* Entries = (const Entry*)(Base + Header.TableOffset);
+	for (uint32_t i = 0; i < Header.NumEntries; ++i)
+	{
+		const Entry& e = Entries[i];
+		if (e.Offset > FileSize || e.StoredSize > FileSize - e.Offset ||
+			(uint64_t)e.NameOffset + e.NameLength > Header.NamesSize ||
+			(!e.IsCompressed() && e.StoredSize != e.Size) ||
+			(i > 0 && Entries[i - 1].NameHash > e.NameHash))
+		{
+			return nullptr;
+		}
+	}
+
+	shared_ptr<Archive> Result(new Archive);
+	Result->m_Entries = Entries;
+	Result->m_NumEntries = Header.NumEntries;
+	Result->m_Names = (const char*)(Base + Header.NamesOffset);
+	Result->m_NamesSize = Header.NamesSize;
+	Result->m_File = std::move(File);
+	return Result;
+}
+
+const Archive::Entry* Archive::Find(const wstring& name) const
+{
+	const string Normalized = NormalizeName(name);
+	const uint64_t Hash = HashName(Normalized);
+
+	const Entry* End = m_Entries + m_NumEntries;
+	const Entry* e = std::lower_bound(m_Entries, End, Hash,
+		[](const Entry& a, uint64_t b) { return a.NameHash < b; });
+
+	// Names that collide sit next to each other.
+	for (; e != End && e->NameHash == Hash; ++e)
+	{
+		if (e->NameLength == Normalized.size() && memcmp(m_Names + e->NameOffset, Normalized.data(), e->NameLength) == 0)
+			return e;
+	}
+
+	return nullptr;
+}
+
+string Archive::GetName(const Entry& entry) const
+{
+	return string(m_Names + entry.NameOffset, entry.NameLength);
+}
+
+FileView Archive::View(const Entry& entry) const
+{
+	return m_File->View((size_t)entry.Offset, (size_t)entry.StoredSize);
+}
+
+bool Archive::Verify(const Entry& entry) const
+{
+	return Hash::Crc32C(View(entry)) == entry.Checksum;
+}
+
+ByteArray Archive::Read(const Entry& entry) const
+{
+	if (entry.Size > SIZE_MAX)
+		return NullFile;
+
+	FileView Stored = View(entry);
+	if (Hash::Crc32C(Stored) != entry.Checksum)
+		return NullFile;
+
+	if (!entry.IsCompressed())
+		return Stored.ToByteArray();
+
+	const Compression::Codec* Codec = Compression::FindCodecByHeader(Stored.Data(), Stored.Size());
+	if (Codec == nullptr)
+		return NullFile;
+
+	ByteArray Result = make_shared<vector<unsigned char> >((size_t)entry.Size);
+	if (!Codec->DecompressInto(Stored.Data(), Stored.Size(), Result->data(), Result->size()))
+		return NullFile;
+
+	return Result;
+}
+
+ByteArray Archive::Read(const wstring& name) const
+{
+	const Entry* e = Find(name);
+	return e != nullptr ? Read(*e) : NullFile;
+}
+
+void Archive::Prefetch(const Entry& entry) const
+{
+	m_File->Prefetch((size_t)entry.Offset, (size_t)entry.StoredSize);
+}
+
+bool ArchiveWriter::AddData(const wstring& name, const void* data, size_t size, const Compression::Codec* codec, int level)
+{
+	PendingEntry NewEntry;
+	NewEntry.Name = Archive::NormalizeName(name);
+	NewEntry.NameHash = Archive::HashName(NewEntry.Name);
+	NewEntry.Size = size;
+	NewEntry.Compressed = false;
+
+	for (const PendingEntry& Existing : m_Entries)
+	{
+		if (Existing.NameHash == NewEntry.NameHash && Existing.Name == NewEntry.Name)
+			return false;
+	}
+
+	if (codec != nullptr && size > 0)
+	{
+		ByteArray Compressed = codec->Compress((const unsigned char*)data, size, level);
+
+		// Compressed entries are decoded by header, so the codec has to be one the reader can find.
+		ASSERT(Compressed == NullFile || Compression::FindCodecByHeader(Compressed->data(), Compressed->size()) == codec,
+			"Codec %s is not registered", codec->GetName());
+
+		if (Compressed != NullFile && Compressed->size() < size)
+		{
+			NewEntry.Data = Compressed;
+			NewEntry.Compressed = true;
+		}
+	}
+
+	if (!NewEntry.Compressed)
+		NewEntry.Data = make_shared<vector<unsigned char> >((const unsigned char*)data, (const unsigned char*)data + size);
+
+	m_Entries.push_back(std::move(NewEntry));
+	return true;
+}
+
+bool ArchiveWriter::AddFile(const wstring& name, const wstring& fileName, const Compression::Codec* codec, int level)
+{
+	shared_ptr<MappedFile> File = MappedFile::Open(fileName, kMapSequential);
+	if (File == nullptr)
+		return false;
+
+	return AddData(name, File->View().Data(), File->Size(), codec, level);
+}
+
+ByteArray ArchiveWriter::Build(void) const
+{
+	vector<const PendingEntry*> Sorted;
+	for (const PendingEntry& e : m_Entries)
+		Sorted.push_back(&e);
+
+	std::sort(Sorted.begin(), Sorted.end(), [](const PendingEntry* a, const PendingEntry* b)
+	{
+		return a->NameHash != b->NameHash ? a->NameHash < b->NameHash : a->Name < b->Name;
+	});
+
+	vector<Archive::Entry> Table(Sorted.size());
+	string Names;
+	uint64_t Offset = sizeof(ArchiveHeader);
+
+	for (size_t i = 0; i < Sorted.size(); ++i)
+	{
+		const PendingEntry& Pending = *Sorted[i];
+		const uint64_t StoredSize = Pending.Data->size();
+
+		Offset = AlignUp(Offset, StoredSize >= kPageAlignThreshold ? kPageAlignment : kSmallAlignment);
+
+		Archive::Entry& e = Table[i];
+		e.NameHash = Pending.NameHash;
+		e.Offset = Offset;
+		e.StoredSize = StoredSize;
+		e.Size = Pending.Size;
+		e.NameOffset = (uint32_t)Names.size();
+		e.NameLength = (uint32_t)Pending.Name.size();
+		e.Flags = Pending.Compressed ? Archive::kEntryCompressed : 0;
+		e.Checksum = Hash::Crc32C(Pending.Data->data(), Pending.Data->size());
+
+		Names += Pending.Name;
+		Offset += StoredSize;
+	}
+
+	ArchiveHeader Header = {};
+	memcpy(Header.Magic, kMagic, sizeof(kMagic));
+	Header.Version = Archive::kVersion;
+	Header.NumEntries = (uint32_t)Table.size();
+	Header.TableOffset = AlignUp(Offset, kSmallAlignment);
+	Header.NamesOffset = Header.TableOffset + Table.size() * sizeof(Archive::Entry);
+	Header.NamesSize = Names.size();
+
+	ByteArray Result = make_shared<vector<unsigned char> >((size_t)(Header.NamesOffset + Header.NamesSize));
+	unsigned char* Out = Result->data();
+
+	for (size_t i = 0; i < Sorted.size(); ++i)
+	{
+		if (Table[i].StoredSize > 0)
+			memcpy(Out + Table[i].Offset, Sorted[i]->Data->data(), (size_t)Table[i].StoredSize);
+	}
+
+	if (!Table.empty())
+		memcpy(Out + Header.TableOffset, Table.data(), Table.size() * sizeof(Archive::Entry));
+	if (!Names.empty())
+		memcpy(Out + Header.NamesOffset, Names.data(), Names.size());
+
+	Header.TableChecksum = Hash::Crc32C(Out + Header.NamesOffset, Names.size(),
+		Hash::Crc32C(Out + Header.TableOffset, Table.size() * sizeof(Archive::Entry)));
+	memcpy(Out, &Header, sizeof(Header));
+
+	return Result;
+}
+
+bool ArchiveWriter::Write(const wstring& fileName) const
+{
+	ByteArray Data = Build();
+	return WriteFileSync(fileName, Data->data(), Data->size());
+}
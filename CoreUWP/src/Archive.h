@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "Compression.h"
+
+namespace HolographicEngine::Utility
+{
+	// Many small assets packed into one file, so that loading them costs one open and a mapping instead
+	// of an open, a read and a close each.
+	//
+	//    Header   "HPAK", uint32_t version, uint32_t entry count, uint32_t table checksum,
+	//             uint64_t table offset, uint64_t names offset, uint64_t names size
+	//    Data     each entry's bytes, aligned as described below
+	//    Table    one Entry per asset, sorted by name hash
+	//    Names    the normalized UTF-8 names, not terminated
+	//
+	// Name hashes are Hash::Hash64.  Checksums are Hash::Crc32C: the table checksum covers the table and
+	// the names and is checked by Open; each entry's covers its stored bytes and is checked by Read.
+	//
+	// Names are normalized before hashing and comparing: ASCII letters are lower-cased, backslashes become
+	// slashes and a leading "ms-appx:///", "./" or "/" is dropped, so "ms-appx:///Shaders\\Foo.cso" and
+	// "shaders/foo.cso" name the same entry.
+	class Archive
+	{
+	public:
+		// Version 1 hashed names with FNV-1a and had no checksums.
+		static const uint32_t kVersion = 2;
+
+		// Entry is stored compressed in a format registered with the Compression registry.
+		static const uint32_t kEntryCompressed = 1;
+
+		struct Entry
+		{
+			uint64_t NameHash;
+			uint64_t Offset;
+			uint64_t StoredSize;
+			uint64_t Size;
+			uint32_t NameOffset;
+			uint32_t NameLength;
+			uint32_t Flags;
+			uint32_t Checksum;
+
+			bool IsCompressed(void) const { return (Flags & kEntryCompressed) != 0; }
+		};
+
+		// Returns nullptr if the file cannot be opened or is not a valid archive.  Only the table and the
+		// names are touched here; entry data is paged in when it is read.
+		static shared_ptr<Archive> Open(const wstring& fileName);
+
+		// Binary search on the name hash.  Returns nullptr if there is no such entry.
+		const Entry* Find(const wstring& name) const;
+
+		uint32_t GetNumEntries(void) const { return m_NumEntries; }
+		const Entry& GetEntry(uint32_t index) const { return m_Entries[index]; }
+		string GetName(const Entry& entry) const;
+
+		// The entry's bytes without copying them, straight from the mapping.  For a compressed entry these
+		// are the compressed bytes.  Not checked against the checksum; call Verify for that.
+		FileView View(const Entry& entry) const;
+
+		// Whether the entry's stored bytes match its checksum.  Touches every page of the entry.
+		bool Verify(const Entry& entry) const;
+
+		// The entry's contents as a new buffer, decompressed if necessary.  Returns NullFile if the entry
+		// fails its checksum or does not decompress.
+		ByteArray Read(const Entry& entry) const;
+		ByteArray Read(const wstring& name) const;
+
+		// Starts paging in an entry ahead of use.
+		void Prefetch(const Entry& entry) const;
+
+		static string NormalizeName(const wstring& name);
+		static uint64_t HashName(const string& normalizedName);
+
+	private:
+		Archive() {}
+
+		shared_ptr<MappedFile> m_File;
+		const Entry* m_Entries;
+		uint32_t m_NumEntries;
+		const char* m_Names;
+		uint64_t m_NamesSize;
+	};
+
+	// The packer.  Collects assets in memory and writes them out as one archive, sorted and aligned.
+	// Entries of at least kPageAlignThreshold bytes start on a page boundary so that they can be mapped
+	// on their own; smaller ones are packed on cache line boundaries so that a group of them shares
+	// pages.
+	class ArchiveWriter
+	{
+	public:
+		static const uint32_t kSmallAlignment = 64;
+		static const uint32_t kPageAlignment = 4096;
+		static const uint64_t kPageAlignThreshold = 64 * 1024;
+
+		// Adds an asset, compressed with codec if one is given and it makes the data smaller.  Returns
+		// false if an entry with the same normalized name was already added.
+		bool AddData(const wstring& name, const void* data, size_t size,
+			const Compression::Codec* codec = nullptr, int level = Compression::kMaxLevel);
+
+		// Same as AddData with the contents of a file on disk.  Returns false if it cannot be read.
+		bool AddFile(const wstring& name, const wstring& fileName,
+			const Compression::Codec* codec = nullptr, int level = Compression::kMaxLevel);
+
+		size_t GetNumEntries(void) const { return m_Entries.size(); }
+
+		ByteArray Build(void) const;
+		bool Write(const wstring& fileName) const;
+
+	private:
+		struct PendingEntry
+		{
+			string Name;
+			uint64_t NameHash;
+			uint64_t Size;
+			bool Compressed;
+			ByteArray Data;
+		};
+
+		vector<PendingEntry> m_Entries;
+	};
+}
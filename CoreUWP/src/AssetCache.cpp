@@ -0,0 +1,280 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "AssetCache.h"
+#include "Archive.h"
+#include "InstrumentedMutex.h"
+#include "MemoryTracking.h"
+#include <list>
+#include <unordered_map>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::AssetCache;
+
+namespace
+{
+	struct Entry
+	{
+		uint64_t Key;
+		string Name;
+		ByteArray Data;
+	};
+
+	struct Cache
+	{
+		InstrumentedMutex Mutex{ "IO/Asset Cache" };
+
+		// Most recently used at the front.
+		std::list<Entry> Entries;
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> Index;
+
+		// Kept apart from the entries so that an asset can be pinned before it is loaded.
+		std::unordered_map<uint64_t, uint32_t> Pins;
+
+		size_t Budget = kDefaultBudget;
+		size_t BytesCached = 0;
+
+		uint64_t Hits = 0;
+		uint64_t Misses = 0;
+		uint64_t Evictions = 0;
+	};
+
+	Cache& GetCache(void)
+	{
+		static Cache s_Cache;
+		return s_Cache;
+	}
+
+	// Uses the archive's name rules, so that a path names the same asset here and in an archive.
+	string MakeName(const wstring& fileName, uint64_t& Key)
+	{
+		string Name = Utility::Archive::NormalizeName(fileName);
+		Key = Utility::Archive::HashName(Name);
+		return Name;
+	}
+
+	bool IsPinned(const Cache& c, const Entry& e)
+	{
+		// The cache holds one reference; any other belongs to a caller still using the data.
+		return e.Data.use_count() > 1 || c.Pins.count(e.Key) != 0;
+	}
+
+	void Remove(Cache& c, std::list<Entry>::iterator it)
+	{
+		c.BytesCached -= it->Data->size();
+		c.Index.erase(it->Key);
+		c.Entries.erase(it);
+		++c.Evictions;
+	}
+
+	// Drops least recently used entries that are not pinned until the cache fits in budget bytes.
+	void EvictTo(Cache& c, size_t budget)
+	{
+		auto it = c.Entries.end();
+		while (c.BytesCached > budget && it != c.Entries.begin())
+		{
+			--it;
+			if (IsPinned(c, *it))
+				continue;
+
+			auto Victim = it++;
+			Remove(c, Victim);
+		}
+	}
+
+	// Returns the cached entry with this name, moved to the front, or nullptr.
+	Entry* Lookup(Cache& c, uint64_t Key, const string& Name)
+	{
+		auto it = c.Index.find(Key);
+		if (it == c.Index.end() || it->second->Name != Name)
+			return nullptr;
+
+		c.Entries.splice(c.Entries.begin(), c.Entries, it->second);
+		return &*it->second;
+	}
+
+	ByteArray InsertLocked(Cache& c, uint64_t Key, const string& Name, const ByteArray& Data)
+	{
+		if (Entry* Existing = Lookup(c, Key, Name))
+			return Existing->Data;
+
+		// Too big to ever fit; the caller keeps its own copy.
+		if (Data->size() > c.Budget)
+			return Data;
+
+		// Two names with one hash: the newer one wins unless the older is pinned.
+		auto Collision = c.Index.find(Key);
+		if (Collision != c.Index.end())
+		{
+			if (IsPinned(c, *Collision->second))
+				return Data;
+			Remove(c, Collision->second);
+		}
+
+		MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagCache);
+		c.Entries.push_front(Entry{ Key, Name, Data });
+		c.Index[Key] = c.Entries.begin();
+		c.BytesCached += Data->size();
+
+		EvictTo(c, c.Budget);
+		return Data;
+	}
+}
+
+ByteArray HolographicEngine::AssetCache::Find(const wstring& fileName)
+{
+	uint64_t Key;
+	const string Name = MakeName(fileName, Key);
+
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+
+	Entry* e = Lookup(c, Key, Name);
+	if (e == nullptr)
+		return Utility::NullFile;
+
+	return e->Data;
+}
+
+ByteArray HolographicEngine::AssetCache::Insert(const wstring& fileName, ByteArray data)
+{
+	if (data == nullptr || data == Utility::NullFile)
+		return Utility::NullFile;
+
+	uint64_t Key;
+	const string Name = MakeName(fileName, Key);
+
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	return InsertLocked(c, Key, Name, data);
+}
+
+ByteArray HolographicEngine::AssetCache::Load(const wstring& fileName)
+{
+	uint64_t Key;
+	const string Name = MakeName(fileName, Key);
+	Cache& c = GetCache();
+
+	{
+		std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+		if (Entry* e = Lookup(c, Key, Name))
+		{
+			++c.Hits;
+			return e->Data;
+		}
+		++c.Misses;
+	}
+
+	// Read without the lock so that hits on other assets are not held up.
+	ByteArray Data = Utility::ReadFileSync(fileName);
+	if (Data == Utility::NullFile)
+		return Data;
+
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	return InsertLocked(c, Key, Name, Data);
+}
+
+task<ByteArray> HolographicEngine::AssetCache::LoadAsync(const wstring& fileName, IOScheduler::Priority priority)
+{
+	uint64_t Key;
+	const string Name = MakeName(fileName, Key);
+	Cache& c = GetCache();
+
+	{
+		std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+		if (Entry* e = Lookup(c, Key, Name))
+		{
+			++c.Hits;
+			return task_from_result(e->Data);
+		}
+		++c.Misses;
+	}
+
+	return IOScheduler::ReadAsync(fileName, priority).then([Key, Name](ByteArray Data)
+	{
+		if (Data == Utility::NullFile)
+			return Data;
+
+		Cache& c = GetCache();
+		std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+		return InsertLocked(c, Key, Name, Data);
+	});
+}
+
+void HolographicEngine::AssetCache::Pin(const wstring& fileName)
+{
+	uint64_t Key;
+	MakeName(fileName, Key);
+
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagCache);
+	++c.Pins[Key];
+}
+
+void HolographicEngine::AssetCache::Unpin(const wstring& fileName)
+{
+	uint64_t Key;
+	MakeName(fileName, Key);
+
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+
+	auto it = c.Pins.find(Key);
+	ASSERT(it != c.Pins.end(), "Unpinning an asset that is not pinned");
+	if (it != c.Pins.end() && --it->second == 0)
+	{
+		c.Pins.erase(it);
+		EvictTo(c, c.Budget);
+	}
+}
+
+void HolographicEngine::AssetCache::SetBudget(size_t bytes)
+{
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	c.Budget = bytes;
+	EvictTo(c, c.Budget);
+}
+
+size_t HolographicEngine::AssetCache::GetBudget(void)
+{
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	return c.Budget;
+}
+
+void HolographicEngine::AssetCache::Trim(void)
+{
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	EvictTo(c, 0);
+}
+
+Stats HolographicEngine::AssetCache::GetStats(void)
+{
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+
+	Stats Result;
+	Result.Hits = c.Hits;
+	Result.Misses = c.Misses;
+	Result.Evictions = c.Evictions;
+	Result.NumEntries = c.Entries.size();
+	Result.BytesCached = c.BytesCached;
+	return Result;
+}
+
+void HolographicEngine::AssetCache::ResetStats(void)
+{
+	Cache& c = GetCache();
+	std::lock_guard<InstrumentedMutex> Guard(c.Mutex);
+	c.Hits = 0;
+	c.Misses = 0;
+	c.Evictions = 0;
+}
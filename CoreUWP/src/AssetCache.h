@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "IOScheduler.h"
+
+// One shared copy of each loaded file for the whole process.
+//
+// Entries are keyed by a hash of the normalized path, so "ms-appx:///Foo.cso" and "foo.cso" are the same
+// asset.  When the cached bytes exceed the budget the least recently used entries are dropped, but never
+// one that is pinned: either explicitly with Pin, or implicitly because a caller still holds the ByteArray,
+// since dropping it would free nothing.  Callers share the buffer, so they must not modify it.
+
+namespace HolographicEngine::AssetCache
+{
+	using namespace std;
+	using namespace concurrency;
+	using Utility::ByteArray;
+
+	const size_t kDefaultBudget = 64 * 1024 * 1024;
+
+	// Returns the cached copy, or reads the file with Utility::ReadFileSync and caches it.  Returns
+	// NullFile, and caches nothing, if the file cannot be read.
+	ByteArray Load(const wstring& fileName);
+
+	// Same through the IOScheduler, so concurrent misses for one file share a read.
+	task<ByteArray> LoadAsync(const wstring& fileName, IOScheduler::Priority priority = IOScheduler::kPriorityVisible);
+
+	// Returns the cached copy without reading, or NullFile.
+	ByteArray Find(const wstring& fileName);
+
+	// Caches data loaded some other way.  If the asset is already cached the existing copy is kept and
+	// returned, so that every caller ends up sharing one buffer.
+	ByteArray Insert(const wstring& fileName, ByteArray data);
+
+	// Pins are counted.  A pinned asset stays cached over budget and across Trim.
+	void Pin(const wstring& fileName);
+	void Unpin(const wstring& fileName);
+
+	void SetBudget(size_t bytes);
+	size_t GetBudget(void);
+
+	// Drops every entry that is not pinned.  Graphics::Trim calls this when the app suspends.
+	void Trim(void);
+
+	struct Stats
+	{
+		uint64_t Hits;
+		uint64_t Misses;
+		uint64_t Evictions;
+		size_t NumEntries;
+		size_t BytesCached;
+	};
+
+	Stats GetStats(void);
+	void ResetStats(void);
+}
@@ -0,0 +1,322 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "AsyncIO.h"
+#include "MemoryTracking.h"
+#include "StartupPrefetch.h"
+#include <atomic>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::AsyncIO;
+
+namespace HolographicEngine::AsyncIO
+{
+	// Lets the backends reach the handles without making them public.
+	struct FileAccess
+	{
+		static HANDLE GetHandle(const File& file) { return file.m_Handle; }
+		static PTP_IO GetIo(const File& file) { return file.m_Io; }
+	};
+}
+
+namespace
+{
+	// ReadFile takes a DWORD, so larger requests are split into parts of at most this size.
+	const size_t kMaxPartSize = 1 << 30;
+
+	std::atomic<Backend> s_Backend(kBackendThreadpoolIo);
+
+	std::atomic<uint64_t> s_Submitted(0);
+	std::atomic<uint64_t> s_Batches(0);
+	std::atomic<uint64_t> s_Completed(0);
+	std::atomic<uint64_t> s_Failed(0);
+	std::atomic<uint64_t> s_BytesRead(0);
+	std::atomic<uint32_t> s_InFlight(0);
+
+	struct PendingRead
+	{
+		ReadRequest Request;
+		std::atomic<uint32_t> PartsLeft;
+		std::atomic<uint32_t> Error;
+		std::atomic<size_t> BytesRead;
+	};
+
+	// One ReadFile call.  The OVERLAPPED comes first so that a completion can be turned back into its part.
+	struct Part
+	{
+		OVERLAPPED Overlapped;
+		shared_ptr<PendingRead> Read;
+		size_t Offset;
+		size_t Size;
+	};
+
+	void Finish(const PendingRead& Read, uint32_t Error, size_t BytesRead)
+	{
+		--s_InFlight;
+		++s_Completed;
+		if (Error != 0)
+			++s_Failed;
+		s_BytesRead += BytesRead;
+
+		if (Read.Request.OnComplete)
+			Read.Request.OnComplete(Error, BytesRead);
+	}
+
+	// Deletes the part, and completes its request when it was the last one.
+	void FinishPart(Part* part, uint32_t Error, size_t BytesRead)
+	{
+		shared_ptr<PendingRead> Read = std::move(part->Read);
+		delete part;
+
+		// Running into the end of the file is not an error; the short count says so.
+		if (Error == ERROR_HANDLE_EOF)
+			Error = 0;
+
+		if (Error != 0)
+		{
+			uint32_t NoError = 0;
+			Read->Error.compare_exchange_strong(NoError, Error);
+		}
+		Read->BytesRead += BytesRead;
+
+		if (--Read->PartsLeft == 0)
+			Finish(*Read, Read->Error, Read->BytesRead);
+	}
+
+	void CALLBACK OnIoComplete(PTP_CALLBACK_INSTANCE, PVOID, PVOID Overlapped, ULONG IoResult,
+		ULONG_PTR BytesTransferred, PTP_IO)
+	{
+		FinishPart((Part*)Overlapped, IoResult, (size_t)BytesTransferred);
+	}
+
+	void IssueThreadpoolIo(Part* part)
+	{
+		const File& Target = *part->Read->Request.Target;
+		const PTP_IO Io = FileAccess::GetIo(Target);
+
+		// Every ReadFile on a handle bound to a thread pool IO object has to be announced first, and the
+		// announcement withdrawn if the read fails without queuing a completion.
+		StartThreadpoolIo(Io);
+
+		unsigned char* Dest = (unsigned char*)part->Read->Request.Dest + part->Offset;
+		if (!ReadFile(FileAccess::GetHandle(Target), Dest, (DWORD)part->Size, nullptr, &part->Overlapped))
+		{
+			const DWORD Error = GetLastError();
+			if (Error != ERROR_IO_PENDING)
+			{
+				CancelThreadpoolIo(Io);
+				FinishPart(part, Error, 0);
+			}
+		}
+	}
+
+	void IssuePortable(Part* part)
+	{
+		create_task([part]
+		{
+			const File& Target = *part->Read->Request.Target;
+			unsigned char* Dest = (unsigned char*)part->Read->Request.Dest + part->Offset;
+
+			// A synchronous handle still takes its file position from the OVERLAPPED.
+			DWORD BytesRead = 0;
+			const BOOL Succeeded = ReadFile(FileAccess::GetHandle(Target), Dest, (DWORD)part->Size, &BytesRead, &part->Overlapped);
+			FinishPart(part, Succeeded ? 0 : GetLastError(), BytesRead);
+		});
+	}
+}
+
+void HolographicEngine::AsyncIO::SetBackend(Backend backend)
+{
+	s_Backend = backend;
+}
+
+Backend HolographicEngine::AsyncIO::GetBackend(void)
+{
+	return s_Backend;
+}
+
+const char* HolographicEngine::AsyncIO::GetBackendName(Backend backend)
+{
+	switch (backend)
+	{
+	case kBackendThreadpoolIo: return "Threadpool IO";
+	case kBackendPortable: return "Portable";
+	default: return "Unknown";
+	}
+}
+
+shared_ptr<File> File::Open(const wstring& fileName)
+{
+	const Backend FileBackend = s_Backend;
+
+	CREATEFILE2_EXTENDED_PARAMETERS params = {};
+	params.dwSize = sizeof(params);
+	params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	params.dwFileFlags = FileBackend == kBackendThreadpoolIo ? FILE_FLAG_OVERLAPPED : 0;
+
+	HANDLE handle = CreateFile2(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &params);
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	shared_ptr<File> result(new File);
+	result->m_Handle = handle;
+	result->m_Backend = FileBackend;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize))
+		return nullptr;
+	result->m_Size = (uint64_t)fileSize.QuadPart;
+
+	if (FileBackend == kBackendThreadpoolIo)
+	{
+		result->m_Io = CreateThreadpoolIo(handle, OnIoComplete, nullptr, nullptr);
+		if (result->m_Io == nullptr)
+			return nullptr;
+	}
+
+	StartupPrefetch::RecordRequest(fileName);
+	return result;
+}
+
+File::~File()
+{
+	// Every read holds a reference to its file, so none can be outstanding here.  This may run inside the
+	// last completion callback, which is why it must not wait for callbacks to finish.
+	if (m_Io != nullptr)
+		CloseThreadpoolIo(m_Io);
+
+	CloseHandle(m_Handle);
+}
+
+void HolographicEngine::AsyncIO::Submit(const ReadRequest* requests, size_t count)
+{
+	++s_Batches;
+	s_Submitted += count;
+	s_InFlight += (uint32_t)count;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const ReadRequest& Request = requests[i];
+
+		shared_ptr<PendingRead> Read = make_shared<PendingRead>();
+		Read->Request = Request;
+		Read->Error = 0;
+		Read->BytesRead = 0;
+
+		if (Request.Target == nullptr)
+		{
+			Finish(*Read, ERROR_INVALID_HANDLE, 0);
+			continue;
+		}
+
+		const uint64_t FileSize = Request.Target->Size();
+		const size_t Size = Request.Offset < FileSize ? (size_t)min((uint64_t)Request.Size, FileSize - Request.Offset) : 0;
+		if (Size == 0)
+		{
+			Finish(*Read, 0, 0);
+			continue;
+		}
+
+		const size_t NumParts = (Size + kMaxPartSize - 1) / kMaxPartSize;
+		Read->PartsLeft = (uint32_t)NumParts;
+
+		for (size_t p = 0; p < NumParts; ++p)
+		{
+			Part* part = new Part;
+			ZeroMemory(&part->Overlapped, sizeof(part->Overlapped));
+			part->Read = Read;
+			part->Offset = p * kMaxPartSize;
+			part->Size = min(kMaxPartSize, Size - part->Offset);
+
+			const uint64_t FileOffset = Request.Offset + part->Offset;
+			part->Overlapped.Offset = (DWORD)FileOffset;
+			part->Overlapped.OffsetHigh = (DWORD)(FileOffset >> 32);
+
+			if (Request.Target->GetBackend() == kBackendThreadpoolIo)
+				IssueThreadpoolIo(part);
+			else
+				IssuePortable(part);
+		}
+	}
+}
+
+void HolographicEngine::AsyncIO::Submit(const ReadRequest& request)
+{
+	Submit(&request, 1);
+}
+
+task<ByteArray> HolographicEngine::AsyncIO::ReadFileAsync(const wstring& fileName)
+{
+	MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagIO);
+	shared_ptr<File> Target = File::Open(fileName);
+	if (Target == nullptr || Target->Size() > SIZE_MAX)
+		return task_from_result(Utility::NullFile);
+
+	ByteArray Buffer = make_shared<vector<unsigned char> >((size_t)Target->Size());
+	task_completion_event<ByteArray> Done;
+
+	ReadRequest Request;
+	Request.Target = Target;
+	Request.Offset = 0;
+	Request.Dest = Buffer->data();
+	Request.Size = Buffer->size();
+	Request.OnComplete = [Buffer, Done](uint32_t Error, size_t BytesRead)
+	{
+		Done.set(Error == 0 && BytesRead == Buffer->size() ? Buffer : Utility::NullFile);
+	};
+
+	Submit(Request);
+	return task<ByteArray>(Done);
+}
+
+ByteArray HolographicEngine::AsyncIO::ReadFileSync(const wstring& fileName)
+{
+	MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagIO);
+	shared_ptr<File> Target = File::Open(fileName);
+	if (Target == nullptr || Target->Size() > SIZE_MAX)
+		return Utility::NullFile;
+
+	ByteArray Buffer = make_shared<vector<unsigned char> >((size_t)Target->Size());
+
+	HANDLE Event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	if (Event == nullptr)
+		return Utility::NullFile;
+
+	uint32_t ReadError = 0;
+	size_t ReadBytes = 0;
+
+	ReadRequest Request;
+	Request.Target = std::move(Target);
+	Request.Offset = 0;
+	Request.Dest = Buffer->data();
+	Request.Size = Buffer->size();
+	Request.OnComplete = [&](uint32_t Error, size_t BytesRead)
+	{
+		ReadError = Error;
+		ReadBytes = BytesRead;
+		SetEvent(Event);
+	};
+
+	Submit(Request);
+	WaitForSingleObjectEx(Event, INFINITE, FALSE);
+	CloseHandle(Event);
+
+	return ReadError == 0 && ReadBytes == Buffer->size() ? Buffer : Utility::NullFile;
+}
+
+Stats HolographicEngine::AsyncIO::GetStats(void)
+{
+	Stats Result;
+	Result.Submitted = s_Submitted;
+	Result.Batches = s_Batches;
+	Result.Completed = s_Completed;
+	Result.Failed = s_Failed;
+	Result.BytesRead = s_BytesRead;
+	Result.InFlight = s_InFlight;
+	return Result;
+}
@@ -0,0 +1,100 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "FileUtility.h"
+#include <functional>
+
+// File reads that complete with a callback instead of blocking or being polled.
+//
+// Two backends are available.  The default hands overlapped reads to the kernel and gets completions on a
+// thread pool IO object, so no thread waits while a read is in flight.  The portable backend issues
+// ordinary positioned reads from PPL tasks, for comparison and for file systems that do not support
+// overlapped IO.  Either way the callback runs on a pool thread and must not block for long, except that a
+// request that cannot be issued at all, or asks for nothing, completes on the submitting thread.
+
+namespace HolographicEngine::AsyncIO
+{
+	using namespace std;
+	using namespace concurrency;
+	using Utility::ByteArray;
+
+	enum Backend
+	{
+		kBackendThreadpoolIo,
+		kBackendPortable,
+	};
+
+	// Only affects files opened afterwards.
+	void SetBackend(Backend backend);
+	Backend GetBackend(void);
+	const char* GetBackendName(Backend backend);
+
+	// A file opened for reading with the backend that was current at the time.
+	class File
+	{
+	public:
+		// Returns nullptr if the file cannot be opened.
+		static shared_ptr<File> Open(const wstring& fileName);
+
+		~File();
+
+		File(const File&) = delete;
+		File& operator=(const File&) = delete;
+
+		uint64_t Size(void) const { return m_Size; }
+		Backend GetBackend(void) const { return m_Backend; }
+
+	private:
+		friend struct FileAccess;
+
+		File() : m_Handle(nullptr), m_Io(nullptr), m_Size(0), m_Backend(kBackendPortable) {}
+
+		HANDLE m_Handle;
+		PTP_IO m_Io;
+		uint64_t m_Size;
+		Backend m_Backend;
+	};
+
+	// Error is 0 or a Win32 error code.  A read that reaches the end of the file completes with fewer bytes
+	// than asked for and no error.
+	typedef std::function<void(uint32_t error, size_t bytesRead)> Completion;
+
+	struct ReadRequest
+	{
+		shared_ptr<File> Target;
+		uint64_t Offset;
+		void* Dest;
+		size_t Size;
+		Completion OnComplete;
+	};
+
+	// Issues every request before returning, so the device sees the whole batch at once.  Dest must stay
+	// valid until the request completes.  Each request completes exactly once, even if it could not be
+	// issued.
+	void Submit(const ReadRequest* requests, size_t count);
+	void Submit(const ReadRequest& request);
+
+	// Reads a whole file with one request.  The task completes with NullFile if it cannot be read.
+	task<ByteArray> ReadFileAsync(const wstring& fileName);
+
+	// Same, blocking the calling thread on the completion rather than spinning.
+	ByteArray ReadFileSync(const wstring& fileName);
+
+	struct Stats
+	{
+		uint64_t Submitted;    // Requests
+		uint64_t Batches;      // Calls to Submit
+		uint64_t Completed;
+		uint64_t Failed;
+		uint64_t BytesRead;
+		uint32_t InFlight;
+	};
+
+	Stats GetStats(void);
+}
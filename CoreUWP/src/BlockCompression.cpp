@@ -0,0 +1,267 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "BlockCompression.h"
+#include <ppl.h>
+
+using namespace HolographicEngine::Compression;
+using namespace HolographicEngine::Utility;
+
+namespace
+{
+	const unsigned char kMagic[4] = { 'B', 'L', 'K', '1' };
+	const size_t kCodecNameLength = 12;
+
+	// Block is stored uncompressed.
+	const uint32_t kBlockStored = 1;
+
+#pragma pack(push, 1)
+	struct ContainerHeader
+	{
+		unsigned char Magic[4];
+		uint32_t BlockSize;
+		uint64_t Size;
+		uint32_t NumBlocks;
+		char InnerCodec[kCodecNameLength];
+	};
+
+	struct IndexEntry
+	{
+		uint64_t Offset;
+		uint32_t CompressedSize;
+		uint32_t Flags;
+	};
+#pragma pack(pop)
+
+	// Reads the header and checks that it describes a consistent container of the given size.
+	bool ReadHeader(const unsigned char* data, size_t size, ContainerHeader& header)
+	{
+		if (size < sizeof(ContainerHeader))
+			return false;
+
+		memcpy(&header, data, sizeof(header));
+		if (memcmp(header.Magic, kMagic, sizeof(kMagic)) != 0 || header.BlockSize == 0)
+			return false;
+
+		const uint64_t ExpectedBlocks = (header.Size + header.BlockSize - 1) / header.BlockSize;
+		return header.NumBlocks == ExpectedBlocks &&
+			(uint64_t)header.NumBlocks * sizeof(IndexEntry) <= size - sizeof(ContainerHeader);
+	}
+
+	class BlockCodec : public Codec
+	{
+	public:
+		const char* GetName(void) const override { return "Blocked"; }
+		const wchar_t* GetExtension(void) const override { return L".blz"; }
+
+		bool MatchesHeader(const unsigned char* data, size_t size) const override
+		{
+			return size >= sizeof(kMagic) && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+		}
+
+		bool GetDecompressedSize(const unsigned char* data, size_t size, uint64_t& decompressedSize) const override
+		{
+			ContainerHeader header;
+			if (!ReadHeader(data, size, header))
+				return false;
+
+			decompressedSize = header.Size;
+			return true;
+		}
+
+		bool DecompressInto(const unsigned char* data, size_t size, unsigned char* dest, size_t destSize) const override
+		{
+			shared_ptr<BlockReader> reader = BlockReader::Open(FileView(nullptr, data, size));
+			return reader != nullptr && reader->GetSize() == destSize && reader->Read(0, dest, destSize);
+		}
+
+		ByteArray Compress(const unsigned char* data, size_t size, int level) const override
+		{
+			return CompressBlocks(data, size, GetLZCodec(), kDefaultBlockSize, level);
+		}
+	};
+}
+
+ByteArray HolographicEngine::Compression::CompressBlocks(const unsigned char* data, size_t size, const Codec& inner,
+	uint32_t blockSize, int level)
+{
+	ASSERT(blockSize > 0, "Block size must be positive");
+	ASSERT(strlen(inner.GetName()) < kCodecNameLength, "Codec name %s is too long for the container header", inner.GetName());
+
+	const uint32_t NumBlocks = (uint32_t)((size + blockSize - 1) / blockSize);
+	std::vector<ByteArray> Blocks(NumBlocks);
+
+	concurrency::parallel_for(0u, NumBlocks, [&](uint32_t Block)
+	{
+		const size_t Offset = (size_t)Block * blockSize;
+		const size_t BlockBytes = min((size_t)blockSize, size - Offset);
+		Blocks[Block] = inner.Compress(data + Offset, BlockBytes, level);
+	});
+
+	ContainerHeader Header = {};
+	memcpy(Header.Magic, kMagic, sizeof(kMagic));
+	Header.BlockSize = blockSize;
+	Header.Size = size;
+	Header.NumBlocks = NumBlocks;
+	strncpy_s(Header.InnerCodec, inner.GetName(), kCodecNameLength - 1);
+
+	std::vector<IndexEntry> Index(NumBlocks);
+	uint64_t DataOffset = sizeof(ContainerHeader) + NumBlocks * sizeof(IndexEntry);
+
+	for (uint32_t Block = 0; Block < NumBlocks; ++Block)
+	{
+		const size_t BlockBytes = min((size_t)blockSize, size - (size_t)Block * blockSize);
+
+		// A block that does not shrink is cheaper to store than to decompress.
+		if (Blocks[Block] == NullFile || Blocks[Block]->size() >= BlockBytes)
+		{
+			Index[Block].CompressedSize = (uint32_t)BlockBytes;
+			Index[Block].Flags = kBlockStored;
+			Blocks[Block] = nullptr;
+		}
+		else
+		{
+			Index[Block].CompressedSize = (uint32_t)Blocks[Block]->size();
+			Index[Block].Flags = 0;
+		}
+
+		Index[Block].Offset = DataOffset;
+		DataOffset += Index[Block].CompressedSize;
+	}
+
+	ByteArray Result = make_shared<vector<unsigned char> >((size_t)DataOffset);
+	unsigned char* Out = Result->data();
+
+	memcpy(Out, &Header, sizeof(Header));
+	if (NumBlocks > 0)
+		memcpy(Out + sizeof(Header), Index.data(), NumBlocks * sizeof(IndexEntry));
+
+	for (uint32_t Block = 0; Block < NumBlocks; ++Block)
+	{
+		const unsigned char* Source = Blocks[Block] != nullptr ? Blocks[Block]->data() : data + (size_t)Block * blockSize;
+		memcpy(Out + Index[Block].Offset, Source, Index[Block].CompressedSize);
+	}
+
+	return Result;
+}
+
+const Codec& HolographicEngine::Compression::GetBlockCodec(void)
+{
+	static BlockCodec s_Codec;
+	return s_Codec;
+}
+
+shared_ptr<BlockReader> BlockReader::Open(FileView source)
+{
+	ContainerHeader Header;
+	if (!ReadHeader(source.Data(), source.Size(), Header))
+		return nullptr;
+
+	char InnerName[kCodecNameLength + 1] = {};
+	memcpy(InnerName, Header.InnerCodec, kCodecNameLength);
+
+	const Codec* Inner = FindCodecByName(InnerName);
+	if (Inner == nullptr || Inner == &GetBlockCodec())
+		return nullptr;
+
+	shared_ptr<BlockReader> Reader(new BlockReader);
+	Reader->m_Inner = Inner;
+	Reader->m_Size = Header.Size;
+	Reader->m_BlockSize = Header.BlockSize;
+	Reader->m_Index.resize(Header.NumBlocks);
+
+	const unsigned char* IndexData = source.Data() + sizeof(ContainerHeader);
+	for (uint32_t Block = 0; Block < Header.NumBlocks; ++Block)
+	{
+		IndexEntry Entry;
+		memcpy(&Entry, IndexData + Block * sizeof(IndexEntry), sizeof(Entry));
+
+		const uint64_t BlockBytes = min((uint64_t)Header.BlockSize, Header.Size - (uint64_t)Block * Header.BlockSize);
+		if (Entry.Offset > source.Size() || Entry.CompressedSize > source.Size() - Entry.Offset ||
+			((Entry.Flags & kBlockStored) && Entry.CompressedSize != BlockBytes))
+		{
+			return nullptr;
+		}
+
+		Reader->m_Index[Block] = { Entry.Offset, Entry.CompressedSize, Entry.Flags };
+	}
+
+	Reader->m_Source = std::move(source);
+	return Reader;
+}
+
+shared_ptr<BlockReader> BlockReader::OpenFile(const std::wstring& fileName)
+{
+	// Blocks are read in whatever order the workers reach them.
+	shared_ptr<MappedFile> File = MappedFile::Open(fileName, kMapRandom);
+	return File != nullptr ? Open(File->View()) : nullptr;
+}
+
+bool BlockReader::ReadBlock(uint32_t block, size_t offsetInBlock, unsigned char* dest, size_t size) const
+{
+	const BlockEntry& Entry = m_Index[block];
+	const unsigned char* Compressed = m_Source.Data() + Entry.Offset;
+
+	if (Entry.Flags & kBlockStored)
+	{
+		memcpy(dest, Compressed + offsetInBlock, size);
+		return true;
+	}
+
+	const size_t BlockBytes = (size_t)min((uint64_t)m_BlockSize, m_Size - (uint64_t)block * m_BlockSize);
+	if (offsetInBlock == 0 && size == BlockBytes)
+		return m_Inner->DecompressInto(Compressed, Entry.CompressedSize, dest, size);
+
+	std::unique_ptr<unsigned char[]> Temp(new unsigned char[BlockBytes]);
+	if (!m_Inner->DecompressInto(Compressed, Entry.CompressedSize, Temp.get(), BlockBytes))
+		return false;
+
+	memcpy(dest, Temp.get() + offsetInBlock, size);
+	return true;
+}
+
+bool BlockReader::Read(uint64_t offset, void* dest, size_t size) const
+{
+	if (offset > m_Size || size > m_Size - offset)
+		return false;
+
+	if (size == 0)
+		return true;
+
+	const uint32_t FirstBlock = (uint32_t)(offset / m_BlockSize);
+	const uint32_t LastBlock = (uint32_t)((offset + size - 1) / m_BlockSize);
+
+	auto ReadPart = [&](uint32_t Block)
+	{
+		const uint64_t BlockStart = (uint64_t)Block * m_BlockSize;
+		const uint64_t Start = max(offset, BlockStart);
+		const uint64_t End = min(offset + size, BlockStart + m_BlockSize);
+		return ReadBlock(Block, (size_t)(Start - BlockStart), (unsigned char*)dest + (Start - offset), (size_t)(End - Start));
+	};
+
+	if (FirstBlock == LastBlock)
+		return ReadPart(FirstBlock);
+
+	std::atomic<bool> Succeeded(true);
+	concurrency::parallel_for(FirstBlock, LastBlock + 1, [&](uint32_t Block)
+	{
+		if (Succeeded.load(std::memory_order_relaxed) && !ReadPart(Block))
+			Succeeded.store(false, std::memory_order_relaxed);
+	});
+
+	return Succeeded;
+}
+
+ByteArray BlockReader::ReadAll(void) const
+{
+	if (m_Size > SIZE_MAX)
+		return NullFile;
+
+	ByteArray Result = make_shared<vector<unsigned char> >((size_t)m_Size);
+	return Read(0, Result->data(), Result->size()) ? Result : NullFile;
+}
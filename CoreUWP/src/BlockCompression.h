@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "Compression.h"
+
+namespace HolographicEngine::Compression
+{
+	// A container that splits data into fixed-size blocks and compresses each one on its own with an
+	// inner codec, so that blocks can be decompressed in parallel and any byte range can be read without
+	// decompressing what comes before it.
+	//
+	//    Header   "BLK1", uint32_t block size, uint64_t decompressed size, uint32_t block count,
+	//             char[12] inner codec name
+	//    Index    per block: uint64_t file offset, uint32_t compressed size, uint32_t flags
+	//    Blocks   each compressed with the inner codec, or stored as is when that is smaller
+
+	const uint32_t kDefaultBlockSize = 256 * 1024;
+
+	// Compresses data into a block container, compressing the blocks in parallel.
+	ByteArray CompressBlocks(const unsigned char* data, size_t size, const Codec& inner,
+		uint32_t blockSize = kDefaultBlockSize, int level = kDefaultLevel);
+
+	// The container as a Codec, registered ahead of the others with the extension ".blz".  Compress uses
+	// LZB blocks of kDefaultBlockSize; decompression accepts any inner codec that is registered.
+	const Codec& GetBlockCodec(void);
+
+	class BlockReader
+	{
+	public:
+		// Returns nullptr if the source is not a valid container or its inner codec is not registered.  The
+		// view keeps the source alive for the lifetime of the reader.
+		static std::shared_ptr<BlockReader> Open(Utility::FileView source);
+		static std::shared_ptr<BlockReader> OpenFile(const std::wstring& fileName);
+
+		uint64_t GetSize(void) const { return m_Size; }
+		uint32_t GetBlockSize(void) const { return m_BlockSize; }
+		uint32_t GetNumBlocks(void) const { return (uint32_t)m_Index.size(); }
+		const Codec& GetInnerCodec(void) const { return *m_Inner; }
+
+		// Decompresses bytes [offset, offset + size) into dest, touching only the blocks that overlap the
+		// range.  Blocks are decompressed in parallel when there is more than one.  Returns false if the
+		// range is out of bounds or a block is corrupt.
+		bool Read(uint64_t offset, void* dest, size_t size) const;
+
+		ByteArray ReadAll(void) const;
+
+	private:
+		struct BlockEntry
+		{
+			uint64_t Offset;
+			uint32_t CompressedSize;
+			uint32_t Flags;
+		};
+
+		BlockReader() {}
+
+		// Decompresses part of one block.  Whole blocks go straight to dest; partial ones through a
+		// temporary buffer.
+		bool ReadBlock(uint32_t block, size_t offsetInBlock, unsigned char* dest, size_t size) const;
+
+		Utility::FileView m_Source;
+		const Codec* m_Inner;
+		uint64_t m_Size;
+		uint32_t m_BlockSize;
+		std::vector<BlockEntry> m_Index;
+	};
+}
@@ -0,0 +1,185 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Compression.h"
+#include "BlockCompression.h"
+#include "InstrumentedMutex.h"
+#include <zlib.h> // From NuGet package
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Compression;
+using namespace HolographicEngine::Utility;
+
+namespace
+{
+	// zlib, with a gzip wrapper when compressing.  Reads both gzip and raw zlib streams.
+	class GzipCodec : public Codec
+	{
+	public:
+		const char* GetName(void) const override { return "gzip"; }
+		const wchar_t* GetExtension(void) const override { return L".gz"; }
+
+		bool MatchesHeader(const unsigned char* data, size_t size) const override
+		{
+			if (size < 2)
+				return false;
+
+			const bool IsGzip = data[0] == 0x1F && data[1] == 0x8B;
+			const bool IsZlib = (data[0] & 0x0F) == Z_DEFLATED && ((data[0] << 8) | data[1]) % 31 == 0;
+			return IsGzip || IsZlib;
+		}
+
+		// The gzip trailer only holds the size modulo 4 GB, so it cannot be trusted to size a buffer exactly.
+		bool GetDecompressedSize(const unsigned char*, size_t, uint64_t&) const override
+		{
+			return false;
+		}
+
+		bool DecompressInto(const unsigned char* data, size_t size, unsigned char* dest, size_t destSize) const override
+		{
+			InflateStream stream(FileView(nullptr, data, size));
+			if (stream.Read(dest, destSize) != destSize || stream.HasFailed())
+				return false;
+
+			// The stream has to end exactly where the buffer does.
+			unsigned char extra;
+			return stream.Read(&extra, 1) == 0 && stream.IsFinished() && !stream.HasFailed();
+		}
+
+		ByteArray Decompress(const unsigned char* data, size_t size) const override
+		{
+			int error;
+			return Inflate(FileView(nullptr, data, size), error);
+		}
+
+		ByteArray Compress(const unsigned char* data, size_t size, int level) const override
+		{
+			z_stream strm = {};
+
+			// 15 window bits, and the +16 asks zlib for a gzip header and trailer
+			if (deflateInit2(&strm, min(max(level, 0), kMaxLevel), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				return NullFile;
+
+			ByteArray result = make_shared<vector<unsigned char> >(deflateBound(&strm, (uLong)size));
+			strm.next_in = (Bytef*)data;
+			strm.avail_in = (uInt)size;
+			strm.next_out = result->data();
+			strm.avail_out = (uInt)result->size();
+
+			int err = deflate(&strm, Z_FINISH);
+			result->resize(strm.total_out);
+			deflateEnd(&strm);
+
+			return err == Z_STREAM_END ? result : NullFile;
+		}
+	};
+
+	struct Registry
+	{
+		Registry()
+		{
+			Codecs.push_back(&GetBlockCodec());
+			Codecs.push_back(&GetLZCodec());
+			Codecs.push_back(&GetGzipCodec());
+		}
+
+		InstrumentedMutex Mutex{ "IO/Codecs" };
+		std::vector<const Codec*> Codecs;
+	};
+
+	Registry& GetRegistry(void)
+	{
+		static Registry s_Registry;
+		return s_Registry;
+	}
+}
+
+ByteArray Codec::Decompress(const unsigned char* data, size_t size) const
+{
+	uint64_t decompressedSize;
+	if (!GetDecompressedSize(data, size, decompressedSize) || decompressedSize > SIZE_MAX)
+		return NullFile;
+
+	ByteArray result = make_shared<vector<unsigned char> >((size_t)decompressedSize);
+	if (!DecompressInto(data, size, result->data(), result->size()))
+		return NullFile;
+
+	return result;
+}
+
+const Codec& HolographicEngine::Compression::GetGzipCodec(void)
+{
+	static GzipCodec s_Codec;
+	return s_Codec;
+}
+
+void HolographicEngine::Compression::RegisterCodec(const Codec& codec)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<InstrumentedMutex> guard(registry.Mutex);
+	registry.Codecs.push_back(&codec);
+}
+
+std::vector<const Codec*> HolographicEngine::Compression::GetCodecs(void)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<InstrumentedMutex> guard(registry.Mutex);
+	return registry.Codecs;
+}
+
+const Codec* HolographicEngine::Compression::FindCodecByName(const char* name)
+{
+	for (const Codec* codec : GetCodecs())
+	{
+		if (_stricmp(codec->GetName(), name) == 0)
+			return codec;
+	}
+
+	return nullptr;
+}
+
+const Codec* HolographicEngine::Compression::FindCodecByExtension(const std::wstring& extension)
+{
+	for (const Codec* codec : GetCodecs())
+	{
+		if (_wcsicmp(codec->GetExtension(), extension.c_str()) == 0)
+			return codec;
+	}
+
+	return nullptr;
+}
+
+const Codec* HolographicEngine::Compression::FindCodecByHeader(const unsigned char* data, size_t size)
+{
+	for (const Codec* codec : GetCodecs())
+	{
+		if (codec->MatchesHeader(data, size))
+			return codec;
+	}
+
+	return nullptr;
+}
+
+ByteArray HolographicEngine::Compression::Decompress(const unsigned char* data, size_t size)
+{
+	const Codec* codec = FindCodecByHeader(data, size);
+	return codec != nullptr ? codec->Decompress(data, size) : NullFile;
+}
+
+bool HolographicEngine::Compression::CompressFile(const std::wstring& fileName, const Codec& codec, int level)
+{
+	shared_ptr<MappedFile> source = MappedFile::Open(fileName, kMapSequential);
+	if (source == nullptr)
+		return false;
+
+	ByteArray compressed = codec.Compress(source->View().Data(), source->Size(), level);
+	if (compressed == NullFile)
+		return false;
+
+	return WriteFileSync(fileName + codec.GetExtension(), compressed->data(), compressed->size());
+}
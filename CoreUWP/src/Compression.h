@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "FileUtility.h"
+
+namespace HolographicEngine::Compression
+{
+	using Utility::ByteArray;
+
+	const int kDefaultLevel = 6;
+	const int kMaxLevel = 9;
+
+	// One compressed format.  Codecs are stateless and shared between threads.
+	class Codec
+	{
+	public:
+		virtual ~Codec() {}
+
+		virtual const char* GetName(void) const = 0;
+
+		// Appended to an asset's file name, e.g. L".gz".
+		virtual const wchar_t* GetExtension(void) const = 0;
+
+		// Whether data starts with this codec's header.
+		virtual bool MatchesHeader(const unsigned char* data, size_t size) const = 0;
+
+		// Reads the uncompressed size from the header.  Returns false if the format does not record it.
+		virtual bool GetDecompressedSize(const unsigned char* data, size_t size, uint64_t& decompressedSize) const = 0;
+
+		// Decompresses into a buffer of exactly the uncompressed size.  Returns false if the data is
+		// corrupt or does not fill the buffer exactly.
+		virtual bool DecompressInto(const unsigned char* data, size_t size, unsigned char* dest, size_t destSize) const = 0;
+
+		// Returns NullFile if the data is corrupt.
+		virtual ByteArray Decompress(const unsigned char* data, size_t size) const;
+
+		// Level runs from 0, fastest, to kMaxLevel, smallest.
+		virtual ByteArray Compress(const unsigned char* data, size_t size, int level = kDefaultLevel) const = 0;
+	};
+
+	// Built in and registered by default, in this order, after the block container from
+	// BlockCompression.h.
+	const Codec& GetLZCodec(void);
+	const Codec& GetGzipCodec(void);
+
+	// Adds a codec.  It must outlive every lookup.  Codecs registered earlier are tried first when
+	// looking for a compressed copy of a file.
+	void RegisterCodec(const Codec& codec);
+
+	std::vector<const Codec*> GetCodecs(void);
+	const Codec* FindCodecByName(const char* name);
+	const Codec* FindCodecByExtension(const std::wstring& extension);
+	const Codec* FindCodecByHeader(const unsigned char* data, size_t size);
+
+	// Decompresses data in any registered format, detected from its header.  Returns NullFile if no codec
+	// recognizes it or it is corrupt.
+	ByteArray Decompress(const unsigned char* data, size_t size);
+
+	// The offline side: compresses a file and writes it next to the original with the codec's extension
+	// appended, where ReadFileSync and ReadFileAsync will find it.
+	bool CompressFile(const std::wstring& fileName, const Codec& codec, int level = kMaxLevel);
+}
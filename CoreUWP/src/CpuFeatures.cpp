@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "CpuFeatures.h"
+
+using namespace HolographicEngine::CpuFeatures;
+
+namespace HolographicEngine::CpuFeatures
+{
+	std::atomic<uint32_t> g_DispatchGeneration(0);
+}
+
+namespace
+{
+	const char* s_TierNames[kNumSimdTiers] = { "Scalar", "SSE2", "SSE4.1", "AVX2" };
+
+	struct ProcessorInfo
+	{
+		ProcessorInfo()
+		{
+			memset(Features, 0, sizeof(Features));
+			memset(Brand, 0, sizeof(Brand));
+
+#if defined(_M_IX86) || defined(_M_X64)
+			int Info[4];
+			__cpuid(Info, 0);
+			const int MaxLeaf = Info[0];
+
+			__cpuid(Info, 0x80000000);
+			const unsigned MaxExtendedLeaf = (unsigned)Info[0];
+			if (MaxExtendedLeaf >= 0x80000004)
+			{
+				__cpuid((int*)(Brand + 0), 0x80000002);
+				__cpuid((int*)(Brand + 16), 0x80000003);
+				__cpuid((int*)(Brand + 32), 0x80000004);
+			}
+
+			if (MaxExtendedLeaf >= 0x80000007)
+			{
+				__cpuid(Info, 0x80000007);
+				Features[kFeatureInvariantTSC] = (Info[3] & (1 << 8)) != 0;
+			}
+
+			__cpuid(Info, 1);
+			Features[kFeatureSSE2] = (Info[3] & (1 << 26)) != 0;
+			Features[kFeatureSSE3] = (Info[2] & (1 << 0)) != 0;
+			Features[kFeatureSSSE3] = (Info[2] & (1 << 9)) != 0;
+			Features[kFeatureFMA3] = (Info[2] & (1 << 12)) != 0;
+			Features[kFeatureSSE41] = (Info[2] & (1 << 19)) != 0;
+			Features[kFeatureSSE42] = (Info[2] & (1 << 20)) != 0;
+			Features[kFeaturePOPCNT] = (Info[2] & (1 << 23)) != 0;
+			Features[kFeatureF16C] = (Info[2] & (1 << 29)) != 0;
+
+			// AVX state is only usable if the OS saves the YMM registers on a context switch.
+			const bool OSXSAVE = (Info[2] & (1 << 27)) != 0;
+			const bool YmmEnabled = OSXSAVE && (_xgetbv(0) & 6) == 6;
+			Features[kFeatureAVX] = YmmEnabled && (Info[2] & (1 << 28)) != 0;
+
+			if (!YmmEnabled)
+			{
+				Features[kFeatureFMA3] = false;
+				Features[kFeatureF16C] = false;
+			}
+
+			if (MaxLeaf >= 7)
+			{
+				__cpuidex(Info, 7, 0);
+				Features[kFeatureAVX2] = Features[kFeatureAVX] && (Info[1] & (1 << 5)) != 0;
+				Features[kFeatureBMI1] = (Info[1] & (1 << 3)) != 0;
+				Features[kFeatureBMI2] = (Info[1] & (1 << 8)) != 0;
+			}
+#elif defined(_M_ARM) || defined(_M_ARM64)
+			Features[kFeatureNEON] = true;
+			strcpy_s(Brand, "ARM");
+#endif
+
+			MaxTier = kScalar;
+			if (Features[kFeatureSSE2])
+				MaxTier = kSSE2;
+			if (MaxTier == kSSE2 && Features[kFeatureSSSE3] && Features[kFeatureSSE41])
+				MaxTier = kSSE41;
+			if (MaxTier == kSSE41 && Features[kFeatureAVX2] && Features[kFeatureFMA3])
+				MaxTier = kAVX2;
+		}
+
+		bool Features[kNumFeatures];
+		char Brand[49];
+		SimdTier MaxTier;
+	};
+
+	const ProcessorInfo& GetProcessorInfo(void)
+	{
+		static const ProcessorInfo s_Info;
+		return s_Info;
+	}
+
+	// -1 when no tier is forced.
+	std::atomic<int> s_ForcedTier(-1);
+}
+
+void HolographicEngine::CpuFeatures::Initialize(void)
+{
+	const ProcessorInfo& Info = GetProcessorInfo();
+	Utility::Printf("CPU: %s, dispatching SIMD kernels to %s\n", Info.Brand, s_TierNames[Info.MaxTier]);
+}
+
+bool HolographicEngine::CpuFeatures::Has(Feature feature)
+{
+	return GetProcessorInfo().Features[feature];
+}
+
+const char* HolographicEngine::CpuFeatures::GetBrandString(void)
+{
+	return GetProcessorInfo().Brand;
+}
+
+SimdTier HolographicEngine::CpuFeatures::GetMaxTier(void)
+{
+	return GetProcessorInfo().MaxTier;
+}
+
+SimdTier HolographicEngine::CpuFeatures::GetActiveTier(void)
+{
+	int Forced = s_ForcedTier.load(std::memory_order_relaxed);
+	return Forced < 0 ? GetMaxTier() : (SimdTier)Forced;
+}
+
+bool HolographicEngine::CpuFeatures::ForceTier(SimdTier Tier)
+{
+	if (Tier < kScalar || Tier > GetMaxTier())
+		return false;
+
+	s_ForcedTier.store(Tier, std::memory_order_relaxed);
+	g_DispatchGeneration.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+void HolographicEngine::CpuFeatures::ResetTier(void)
+{
+	s_ForcedTier.store(-1, std::memory_order_relaxed);
+	g_DispatchGeneration.fetch_add(1, std::memory_order_release);
+}
+
+const char* HolographicEngine::CpuFeatures::GetTierName(SimdTier Tier)
+{
+	return Tier >= kScalar && Tier < kNumSimdTiers ? s_TierNames[Tier] : "Unknown";
+}
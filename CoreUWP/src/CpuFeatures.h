@@ -0,0 +1,116 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <atomic>
+
+namespace HolographicEngine::CpuFeatures
+{
+	// Instruction set levels that kernels are written against, in increasing order.  A tier implies
+	// every tier below it.
+	enum SimdTier
+	{
+		kScalar,
+		kSSE2,
+		kSSE41,    // Also requires SSSE3
+		kAVX2,     // Also requires AVX, FMA3 and OS support for the YMM state
+
+		kNumSimdTiers
+	};
+
+	enum Feature
+	{
+		kFeatureSSE2,
+		kFeatureSSE3,
+		kFeatureSSSE3,
+		kFeatureSSE41,
+		kFeatureSSE42,
+		kFeaturePOPCNT,
+		kFeatureAVX,
+		kFeatureF16C,
+		kFeatureFMA3,
+		kFeatureAVX2,
+		kFeatureBMI1,
+		kFeatureBMI2,
+		kFeatureNEON,
+		kFeatureInvariantTSC,    // The time stamp counter ticks at a constant rate in every power state
+
+		kNumFeatures
+	};
+
+	// Probes the CPU.  Called once at startup by the engine; every query below also initializes on
+	// demand, so kernels are safe to use from static initializers.
+	void Initialize(void);
+
+	bool Has(Feature feature);
+	const char* GetBrandString(void);
+
+	// The best tier this CPU supports.
+	SimdTier GetMaxTier(void);
+
+	// The tier kernels are currently dispatched to.  Equal to GetMaxTier() unless a lower tier is forced.
+	SimdTier GetActiveTier(void);
+
+	// Forces dispatch down to Tier, so tests and benchmarks can exercise every path on one machine.
+	// Returns false, changing nothing, if the CPU does not support the tier.
+	bool ForceTier(SimdTier Tier);
+	void ResetTier(void);
+
+	const char* GetTierName(SimdTier Tier);
+
+	// Incremented whenever the active tier changes, so dispatch tables know to re-resolve.
+	extern std::atomic<uint32_t> g_DispatchGeneration;
+
+	// One implementation per tier of a kernel with the signature Function.  Get() returns the best
+	// implementation at or below the active tier.  The resolved pointer is cached, so a call costs one
+	// extra load and compare over a direct call.
+	//
+	//    static CpuFeatures::DispatchTable<CopyFn> s_Copy(CopyScalar, CopySSE2, nullptr, CopyAVX2);
+	//    s_Copy.Get()(Dest, Source, NumBytes);
+	template <typename Function>
+	class DispatchTable
+	{
+	public:
+		// Constant initialized, so tables at namespace scope are usable before dynamic initialization.
+		// Every kernel needs a scalar fallback.
+		constexpr DispatchTable(Function Scalar, Function SSE2 = nullptr, Function SSE41 = nullptr, Function AVX2 = nullptr)
+			: m_Implementations{ Scalar, SSE2, SSE41, AVX2 }, m_Resolved(nullptr), m_Generation(~0u)
+		{
+		}
+
+		Function Get(void)
+		{
+			const uint32_t Generation = g_DispatchGeneration.load(std::memory_order_acquire);
+			if (m_Generation.load(std::memory_order_acquire) != Generation)
+			{
+				m_Resolved.store(Resolve(GetActiveTier()), std::memory_order_relaxed);
+				m_Generation.store(Generation, std::memory_order_release);
+			}
+
+			return m_Resolved.load(std::memory_order_relaxed);
+		}
+
+		// The implementation a given tier would use, regardless of the active tier.
+		Function Resolve(SimdTier Tier) const
+		{
+			for (int t = Tier; t > kScalar; --t)
+			{
+				if (m_Implementations[t] != nullptr)
+					return m_Implementations[t];
+			}
+
+			return m_Implementations[kScalar];
+		}
+
+	private:
+
+		Function m_Implementations[kNumSimdTiers];
+		std::atomic<Function> m_Resolved;
+		std::atomic<uint32_t> m_Generation;
+	};
+}
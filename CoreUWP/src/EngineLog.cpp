@@ -0,0 +1,597 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "EngineLog.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace HolographicEngine::EngineLog::Detail;
+
+namespace
+{
+	// Single-producer, single-consumer byte ring.  The owning thread appends whole records at m_Head and the
+	// background thread consumes them from m_Tail.  Both only ever increase; positions wrap by masking.
+	class Ring
+	{
+	public:
+		static const size_t kCapacity = 64 * 1024;
+
+		Ring() : m_Head(0), m_Tail(0), m_Retired(false) {}
+
+		void CopyIn(uint64_t Position, const void* Source, size_t NumBytes)
+		{
+			const size_t Offset = (size_t)(Position & (kCapacity - 1));
+			const size_t FirstPart = min(NumBytes, kCapacity - Offset);
+			memcpy(m_Buffer + Offset, Source, FirstPart);
+			memcpy(m_Buffer, (const char*)Source + FirstPart, NumBytes - FirstPart);
+		}
+
+		void CopyOut(uint64_t Position, void* Dest, size_t NumBytes) const
+		{
+			const size_t Offset = (size_t)(Position & (kCapacity - 1));
+			const size_t FirstPart = min(NumBytes, kCapacity - Offset);
+			memcpy(Dest, m_Buffer + Offset, FirstPart);
+			memcpy((char*)Dest + FirstPart, m_Buffer, NumBytes - FirstPart);
+		}
+
+		// Written by the producer, read by the consumer.  Kept on separate cache lines so that neither
+		// side's stores invalidate the other's loads.
+		alignas(64) std::atomic<uint64_t> m_Head;
+		alignas(64) std::atomic<uint64_t> m_Tail;
+
+		// Set when the owning thread exits.  The ring is freed once it has been drained.
+		std::atomic<bool> m_Retired;
+
+		alignas(64) char m_Buffer[kCapacity];
+	};
+
+	// Set once the calling thread's ring has been retired.  A plain bool, so it stays readable from
+	// thread_local destructors that run after t_RingOwner's.
+	thread_local bool t_RingRetired = false;
+
+	// Retires the calling thread's ring when the thread exits.  The background thread frees it once it is
+	// drained, so anything the thread logs after this is written synchronously.
+	struct RingOwner
+	{
+		~RingOwner()
+		{
+			if (m_Ring != nullptr)
+				m_Ring->m_Retired.store(true, std::memory_order_release);
+
+			m_Ring = nullptr;
+			t_RingRetired = true;
+		}
+
+		Ring* m_Ring = nullptr;
+	};
+
+	thread_local RingOwner t_RingOwner;
+
+	std::mutex s_RingsMutex;
+	std::vector<std::unique_ptr<Ring>> s_Rings;
+
+	std::atomic<uint64_t> s_Sequence(0);
+	std::atomic<uint64_t> s_StallCount(0);
+
+	// Background thread state.  The two uint64_t counters are only touched under s_Mutex.
+	std::atomic<bool> s_Running(false);
+	std::thread s_Thread;
+	thread_local bool t_IsLogThread = false;
+	std::mutex s_Mutex;
+	std::condition_variable s_WakeCondition;
+	std::condition_variable s_FlushCondition;
+	uint64_t s_FlushRequested = 0;
+	uint64_t s_FlushCompleted = 0;
+	bool s_ThreadAlive = false;
+
+	// Serializes writes to the console, which come from the background thread or, when it is not running,
+	// from whichever thread is logging.
+	std::mutex s_OutputMutex;
+
+	// Null once the thread has started exiting.
+	Ring* GetThreadRing(void)
+	{
+		if (t_RingRetired)
+			return nullptr;
+
+		Ring* ring = t_RingOwner.m_Ring;
+		if (ring == nullptr)
+		{
+			ring = new Ring;
+			std::lock_guard<std::mutex> guard(s_RingsMutex);
+			s_Rings.emplace_back(ring);
+			t_RingOwner.m_Ring = ring;
+		}
+
+		return ring;
+	}
+
+	void WriteOutput(const std::string& Text)
+	{
+		if (Text.empty())
+			return;
+
+		std::lock_guard<std::mutex> guard(s_OutputMutex);
+		fwrite(Text.data(), 1, Text.size(), stdout);
+		fflush(stdout);
+	}
+
+	void AppendWide(std::string& Out, const wchar_t* Text, size_t Length)
+	{
+		if (Length == 0)
+			return;
+
+		const int NumBytes = WideCharToMultiByte(CP_UTF8, 0, Text, (int)Length, nullptr, 0, nullptr, nullptr);
+		const size_t Start = Out.size();
+		Out.resize(Start + NumBytes);
+		WideCharToMultiByte(CP_UTF8, 0, Text, (int)Length, &Out[Start], NumBytes, nullptr, nullptr);
+	}
+
+	// Walks the arguments that follow a record header.
+	class ArgReader
+	{
+	public:
+		ArgReader(const char* Args, uint32_t NumArgs) : m_Next(Args), m_NumLeft(NumArgs) {}
+
+		bool Next(ArgType& Type)
+		{
+			if (m_NumLeft == 0)
+				return false;
+
+			--m_NumLeft;
+			Type = (ArgType)*m_Next++;
+			return true;
+		}
+
+		template <typename T>
+		T Scalar(void)
+		{
+			T Value;
+			memcpy(&Value, m_Next, sizeof(T));
+			m_Next += sizeof(uint64_t);
+			return Value;
+		}
+
+		// Returns the characters and sets Length to their count.  The data may not be aligned.
+		const char* String(uint32_t& Length, size_t CharSize)
+		{
+			memcpy(&Length, m_Next, sizeof(Length));
+			const char* Data = m_Next + sizeof(Length);
+			m_Next += sizeof(Length) + Length * CharSize;
+			return Data;
+		}
+
+	private:
+		const char* m_Next;
+		uint32_t m_NumLeft;
+	};
+
+	template <typename T>
+	void AppendFormatted(std::string& Out, const char* Spec, T Value)
+	{
+		// Almost everything fits in the stack buffer, which saves formatting twice.
+		char Buffer[128];
+		const int Length = snprintf(Buffer, sizeof(Buffer), Spec, Value);
+		if (Length <= 0)
+			return;
+
+		if (Length < (int)sizeof(Buffer))
+		{
+			Out.append(Buffer, Length);
+			return;
+		}
+
+		const size_t Start = Out.size();
+		Out.resize(Start + Length + 1);
+		snprintf(&Out[Start], Length + 1, Spec, Value);
+		Out.resize(Start + Length);
+	}
+
+	// Formats one argument with a printf conversion.  Spec holds the flags, width and precision without a
+	// length modifier; the modifier is chosen here from the type the argument was recorded with, so a
+	// mismatch between the format string and the arguments cannot read past the record.  Only an "h" or
+	// "hh" from the format string is kept, since it narrows an int rather than widening what is read.
+	void AppendArgument(std::string& Out, std::string& Spec, const char* Narrowing, char Conversion, ArgType Type, ArgReader& Reader)
+	{
+		const size_t SpecLength = Spec.size();
+		const bool IsFloatConversion = strchr("eEfFgGaA", Conversion) != nullptr;
+
+		switch (Type)
+		{
+		case kArgInt:
+		case kArgUInt:
+		case kArgInt32:
+		case kArgUInt32:
+		{
+			const uint64_t Bits = Reader.Scalar<uint64_t>();
+			const bool IsSigned = Type == kArgInt || Type == kArgInt32;
+			const char IntConversion = strchr("diouxX", Conversion) != nullptr ? Conversion : (IsSigned ? 'd' : 'u');
+			if (IsFloatConversion)
+			{
+				Spec += Conversion;
+				AppendFormatted(Out, Spec.c_str(), IsSigned ? (double)(int64_t)Bits : (double)Bits);
+			}
+			else if (Conversion == 'c')
+			{
+				Spec += 'c';
+				AppendFormatted(Out, Spec.c_str(), (int)Bits);
+			}
+			else if (Type == kArgInt32 || Type == kArgUInt32)
+			{
+				// As printf would have read an int: %d of an unsigned is negative, %x of a negative is 32 bits.
+				Spec += Narrowing;
+				Spec += IntConversion;
+				if (IntConversion == 'd' || IntConversion == 'i')
+					AppendFormatted(Out, Spec.c_str(), (int32_t)(uint32_t)Bits);
+				else
+					AppendFormatted(Out, Spec.c_str(), (uint32_t)Bits);
+			}
+			else
+			{
+				Spec += "ll";
+				Spec += IntConversion;
+				AppendFormatted(Out, Spec.c_str(), Bits);
+			}
+			break;
+		}
+
+		case kArgDouble:
+		{
+			const double Value = Reader.Scalar<double>();
+			Spec += IsFloatConversion ? Conversion : 'g';
+			AppendFormatted(Out, Spec.c_str(), Value);
+			break;
+		}
+
+		case kArgPointer:
+		{
+			const uint64_t Bits = Reader.Scalar<uint64_t>();
+			if (Conversion == 'p')
+			{
+				Spec += 'p';
+				AppendFormatted(Out, Spec.c_str(), (void*)(uintptr_t)Bits);
+			}
+			else
+			{
+				Spec += "ll";
+				Spec += strchr("diouxX", Conversion) != nullptr ? Conversion : 'x';
+				AppendFormatted(Out, Spec.c_str(), Bits);
+			}
+			break;
+		}
+
+		case kArgString:
+		case kArgWideString:
+		{
+			uint32_t Length;
+			const char* Data = Reader.String(Length, Type == kArgString ? 1 : sizeof(wchar_t));
+
+			std::string Text;
+			if (Type == kArgString)
+			{
+				Text.assign(Data, Length);
+			}
+			else
+			{
+				std::wstring Wide(Length, L'\0');
+				memcpy(&Wide[0], Data, Length * sizeof(wchar_t));
+				AppendWide(Text, Wide.c_str(), Wide.size());
+			}
+
+			// Width and precision still apply, so %-20s and %.3s behave as usual.
+			Spec += 's';
+			AppendFormatted(Out, Spec.c_str(), Text.c_str());
+			break;
+		}
+		}
+
+		Spec.resize(SpecLength);
+	}
+
+	void FormatRecord(const char* Record, std::string& Out)
+	{
+		const RecordHeader& Header = *(const RecordHeader*)Record;
+		ArgReader Reader(Record + sizeof(RecordHeader), Header.NumArgs);
+		ArgType Type;
+
+		// A bare string, from WriteString.
+		if (Header.Format == nullptr)
+		{
+			std::string Spec = "%";
+			while (Reader.Next(Type))
+				AppendArgument(Out, Spec, "", 's', Type, Reader);
+			return;
+		}
+
+		std::string Spec;
+		const char* p = Header.Format;
+
+		while (*p != '\0')
+		{
+			const char* Percent = strchr(p, '%');
+			if (Percent == nullptr)
+			{
+				Out += p;
+				break;
+			}
+
+			Out.append(p, Percent - p);
+			p = Percent + 1;
+
+			if (*p == '%')
+			{
+				Out += '%';
+				++p;
+				continue;
+			}
+
+			Spec = "%";
+
+			while (*p != '\0' && strchr("-+ #0", *p) != nullptr)
+				Spec += *p++;
+
+			// Width and precision.  A '*' takes its value from the next argument.
+			for (int Field = 0; Field < 2; ++Field)
+			{
+				if (Field == 1)
+				{
+					if (*p != '.')
+						break;
+					Spec += *p++;
+				}
+
+				if (*p == '*')
+				{
+					++p;
+					if (Reader.Next(Type) && (Type == kArgInt || Type == kArgUInt || Type == kArgInt32 || Type == kArgUInt32))
+						Spec += std::to_string((int)Reader.Scalar<int64_t>());
+				}
+				else
+				{
+					while (*p >= '0' && *p <= '9')
+						Spec += *p++;
+				}
+			}
+
+			// Length modifiers, including Microsoft's w, I, I32 and I64, are implied by the recorded types.
+			const char* Narrowing = "";
+			if (p[0] == 'h')
+				Narrowing = p[1] == 'h' ? "hh" : "h";
+
+			while (*p != '\0' && strchr("hlLqjztwI", *p) != nullptr)
+			{
+				if (*p == 'I' && ((p[1] == '3' && p[2] == '2') || (p[1] == '6' && p[2] == '4')))
+					p += 2;
+				++p;
+			}
+
+			if (*p == '\0')
+				break;
+
+			const char Conversion = *p++;
+			if (Conversion == 'n')
+				continue;
+
+			if (Reader.Next(Type))
+				AppendArgument(Out, Spec, Narrowing, Conversion, Type, Reader);
+			else
+				Out += Spec + Conversion;
+		}
+	}
+
+	// Moves every complete record out of the rings, formats them in the order they were written, and
+	// writes the result.  Rings of threads that have exited are freed once empty.
+	void Drain(std::vector<std::pair<uint64_t, std::string>>& Pending, std::vector<char>& Scratch)
+	{
+		std::vector<Ring*> Rings;
+		{
+			std::lock_guard<std::mutex> guard(s_RingsMutex);
+
+			s_Rings.erase(std::remove_if(s_Rings.begin(), s_Rings.end(), [](const std::unique_ptr<Ring>& ring)
+			{
+				return ring->m_Retired.load(std::memory_order_acquire) &&
+					ring->m_Tail.load(std::memory_order_relaxed) == ring->m_Head.load(std::memory_order_acquire);
+			}), s_Rings.end());
+
+			for (auto& ring : s_Rings)
+				Rings.push_back(ring.get());
+		}
+
+		for (Ring* ring : Rings)
+		{
+			const uint64_t Head = ring->m_Head.load(std::memory_order_acquire);
+			uint64_t Tail = ring->m_Tail.load(std::memory_order_relaxed);
+
+			while (Tail != Head)
+			{
+				RecordHeader Header;
+				ring->CopyOut(Tail, &Header, sizeof(Header));
+
+				Scratch.resize(Header.Size);
+				ring->CopyOut(Tail, Scratch.data(), Header.Size);
+
+				// Give the space back before formatting so that the producer stalls as little as possible.
+				Tail += Header.Size;
+				ring->m_Tail.store(Tail, std::memory_order_release);
+
+				Pending.emplace_back(Header.Sequence, std::string());
+				FormatRecord(Scratch.data(), Pending.back().second);
+			}
+		}
+
+		if (Pending.empty())
+			return;
+
+		std::sort(Pending.begin(), Pending.end(), [](const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b)
+		{
+			return a.first < b.first;
+		});
+
+		std::string Text;
+		for (auto& Entry : Pending)
+			Text += Entry.second;
+
+		Pending.clear();
+		WriteOutput(Text);
+	}
+
+	void LogThreadMain(void)
+	{
+		t_IsLogThread = true;
+
+		std::vector<std::pair<uint64_t, std::string>> Pending;
+		std::vector<char> Scratch;
+
+		for (;;)
+		{
+			uint64_t FlushTarget;
+			bool Stopping;
+			{
+				// Producers only signal when a ring is half full, so also wake up periodically to keep
+				// latency low for light logging.
+				std::unique_lock<std::mutex> lock(s_Mutex);
+				s_WakeCondition.wait_for(lock, std::chrono::milliseconds(5), []
+				{
+					return s_FlushRequested != s_FlushCompleted || !s_Running.load(std::memory_order_relaxed);
+				});
+
+				FlushTarget = s_FlushRequested;
+				Stopping = !s_Running.load(std::memory_order_relaxed);
+			}
+
+			Drain(Pending, Scratch);
+
+			{
+				std::lock_guard<std::mutex> guard(s_Mutex);
+				s_FlushCompleted = FlushTarget;
+				if (Stopping)
+					s_ThreadAlive = false;
+			}
+			s_FlushCondition.notify_all();
+
+			if (Stopping)
+				break;
+		}
+	}
+
+	void WriteSynchronous(const char* Record)
+	{
+		std::string Text;
+		FormatRecord(Record, Text);
+		WriteOutput(Text);
+	}
+}
+
+void HolographicEngine::EngineLog::Initialize(void)
+{
+	std::lock_guard<std::mutex> guard(s_Mutex);
+	if (s_ThreadAlive)
+		return;
+
+	s_ThreadAlive = true;
+	s_Running.store(true, std::memory_order_release);
+	s_Thread = std::thread(LogThreadMain);
+}
+
+// Anything written concurrently with Shutdown() may be lost; call it once the other engine threads are done.
+void HolographicEngine::EngineLog::Shutdown(void)
+{
+	{
+		std::lock_guard<std::mutex> guard(s_Mutex);
+		if (!s_Running.load(std::memory_order_relaxed))
+			return;
+
+		s_Running.store(false, std::memory_order_release);
+	}
+
+	s_WakeCondition.notify_one();
+	s_Thread.join();
+}
+
+void HolographicEngine::EngineLog::Flush(void)
+{
+	if (!s_Running.load(std::memory_order_acquire) || t_IsLogThread)
+		return;
+
+	std::unique_lock<std::mutex> lock(s_Mutex);
+	const uint64_t Target = ++s_FlushRequested;
+	s_WakeCondition.notify_one();
+	s_FlushCondition.wait(lock, [Target] { return s_FlushCompleted >= Target || !s_ThreadAlive; });
+}
+
+void HolographicEngine::EngineLog::WriteString(const char* Message)
+{
+	Write(nullptr, Message);
+}
+
+void HolographicEngine::EngineLog::WriteString(const wchar_t* Message)
+{
+	Write(nullptr, Message);
+}
+
+uint64_t HolographicEngine::EngineLog::GetMessageCount(void)
+{
+	return s_Sequence.load(std::memory_order_relaxed);
+}
+
+uint64_t HolographicEngine::EngineLog::GetStallCount(void)
+{
+	return s_StallCount.load(std::memory_order_relaxed);
+}
+
+void HolographicEngine::EngineLog::Detail::Submit(void* Record, size_t Size)
+{
+	RecordHeader* Header = (RecordHeader*)Record;
+	Header->Sequence = s_Sequence.fetch_add(1, std::memory_order_relaxed);
+
+	// Records too big for a ring are rare enough to write directly, once everything before them is out.
+	if (!s_Running.load(std::memory_order_acquire) || Size > Ring::kCapacity / 4)
+	{
+		Flush();
+		WriteSynchronous((const char*)Record);
+		return;
+	}
+
+	Ring* ring = GetThreadRing();
+	if (ring == nullptr)
+	{
+		Flush();
+		WriteSynchronous((const char*)Record);
+		return;
+	}
+
+	const uint64_t Head = ring->m_Head.load(std::memory_order_relaxed);
+	uint64_t Tail = ring->m_Tail.load(std::memory_order_acquire);
+
+	if (Ring::kCapacity - (Head - Tail) < Size)
+	{
+		s_StallCount.fetch_add(1, std::memory_order_relaxed);
+		s_WakeCondition.notify_one();
+
+		do
+		{
+			if (!s_Running.load(std::memory_order_acquire))
+			{
+				WriteSynchronous((const char*)Record);
+				return;
+			}
+
+			std::this_thread::yield();
+			Tail = ring->m_Tail.load(std::memory_order_acquire);
+		} while (Ring::kCapacity - (Head - Tail) < Size);
+	}
+
+	ring->CopyIn(Head, Record, Size);
+	ring->m_Head.store(Head + Size, std::memory_order_release);
+
+	if (Head + Size - Tail > Ring::kCapacity / 2)
+		s_WakeCondition.notify_one();
+}
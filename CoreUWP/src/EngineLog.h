@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+// Asynchronous console output behind Utility::Print, Utility::Printf and DEBUGPRINT.
+//
+// A call copies the format string pointer and the raw arguments into a ring buffer owned by the calling
+// thread, and a background thread formats and writes them later.  Nothing is truncated.  Because only the
+// pointer is kept, the format string must outlive the call, which string literals do.  String arguments
+// are copied, so they do not need to.
+//
+// Messages from one thread come out in the order they were written, and the background thread sorts
+// what it collects from all threads by when it was written.  A message written while the background
+// thread is collecting may still come out after ones other threads wrote just after it.  Until
+// Initialize() and after Shutdown(), and on a thread that is exiting, output is formatted and written on
+// the calling thread, as before.
+
+namespace HolographicEngine::EngineLog
+{
+	void Initialize(void);
+	void Shutdown(void);
+
+	// Blocks until everything written before the call has reached the console.  Call it before
+	// __debugbreak() or anything else that needs the output to be visible.
+	void Flush(void);
+
+	template <typename... Args>
+	void Write(const char* Format, const Args&... args);
+
+	// Writes a string as is.  It is copied, so the caller may free it when this returns.
+	void WriteString(const char* Message);
+	void WriteString(const wchar_t* Message);
+
+	// Messages written so far, and how many times a producer had to wait for the background thread
+	// because its ring buffer was full.
+	uint64_t GetMessageCount(void);
+	uint64_t GetStallCount(void);
+
+	namespace Detail
+	{
+		enum ArgType : uint8_t
+		{
+			kArgInt,
+			kArgUInt,
+			kArgInt32,         // Passed to printf as an int; the 64-bit slot holds it sign-extended
+			kArgUInt32,
+			kArgDouble,
+			kArgPointer,
+			kArgString,        // uint32_t length then the characters
+			kArgWideString,    // uint32_t length in wchar_t then the characters
+		};
+
+		// Every record starts with this.  A null Format means the record is a single string to write as is.
+		struct RecordHeader
+		{
+			uint32_t Size;
+			uint32_t NumArgs;
+			uint64_t Sequence;
+			const char* Format;
+		};
+
+		// Records up to this size are encoded on the stack.
+		const size_t kInlineRecordSize = 512;
+
+		// Stamps the record and hands it to the background thread, or formats it immediately if there is none.
+		void Submit(void* Record, size_t Size);
+
+		template <typename T>
+		struct IsCharPointer : std::integral_constant<bool, std::is_pointer<T>::value &&
+			(std::is_same<typename std::remove_cv<typename std::remove_pointer<T>::type>::type, char>::value ||
+			std::is_same<typename std::remove_cv<typename std::remove_pointer<T>::type>::type, wchar_t>::value)>
+		{
+		};
+
+		inline const char* NullSafe(const char* s) { return s ? s : "(null)"; }
+		inline const wchar_t* NullSafe(const wchar_t* s) { return s ? s : L"(null)"; }
+
+		class Encoder
+		{
+		public:
+			explicit Encoder(char* Dest) : m_Dest(Dest) {}
+
+			template <typename T>
+			typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type Put(const T& Value)
+			{
+				// Keep the size printf would see, so that %x of a negative int or HRESULT prints 32 bits.
+				if (sizeof(T) <= sizeof(int32_t))
+				{
+					if (std::is_signed<T>::value)
+						PutScalar(kArgInt32, (int64_t)Value);
+					else
+						PutScalar(kArgUInt32, (uint64_t)(uint32_t)Value);
+				}
+				else if (std::is_signed<T>::value)
+				{
+					PutScalar(kArgInt, (int64_t)Value);
+				}
+				else
+				{
+					PutScalar(kArgUInt, (uint64_t)Value);
+				}
+			}
+
+			template <typename T>
+			typename std::enable_if<std::is_floating_point<T>::value>::type Put(const T& Value)
+			{
+				PutScalar(kArgDouble, (double)Value);
+			}
+
+			template <typename T>
+			typename std::enable_if<std::is_pointer<T>::value && !IsCharPointer<T>::value>::type Put(const T& Value)
+			{
+				PutScalar(kArgPointer, (uint64_t)(uintptr_t)Value);
+			}
+
+			void Put(const char* Value) { PutString(kArgString, NullSafe(Value), strlen(NullSafe(Value))); }
+			void Put(const wchar_t* Value) { PutString(kArgWideString, NullSafe(Value), wcslen(NullSafe(Value)) * sizeof(wchar_t)); }
+			void Put(const std::string& Value) { PutString(kArgString, Value.c_str(), Value.size()); }
+			void Put(const std::wstring& Value) { PutString(kArgWideString, Value.c_str(), Value.size() * sizeof(wchar_t)); }
+
+			template <typename T>
+			static typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+				(std::is_pointer<T>::value && !IsCharPointer<T>::value), size_t>::type SizeOf(const T&)
+			{
+				return 1 + sizeof(uint64_t);
+			}
+
+			static size_t SizeOf(const char* Value) { return 1 + sizeof(uint32_t) + strlen(NullSafe(Value)); }
+			static size_t SizeOf(const wchar_t* Value) { return 1 + sizeof(uint32_t) + wcslen(NullSafe(Value)) * sizeof(wchar_t); }
+			static size_t SizeOf(const std::string& Value) { return 1 + sizeof(uint32_t) + Value.size(); }
+			static size_t SizeOf(const std::wstring& Value) { return 1 + sizeof(uint32_t) + Value.size() * sizeof(wchar_t); }
+
+		private:
+			template <typename T>
+			void PutScalar(ArgType Type, T Value)
+			{
+				*m_Dest++ = (char)Type;
+				memcpy(m_Dest, &Value, sizeof(Value));
+				m_Dest += sizeof(Value);
+			}
+
+			void PutString(ArgType Type, const void* Data, size_t NumBytes)
+			{
+				*m_Dest++ = (char)Type;
+				uint32_t Length = (uint32_t)(Type == kArgWideString ? NumBytes / sizeof(wchar_t) : NumBytes);
+				memcpy(m_Dest, &Length, sizeof(Length));
+				memcpy(m_Dest + sizeof(Length), Data, NumBytes);
+				m_Dest += sizeof(Length) + NumBytes;
+			}
+
+			char* m_Dest;
+		};
+
+		// Records are kept 8-byte aligned in the ring.
+		template <typename... Args>
+		size_t RecordSize(const Args&... args)
+		{
+			size_t Size = sizeof(RecordHeader);
+			using Expand = int[];
+			(void)Expand{ 0, (Size += Encoder::SizeOf(args), 0)... };
+			return (Size + 7) & ~(size_t)7;
+		}
+
+		template <typename... Args>
+		void Encode(char* Record, size_t Size, const char* Format, const Args&... args)
+		{
+			RecordHeader* Header = (RecordHeader*)Record;
+			Header->Size = (uint32_t)Size;
+			Header->NumArgs = (uint32_t)sizeof...(args);
+			Header->Sequence = 0;
+			Header->Format = Format;
+
+			Encoder encoder(Record + sizeof(RecordHeader));
+			using Expand = int[];
+			(void)Expand{ 0, (encoder.Put(args), 0)... };
+		}
+	}
+
+	template <typename... Args>
+	void Write(const char* Format, const Args&... args)
+	{
+		const size_t Size = Detail::RecordSize(args...);
+
+		if (Size <= Detail::kInlineRecordSize)
+		{
+			alignas(8) char Record[Detail::kInlineRecordSize];
+			Detail::Encode(Record, Size, Format, args...);
+			Detail::Submit(Record, Size);
+		}
+		else
+		{
+			std::unique_ptr<uint64_t[]> Record(new uint64_t[Size / sizeof(uint64_t)]);
+			Detail::Encode((char*)Record.get(), Size, Format, args...);
+			Detail::Submit(Record.get(), Size);
+		}
+	}
+}
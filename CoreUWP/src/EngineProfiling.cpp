@@ -0,0 +1,693 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "EngineProfiling.h"
+#include "EngineTuning.h"
+#include "FileUtility.h"
+#include "FrameCounters.h"
+#include "FrameStats.h"
+#include "InstrumentedMutex.h"
+#include "MemoryTracking.h"
+#include "SystemTime.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::EngineProfiling;
+
+namespace
+{
+	const char* kTraceName = "ProfileTrace.json";
+	const uint32_t kNoNode = ~0u;
+
+	// A null name marks the end of the innermost scope.
+	struct Event
+	{
+		int64_t Tick;
+		const char* Name;
+	};
+
+	struct OpenScope
+	{
+		uint32_t Node;
+		int64_t BeginTick;
+	};
+
+	// Written only by its thread and read only by Update, so the two indices are all the synchronization
+	// it needs.
+	struct ThreadBuffer
+	{
+		Event Events[kEventsPerThread];
+		std::atomic<uint32_t> Head = 0;
+		std::atomic<uint32_t> Tail = 0;
+		uint32_t Index = 0;
+
+		// Set when the thread exits.  Once Update has drained what it recorded, the buffer and its index
+		// go to the next new thread.
+		std::atomic<bool> Exited = false;
+
+		// Owned by the thread.  Every recorded scope that has not ended yet needs a slot kept free for its
+		// end, and every scope inside a dropped one is dropped too.
+		uint32_t OpenDepth = 0;
+		uint32_t SkipDepth = 0;
+
+		// Owned by Update.
+		uint32_t Root = kNoNode;
+		std::vector<OpenScope> Open;
+	};
+
+	struct Node
+	{
+		const char* Name;
+		uint32_t Parent;
+		uint32_t Thread;
+		uint32_t Depth;
+		std::vector<uint32_t> Children;
+
+		// Accumulated during the frame being collected.
+		uint32_t FrameCalls = 0;
+		int64_t FrameTicks = 0;
+		int64_t FrameChildTicks = 0;
+
+		// The last frame.
+		uint32_t Calls = 0;
+		double InclusiveMs = 0.0;
+		double ExclusiveMs = 0.0;
+		double AverageMs = 0.0;
+		double MaxMs = 0.0;
+		bool HasAverage = false;
+	};
+
+	struct Span
+	{
+		const char* Name;
+		uint32_t Thread;
+		int64_t BeginTick;
+		int64_t EndTick;
+	};
+
+	// Where each collected frame ended, and where its spans start among every span ever kept.
+	struct FrameMark
+	{
+		uint64_t Index;
+		int64_t EndTick;
+		uint64_t FirstSpan;
+	};
+
+	struct CounterEntry
+	{
+		const char* Name;
+
+		// Accumulated during the frame being collected.
+		uint32_t FrameCalls;
+		uint64_t FrameItems;
+		int64_t FrameTicks;
+		HardwareCounters::Sample FrameCounts;
+
+		CounterStats Last;
+	};
+
+	struct Profiler
+	{
+		// Held only to add or retire a thread.
+		std::mutex ThreadsMutex;
+		std::vector<ThreadBuffer*> Threads;
+		std::vector<ThreadBuffer*> FreeBuffers;
+
+		// Everything below belongs to Update and the queries.
+		std::mutex Mutex;
+		std::vector<Node> Nodes;
+		std::deque<Span> Spans;
+		std::deque<FrameMark> Marks;
+		uint64_t TotalSpans = 0;
+		uint64_t FrameIndex = 0;
+		uint32_t TraceFrames = kDefaultTraceFrames;
+
+		std::atomic<uint64_t> Dropped = 0;
+
+		// Counter scopes end on any thread, so they are summed under their own lock.
+		std::mutex CountersMutex;
+		std::vector<CounterEntry> Counters;
+	};
+
+	BoolVar s_HardwareCounters("Profiling/Hardware Counters", false);
+	std::atomic<int> s_CountersSuspended = 0;
+
+	Profiler& GetProfiler(void)
+	{
+		static Profiler s_Profiler;
+		return s_Profiler;
+	}
+
+	// Flags the thread's buffer for reuse when the thread exits.
+	struct BufferOwner
+	{
+		~BufferOwner()
+		{
+			if (Buffer != nullptr)
+				Buffer->Exited.store(true, std::memory_order_release);
+		}
+
+		ThreadBuffer* Buffer = nullptr;
+	};
+
+	thread_local BufferOwner t_Owner;
+
+	ThreadBuffer& GetThreadBuffer(void)
+	{
+		if (t_Owner.Buffer == nullptr)
+		{
+			Profiler& p = GetProfiler();
+			std::lock_guard<std::mutex> guard(p.ThreadsMutex);
+
+			if (!p.FreeBuffers.empty())
+			{
+				t_Owner.Buffer = p.FreeBuffers.back();
+				p.FreeBuffers.pop_back();
+			}
+			else
+			{
+				t_Owner.Buffer = new ThreadBuffer;
+				t_Owner.Buffer->Index = (uint32_t)p.Threads.size();
+				p.Threads.push_back(t_Owner.Buffer);
+			}
+		}
+
+		return *t_Owner.Buffer;
+	}
+
+	void Push(ThreadBuffer& Buffer, const char* Name)
+	{
+		const uint32_t Head = Buffer.Head.load(std::memory_order_relaxed);
+		Buffer.Events[Head % kEventsPerThread] = { SystemTime::GetCurrentTick(), Name };
+		Buffer.Head.store(Head + 1, std::memory_order_release);
+	}
+
+	uint32_t AddNode(Profiler& p, const char* Name, uint32_t Parent, uint32_t Thread)
+	{
+		Node NewNode;
+		NewNode.Name = Name;
+		NewNode.Parent = Parent;
+		NewNode.Thread = Thread;
+		NewNode.Depth = Parent == kNoNode ? 0 : p.Nodes[Parent].Depth + 1;
+
+		const uint32_t Index = (uint32_t)p.Nodes.size();
+		p.Nodes.push_back(std::move(NewNode));
+		if (Parent != kNoNode)
+			p.Nodes[Parent].Children.push_back(Index);
+		return Index;
+	}
+
+	// The same literal may have a different address in each translation unit, hence the string compare.
+	uint32_t FindChild(Profiler& p, uint32_t Parent, const char* Name)
+	{
+		for (uint32_t Child : p.Nodes[Parent].Children)
+		{
+			const char* ChildName = p.Nodes[Child].Name;
+			if (ChildName == Name || strcmp(ChildName, Name) == 0)
+				return Child;
+		}
+
+		return AddNode(p, Name, Parent, p.Nodes[Parent].Thread);
+	}
+
+	void Drain(Profiler& p, ThreadBuffer& Buffer)
+	{
+		if (Buffer.Root == kNoNode)
+			Buffer.Root = AddNode(p, nullptr, kNoNode, Buffer.Index);
+
+		const uint32_t Head = Buffer.Head.load(std::memory_order_acquire);
+		uint32_t Tail = Buffer.Tail.load(std::memory_order_relaxed);
+
+		for (; Tail != Head; ++Tail)
+		{
+			const Event& e = Buffer.Events[Tail % kEventsPerThread];
+
+			if (e.Name != nullptr)
+			{
+				const uint32_t Parent = Buffer.Open.empty() ? Buffer.Root : Buffer.Open.back().Node;
+				Buffer.Open.push_back({ FindChild(p, Parent, e.Name), e.Tick });
+				continue;
+			}
+
+			if (Buffer.Open.empty())
+				continue;
+
+			const OpenScope Scope = Buffer.Open.back();
+			Buffer.Open.pop_back();
+
+			// Scopes that span a frame boundary count toward the frame they end in.
+			Node& n = p.Nodes[Scope.Node];
+			const int64_t Ticks = e.Tick - Scope.BeginTick;
+			++n.FrameCalls;
+			n.FrameTicks += Ticks;
+			p.Nodes[n.Parent].FrameChildTicks += Ticks;
+
+			p.Spans.push_back({ n.Name, Buffer.Index, Scope.BeginTick, e.Tick });
+			++p.TotalSpans;
+		}
+
+		Buffer.Tail.store(Tail, std::memory_order_release);
+	}
+
+	void AppendJsonString(std::string& Out, const char* Text)
+	{
+		Out += '"';
+		for (const char* c = Text; *c != 0; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				Out += '\\';
+				Out += *c;
+			}
+			else if ((unsigned char)*c < 0x20)
+			{
+				char Escaped[8];
+				snprintf(Escaped, sizeof(Escaped), "\\u%04x", (unsigned char)*c);
+				Out += Escaped;
+			}
+			else
+			{
+				Out += *c;
+			}
+		}
+		Out += '"';
+	}
+
+	std::wstring GetDefaultTracePath(void)
+	{
+		try
+		{
+			using namespace winrt::Windows::Storage;
+			std::wstring Path(ApplicationData::Current().LocalFolder().Path().c_str());
+			return Path + L"\\" + std::wstring(kTraceName, kTraceName + strlen(kTraceName));
+		}
+		catch (winrt::hresult_error const&)
+		{
+			// No package identity, so use the working directory.
+			return std::wstring(kTraceName, kTraceName + strlen(kTraceName));
+		}
+	}
+}
+
+void HolographicEngine::EngineProfiling::BeginBlock(const char* name)
+{
+	ThreadBuffer& Buffer = GetThreadBuffer();
+
+	if (Buffer.SkipDepth == 0)
+	{
+		// Room for this scope's begin and end, and the end of every scope it is nested in.
+		const uint32_t Used = Buffer.Head.load(std::memory_order_relaxed) - Buffer.Tail.load(std::memory_order_acquire);
+		if (kEventsPerThread - Used >= Buffer.OpenDepth + 2)
+		{
+			Push(Buffer, name);
+			++Buffer.OpenDepth;
+			return;
+		}
+
+		++GetProfiler().Dropped;
+	}
+
+	++Buffer.SkipDepth;
+}
+
+void HolographicEngine::EngineProfiling::EndBlock(void)
+{
+	ThreadBuffer& Buffer = GetThreadBuffer();
+
+	if (Buffer.SkipDepth > 0)
+	{
+		--Buffer.SkipDepth;
+		return;
+	}
+
+	ASSERT(Buffer.OpenDepth > 0, "EndBlock without a matching BeginBlock");
+	--Buffer.OpenDepth;
+	Push(Buffer, nullptr);
+}
+
+void HolographicEngine::EngineProfiling::Update(void)
+{
+	Profiler& p = GetProfiler();
+
+	std::vector<ThreadBuffer*> Threads;
+	{
+		std::lock_guard<std::mutex> guard(p.ThreadsMutex);
+		Threads = p.Threads;
+	}
+
+	std::lock_guard<std::mutex> guard(p.Mutex);
+
+	const FrameMark Mark = { p.FrameIndex, SystemTime::GetCurrentTick(), p.TotalSpans };
+
+	for (ThreadBuffer* Buffer : Threads)
+		Drain(p, *Buffer);
+
+	{
+		std::lock_guard<std::mutex> threadsGuard(p.ThreadsMutex);
+		for (ThreadBuffer* Buffer : Threads)
+		{
+			// Exited is only set after the thread's last event, so the buffer is empty for good.
+			if (Buffer->Exited.load(std::memory_order_acquire) &&
+				Buffer->Tail.load(std::memory_order_relaxed) == Buffer->Head.load(std::memory_order_relaxed))
+			{
+				Buffer->Exited.store(false, std::memory_order_relaxed);
+				Buffer->OpenDepth = 0;
+				Buffer->SkipDepth = 0;
+				Buffer->Open.clear();
+				p.FreeBuffers.push_back(Buffer);
+			}
+		}
+	}
+
+	p.Marks.push_back(Mark);
+	while (p.Marks.size() > kMaxFrameMarks)
+		p.Marks.pop_front();
+
+	// Only the spans of the frames kept.
+	if (p.Marks.size() >= p.TraceFrames)
+	{
+		const uint64_t FirstKept = p.Marks[p.Marks.size() - p.TraceFrames].FirstSpan;
+		while (!p.Spans.empty() && p.TotalSpans - p.Spans.size() < FirstKept)
+			p.Spans.pop_front();
+	}
+	while (p.Spans.size() > kMaxTraceSpans)
+		p.Spans.pop_front();
+
+	for (Node& n : p.Nodes)
+	{
+		if (n.Parent == kNoNode)
+			continue;
+
+		n.Calls = n.FrameCalls;
+		n.InclusiveMs = SystemTime::TicksToMillisecs(n.FrameTicks);
+		n.ExclusiveMs = SystemTime::TicksToMillisecs(n.FrameTicks - n.FrameChildTicks);
+		n.MaxMs = max(n.MaxMs, n.InclusiveMs);
+		n.AverageMs = n.HasAverage ? n.AverageMs + (n.InclusiveMs - n.AverageMs) * 0.1 : n.InclusiveMs;
+		n.HasAverage = true;
+
+		n.FrameCalls = 0;
+		n.FrameTicks = 0;
+		n.FrameChildTicks = 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> countersGuard(p.CountersMutex);
+		for (CounterEntry& c : p.Counters)
+		{
+			c.Last = { c.Name, c.FrameCalls, c.FrameItems, SystemTime::TicksToMillisecs(c.FrameTicks), c.FrameCounts };
+			c.FrameCalls = 0;
+			c.FrameItems = 0;
+			c.FrameTicks = 0;
+			memset(&c.FrameCounts, 0, sizeof(c.FrameCounts));
+		}
+	}
+
+	++p.FrameIndex;
+}
+
+std::vector<ScopeStats> HolographicEngine::EngineProfiling::GetFrameStats(void)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.Mutex);
+
+	std::vector<ScopeStats> Result;
+	std::vector<uint32_t> Stack;
+
+	for (uint32_t i = 0; i < (uint32_t)p.Nodes.size(); ++i)
+	{
+		if (p.Nodes[i].Parent != kNoNode)
+			continue;
+
+		Stack.assign(p.Nodes[i].Children.rbegin(), p.Nodes[i].Children.rend());
+		while (!Stack.empty())
+		{
+			const Node& n = p.Nodes[Stack.back()];
+			Stack.pop_back();
+
+			Result.push_back({ n.Name, n.Thread, n.Depth - 1, n.Calls, n.InclusiveMs, n.ExclusiveMs, n.AverageMs, n.MaxMs });
+			Stack.insert(Stack.end(), n.Children.rbegin(), n.Children.rend());
+		}
+	}
+
+	return Result;
+}
+
+void HolographicEngine::EngineProfiling::PrintFrameStats(void)
+{
+	const std::vector<ScopeStats> Stats = GetFrameStats();
+
+	FrameStats::Print();
+	MemoryTracking::Print();
+	FrameCounters::Print();
+	LockStats::Print();
+
+	Utility::Printf("Frame %llu profile, ms: inclusive (self, average, max) x calls\n", GetFrameIndex());
+
+	uint32_t Thread = ~0u;
+	for (const ScopeStats& s : Stats)
+	{
+		if (s.Thread != Thread)
+		{
+			Thread = s.Thread;
+			Utility::Printf("  Thread %u\n", Thread);
+		}
+
+		const std::string Indent(4 + 2 * s.Depth, ' ');
+		Utility::Printf("%s%s: %.3f (%.3f, %.3f, %.3f) x %u\n", Indent.c_str(), s.Name, s.InclusiveMs, s.ExclusiveMs,
+			s.AverageMs, s.MaxMs, s.Calls);
+	}
+
+	const std::vector<CounterStats> Counters = GetCounterStats();
+	if (Counters.empty())
+		return;
+
+	// Counters that are not counted here (all but cycles on Windows) are left out rather than printed as
+	// zeros.
+	using namespace HardwareCounters;
+	const bool HasCycles = IsAvailable(kCycles);
+	const bool HasIPC = HasCycles && IsAvailable(kInstructions);
+	const Counter kMisses[] = { kL1DMisses, kLLCMisses, kBranchMisses };
+
+	Utility::Printf("Counters: ms x calls, items, ns%s per item%s", HasCycles ? " and cycles" : "", HasIPC ? ", IPC" : "");
+	for (Counter m : kMisses)
+	{
+		if (IsAvailable(m))
+			Utility::Printf(", %s per item", GetCounterName(m));
+	}
+	Utility::Printf("\n");
+
+	for (const CounterStats& c : Counters)
+	{
+		if (c.Calls == 0)
+			continue;
+
+		const double Items = c.Items != 0 ? (double)c.Items : 1.0;
+		Utility::Printf("    %s: %.3f x %u, %llu, %.2f", c.Name, c.Milliseconds, c.Calls, (unsigned long long)c.Items,
+			c.Milliseconds * 1e6 / Items);
+		if (HasCycles)
+			Utility::Printf(", %.2f", c.Counts[kCycles] / Items);
+		if (HasIPC)
+			Utility::Printf(", %.2f", c.Counts.GetIPC());
+		for (Counter m : kMisses)
+		{
+			if (IsAvailable(m))
+				Utility::Printf(", %.3f", c.Counts[m] / Items);
+		}
+		Utility::Printf("\n");
+	}
+}
+
+uint64_t HolographicEngine::EngineProfiling::GetFrameIndex(void)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.Mutex);
+	return p.FrameIndex;
+}
+
+uint64_t HolographicEngine::EngineProfiling::GetDroppedCount(void)
+{
+	return GetProfiler().Dropped;
+}
+
+std::string HolographicEngine::EngineProfiling::GetChromeTrace(uint32_t numFrames, const std::string& otherData)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.Mutex);
+
+	// The spans of the last numFrames collected frames, and the boundaries around them.
+	size_t FirstSpan = 0;
+	size_t FirstMark = 0;
+	if (numFrames > 0 && numFrames <= p.Marks.size())
+	{
+		const uint64_t OldestKept = p.TotalSpans - p.Spans.size();
+		const uint64_t First = p.Marks[p.Marks.size() - numFrames].FirstSpan;
+		FirstSpan = First > OldestKept ? (size_t)(First - OldestKept) : 0;
+		FirstMark = p.Marks.size() - numFrames - (numFrames < p.Marks.size() ? 1 : 0);
+	}
+
+	int64_t BaseTick = INT64_MAX;
+	for (size_t i = FirstSpan; i < p.Spans.size(); ++i)
+		BaseTick = min(BaseTick, p.Spans[i].BeginTick);
+	for (size_t i = FirstMark; i < p.Marks.size(); ++i)
+		BaseTick = min(BaseTick, p.Marks[i].EndTick);
+
+	std::string Json;
+	Json.reserve(96 * (p.Spans.size() - FirstSpan) + otherData.size() + 64);
+	Json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	// Complete events, with microsecond timestamps.
+	char Buffer[128];
+	bool First = true;
+	for (size_t i = FirstSpan; i < p.Spans.size(); ++i)
+	{
+		const Span& s = p.Spans[i];
+		Json += First ? "{\"name\":" : ",\n{\"name\":";
+		First = false;
+
+		AppendJsonString(Json, s.Name);
+		snprintf(Buffer, sizeof(Buffer), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", s.Thread,
+			SystemTime::TicksToSeconds(s.BeginTick - BaseTick) * 1e6, SystemTime::TicksToSeconds(s.EndTick - s.BeginTick) * 1e6);
+		Json += Buffer;
+	}
+
+	// Frame boundaries, as global instant events.
+	for (size_t i = FirstMark; i < p.Marks.size(); ++i)
+	{
+		const FrameMark& m = p.Marks[i];
+		snprintf(Buffer, sizeof(Buffer), "%s{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+			First ? "" : ",\n", (unsigned long long)m.Index + 1, SystemTime::TicksToSeconds(m.EndTick - BaseTick) * 1e6);
+		Json += Buffer;
+		First = false;
+	}
+
+	Json += "\n]";
+	if (!otherData.empty())
+	{
+		Json += ",\"otherData\":";
+		Json += otherData;
+	}
+	Json += "}\n";
+	return Json;
+}
+
+bool HolographicEngine::EngineProfiling::ExportChromeTrace(const std::wstring& fileName)
+{
+	const std::string Json = GetChromeTrace();
+	return Utility::WriteFileSync(fileName.empty() ? GetDefaultTracePath() : fileName, Json.data(), Json.size());
+}
+
+void HolographicEngine::EngineProfiling::SetCountersEnabled(bool enabled)
+{
+	s_HardwareCounters = enabled;
+}
+
+bool HolographicEngine::EngineProfiling::AreCountersEnabled(void)
+{
+	return s_HardwareCounters && s_CountersSuspended.load(std::memory_order_relaxed) == 0;
+}
+
+HolographicEngine::EngineProfiling::ScopedCountersSuspended::ScopedCountersSuspended()
+{
+	s_CountersSuspended.fetch_add(1, std::memory_order_relaxed);
+}
+
+HolographicEngine::EngineProfiling::ScopedCountersSuspended::~ScopedCountersSuspended()
+{
+	s_CountersSuspended.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::vector<CounterStats> HolographicEngine::EngineProfiling::GetCounterStats(void)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.CountersMutex);
+
+	std::vector<CounterStats> Result;
+	for (const CounterEntry& c : p.Counters)
+		Result.push_back(c.Last);
+	return Result;
+}
+
+void HolographicEngine::EngineProfiling::ScopedCounters::Begin(const char* name, uint64_t items)
+{
+	BeginBlock(name);
+
+	m_Name = name;
+	m_Items = items;
+	HardwareCounters::Read(m_Start);
+	m_StartTick = SystemTime::GetCurrentTick();
+}
+
+void HolographicEngine::EngineProfiling::ScopedCounters::End(void)
+{
+	const int64_t EndTick = SystemTime::GetCurrentTick();
+	HardwareCounters::Sample End;
+	HardwareCounters::Read(End);
+
+	EndBlock();
+
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.CountersMutex);
+
+	CounterEntry* Entry = nullptr;
+	for (CounterEntry& c : p.Counters)
+	{
+		if (c.Name == m_Name || strcmp(c.Name, m_Name) == 0)
+		{
+			Entry = &c;
+			break;
+		}
+	}
+
+	if (Entry == nullptr)
+	{
+		MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagProfiling);
+		p.Counters.push_back({ m_Name });
+		Entry = &p.Counters.back();
+		Entry->Last.Name = m_Name;
+	}
+
+	++Entry->FrameCalls;
+	Entry->FrameItems += m_Items;
+	Entry->FrameTicks += EndTick - m_StartTick;
+	for (int i = 0; i < HardwareCounters::kNumCounters; ++i)
+		Entry->FrameCounts.Values[i] += End.Values[i] - m_Start.Values[i];
+}
+
+void HolographicEngine::EngineProfiling::Reset(void)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.Mutex);
+
+	p.Spans.clear();
+	p.Marks.clear();
+	for (Node& n : p.Nodes)
+	{
+		n.Calls = 0;
+		n.InclusiveMs = 0.0;
+		n.ExclusiveMs = 0.0;
+		n.AverageMs = 0.0;
+		n.MaxMs = 0.0;
+		n.HasAverage = false;
+	}
+}
+
+void HolographicEngine::EngineProfiling::SetTraceFrames(uint32_t numFrames)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.Mutex);
+	p.TraceFrames = max(1u, min(numFrames, (uint32_t)kMaxFrameMarks));
+}
+
+uint32_t HolographicEngine::EngineProfiling::GetTraceFrames(void)
+{
+	Profiler& p = GetProfiler();
+	std::lock_guard<std::mutex> guard(p.Mutex);
+	return p.TraceFrames;
+}
@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "HardwareCounters.h"
+#include <string>
+#include <vector>
+
+// A hierarchical CPU profiler.
+//
+// PROFILE_SCOPE("Name") times the enclosing scope.  Scopes nest, on every thread, and each thread records
+// into its own ring buffer without taking a lock, so a scope costs two clock reads and a few stores.  Names
+// must be string literals: only the pointer is recorded, which the compiler has already made unique.
+//
+// Update(), called at the start of every frame, collects what the threads recorded since the last call
+// into a tree per thread, with the time and call count of each scope in the frame that just ended and a
+// running average.  The spans of the last few frames are kept, and can be written out in the Chrome trace
+// format for chrome://tracing or Perfetto.  PrintFrameStats also prints the distribution of frame times
+// from FrameStats.
+//
+// PROFILE_COUNTERS("Name", items) is a scope that also reads the thread's hardware counters at each end,
+// for kernels where the time alone does not say whether they are bound by compute, memory or branches.
+// The counts, and the items processed, are summed per name over the frame, for figures per item.  These
+// scopes do nothing but check a flag unless the "Profiling/Hardware Counters" setting is on.
+
+namespace HolographicEngine::EngineProfiling
+{
+	// Events a thread can record between two calls to Update.  Scopes beyond that are dropped, whole,
+	// and counted.
+	const uint32_t kEventsPerThread = 1 << 14;
+	const size_t kMaxTraceSpans = 1 << 20;
+	const size_t kMaxFrameMarks = 1024;
+
+	// Enough for a FrameWatchdog capture, at a few hundred KB.  A longer trace is opt-in, through the
+	// "Profiling/Trace Frames" setting.
+	const uint32_t kDefaultTraceFrames = 64;
+
+	void BeginBlock(const char* name);
+	void EndBlock(void);
+
+	// Closes the frame.  Called by the engine at the start of each frame, on the main thread.
+	void Update(void);
+
+	struct ScopeStats
+	{
+		const char* Name;
+		uint32_t Thread;          // In order of first marker; an exited thread's index goes to the next new one
+		uint32_t Depth;
+		uint32_t Calls;           // In the last frame
+		double InclusiveMs;       // In the last frame
+		double ExclusiveMs;       // Without the time in nested scopes
+		double AverageMs;         // Inclusive, smoothed over recent frames
+		double MaxMs;             // Inclusive, the most in any one frame
+	};
+
+	// Every scope seen so far, depth first, each thread's scopes together.  Scopes that did not run in
+	// the last frame are included with zero calls.
+	std::vector<ScopeStats> GetFrameStats(void);
+	void PrintFrameStats(void);
+
+	uint64_t GetFrameIndex(void);
+	uint64_t GetDroppedCount(void);
+
+	// The kept spans as Chrome trace JSON, with an instant event where each frame starts.  Only the spans
+	// collected in the last numFrames calls to Update when not zero.  otherData, when not empty, must be a
+	// JSON object, and is stored as the trace's metadata.
+	std::string GetChromeTrace(uint32_t numFrames = 0, const std::string& otherData = std::string());
+
+	// Writes the kept spans as Chrome trace JSON.  An empty name writes ProfileTrace.json in the app's
+	// local folder.
+	bool ExportChromeTrace(const std::wstring& fileName = std::wstring());
+
+	// Forgets the kept spans and the averages.
+	void Reset(void);
+
+	// The frames whose spans are kept, up to kMaxFrameMarks.  Whatever the number, no more than
+	// kMaxTraceSpans spans are.
+	void SetTraceFrames(uint32_t numFrames);
+	uint32_t GetTraceFrames(void);
+
+	// Whether PROFILE_COUNTERS scopes count.  Off by default; the setting changes it at run time.
+	void SetCountersEnabled(bool enabled);
+	bool AreCountersEnabled(void);
+
+	// Turns PROFILE_COUNTERS scopes off while it lives, leaving the setting as the user left it, for
+	// code that reads the counters itself around calls that have their own scopes.  Instances nest.
+	class ScopedCountersSuspended
+	{
+	public:
+		ScopedCountersSuspended();
+		~ScopedCountersSuspended();
+
+		ScopedCountersSuspended(const ScopedCountersSuspended&) = delete;
+		ScopedCountersSuspended& operator=(const ScopedCountersSuspended&) = delete;
+	};
+
+	struct CounterStats
+	{
+		const char* Name;
+		uint32_t Calls;                       // In the last frame, as are the rest
+		uint64_t Items;
+		double Milliseconds;
+		HardwareCounters::Sample Counts;
+	};
+
+	// Every counter scope seen so far, by name.
+	std::vector<CounterStats> GetCounterStats(void);
+
+	class ScopedTimer
+	{
+	public:
+		template <size_t N>
+		explicit ScopedTimer(const char (&name)[N]) { BeginBlock(name); }
+		~ScopedTimer() { EndBlock(); }
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	};
+
+	class ScopedCounters
+	{
+	public:
+		template <size_t N>
+		ScopedCounters(const char (&name)[N], uint64_t items) : m_Name(nullptr)
+		{
+			if (AreCountersEnabled())
+				Begin(name, items);
+		}
+
+		~ScopedCounters()
+		{
+			if (m_Name != nullptr)
+				End();
+		}
+
+		ScopedCounters(const ScopedCounters&) = delete;
+		ScopedCounters& operator=(const ScopedCounters&) = delete;
+
+	private:
+		void Begin(const char* name, uint64_t items);
+		void End(void);
+
+		const char* m_Name;
+		uint64_t m_Items;
+		int64_t m_StartTick;
+		HardwareCounters::Sample m_Start;
+	};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) HolographicEngine::EngineProfiling::ScopedTimer PROFILE_CONCAT(_ProfileScope, __LINE__)(name)
+#define PROFILE_COUNTERS(name, items) HolographicEngine::EngineProfiling::ScopedCounters PROFILE_CONCAT(_ProfileCounters, __LINE__)(name, items)
@@ -0,0 +1,433 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "EngineTuning.h"
+#include "FileUtility.h"
+#include "Hash.h"
+#include "MemoryTracking.h"
+#include <map>
+
+using namespace HolographicEngine;
+
+namespace
+{
+	const wchar_t* kSettingsName = L"EngineTuning.txt";
+	const char* kSettingsHeader = "# Engine settings, one \"path = value\" per line.  Changes apply while the app runs.\n";
+
+	struct Registry
+	{
+		InstrumentedMutex Mutex{ "EngineTuning/Registry" };
+		std::map<std::string, EngineVar*> Vars;
+
+		// The file's entries, by path, including those of settings that are not registered.
+		std::map<std::string, std::string> Values;
+
+		std::wstring Path;
+		uint64_t FileHash = 0;
+		float SinceCheck = 0.0f;
+
+		// A read of the file in the background, and its result once done.
+		bool Reading = false;
+		bool ReadDone = false;
+		Utility::ByteArray ReadData;
+	};
+
+	Registry& GetRegistry(void)
+	{
+		static Registry s_Registry;
+		return s_Registry;
+	}
+
+	std::wstring GetSettingsPath(void)
+	{
+		try
+		{
+			using namespace winrt::Windows::Storage;
+			return std::wstring(ApplicationData::Current().LocalFolder().Path().c_str()) + L"\\" + kSettingsName;
+		}
+		catch (winrt::hresult_error const&)
+		{
+			// No package identity, so nowhere to keep the settings.
+			return std::wstring();
+		}
+	}
+
+	// A plain read rather than Utility::ReadFileSync: the file is not an asset, so it is not looked for
+	// compressed, recorded for the startup prefetch or left mapped while Save rewrites it.  Returns
+	// NullFile when the file is missing or cannot be read whole.
+	Utility::ByteArray ReadSettings(const std::wstring& Path)
+	{
+		HANDLE File = CreateFile2(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_EXISTING, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+			return Utility::NullFile;
+
+		Utility::ByteArray Data = Utility::NullFile;
+		LARGE_INTEGER Size;
+		if (GetFileSizeEx(File, &Size) && (uint64_t)Size.QuadPart <= MAXDWORD)
+		{
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagCache);
+			Utility::ByteArray Contents = std::make_shared<std::vector<unsigned char> >((size_t)Size.QuadPart);
+			DWORD Read = 0;
+			if (Contents->empty() || (ReadFile(File, Contents->data(), (DWORD)Contents->size(), &Read, nullptr) && Read == Contents->size()))
+				Data = std::move(Contents);
+		}
+
+		CloseHandle(File);
+		return Data;
+	}
+
+	std::string Trim(const std::string& Text)
+	{
+		const size_t First = Text.find_first_not_of(" \t\r");
+		if (First == std::string::npos)
+			return std::string();
+		return Text.substr(First, Text.find_last_not_of(" \t\r") - First + 1);
+	}
+
+	std::map<std::string, std::string> ParseSettings(const char* Text, size_t Size)
+	{
+		std::map<std::string, std::string> Result;
+
+		size_t Start = 0;
+		while (Start < Size)
+		{
+			const char* End = (const char*)memchr(Text + Start, '\n', Size - Start);
+			const size_t LineEnd = End != nullptr ? End - Text : Size;
+			const std::string Line(Text + Start, LineEnd - Start);
+			Start = LineEnd + 1;
+
+			const size_t Equals = Line.find('=');
+			if (Line.empty() || Line[0] == '#' || Equals == std::string::npos)
+				continue;
+
+			const std::string Path = Trim(Line.substr(0, Equals));
+			if (!Path.empty())
+				Result[Path] = Trim(Line.substr(Equals + 1));
+		}
+
+		return Result;
+	}
+
+	// Applies the file's values, and resets the settings whose entries were removed from it.  Runs the
+	// callbacks on the calling thread, without the registry locked.
+	void ApplySettings(const Utility::ByteArray& Data)
+	{
+		Registry& r = GetRegistry();
+		std::vector<std::pair<EngineVar*, std::string> > Changes;
+		std::vector<EngineVar*> Removed;
+		{
+			std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagCache);
+
+			const uint64_t FileHash = Data->empty() ? 0 : Hash::Hash64(Data->data(), Data->size());
+			if (FileHash == r.FileHash)
+				return;
+			r.FileHash = FileHash;
+
+			std::map<std::string, std::string> Values = ParseSettings((const char*)Data->data(), Data->size());
+			for (const auto& Entry : r.Vars)
+			{
+				auto Found = Values.find(Entry.first);
+				if (Found != Values.end())
+					Changes.emplace_back(Entry.second, Found->second);
+				else if (r.Values.count(Entry.first) != 0)
+					Removed.push_back(Entry.second);
+			}
+			r.Values = std::move(Values);
+		}
+
+		for (const auto& Change : Changes)
+		{
+			if (!Change.first->SetValue(Change.second))
+				Utility::Printf("EngineTuning: \"%s\" is not a value of %s\n", Change.second.c_str(), Change.first->GetPath().c_str());
+		}
+		for (EngineVar* Var : Removed)
+			Var->Reset();
+	}
+
+	bool ParseBool(const std::string& Text, bool& Value)
+	{
+		if (Text == "1" || _stricmp(Text.c_str(), "true") == 0 || _stricmp(Text.c_str(), "on") == 0)
+			Value = true;
+		else if (Text == "0" || _stricmp(Text.c_str(), "false") == 0 || _stricmp(Text.c_str(), "off") == 0)
+			Value = false;
+		else
+			return false;
+		return true;
+	}
+
+	// Decimal, or hexadecimal after an explicit 0x, so that a leading zero does not make a value octal.
+	bool ParseInt(const std::string& Text, int32_t& Value)
+	{
+		const bool Hex = Text.size() > 2 && Text[0] == '0' && (Text[1] == 'x' || Text[1] == 'X');
+		if (Hex && Text.find_first_not_of("0123456789abcdefABCDEF", 2) != std::string::npos)
+			return false;
+
+		const char* Digits = Text.c_str() + (Hex ? 2 : 0);
+		char* End = nullptr;
+		errno = 0;
+		const long long Parsed = strtoll(Digits, &End, Hex ? 16 : 10);
+		if (End == Digits || *End != 0 || errno != 0)
+			return false;
+
+		Value = (int32_t)max((long long)INT32_MIN, min((long long)INT32_MAX, Parsed));
+		return true;
+	}
+}
+
+EngineVar::EngineVar(const char* path) : m_Path(path), m_CallbackMutex("EngineTuning/Callbacks")
+{
+}
+
+EngineVar::~EngineVar()
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+	auto Found = r.Vars.find(m_Path);
+	if (Found != r.Vars.end() && Found->second == this)
+		r.Vars.erase(Found);
+}
+
+void EngineVar::Register(void)
+{
+	Registry& r = GetRegistry();
+	std::string Value;
+	{
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+		MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagCache);
+
+		const bool Inserted = r.Vars.emplace(m_Path, this).second;
+		ASSERT(Inserted, "Two settings have the same path");
+
+		auto Found = r.Values.find(m_Path);
+		if (Found == r.Values.end())
+			return;
+		Value = Found->second;
+	}
+
+	SetValue(Value);
+}
+
+void EngineVar::AddCallback(Callback callback)
+{
+	std::lock_guard<InstrumentedMutex> Guard(m_CallbackMutex);
+	m_Callbacks.push_back(std::move(callback));
+}
+
+void EngineVar::OnChanged(void)
+{
+	std::vector<Callback> Callbacks;
+	{
+		std::lock_guard<InstrumentedMutex> Guard(m_CallbackMutex);
+		Callbacks = m_Callbacks;
+	}
+
+	for (const Callback& c : Callbacks)
+		c(*this);
+}
+
+BoolVar::BoolVar(const char* path, bool value) : TypedVar<bool>(path, value, false, true)
+{
+	Register();
+}
+
+std::string BoolVar::ToString(void) const
+{
+	return Get() ? "true" : "false";
+}
+
+bool BoolVar::SetValue(const std::string& text)
+{
+	bool Value;
+	if (!ParseBool(text, Value))
+		return false;
+
+	Set(Value);
+	return true;
+}
+
+NumVar::NumVar(const char* path, float value, float minValue, float maxValue)
+	: TypedVar<float>(path, value, minValue, maxValue)
+{
+	Register();
+}
+
+std::string NumVar::ToString(void) const
+{
+	char Buffer[32];
+	snprintf(Buffer, sizeof(Buffer), "%g", Get());
+	return Buffer;
+}
+
+bool NumVar::SetValue(const std::string& text)
+{
+	char* End = nullptr;
+	const float Value = strtof(text.c_str(), &End);
+	if (text.empty() || *End != 0 || Value != Value)
+		return false;
+
+	Set(Value);
+	return true;
+}
+
+IntVar::IntVar(const char* path, int32_t value, int32_t minValue, int32_t maxValue)
+	: TypedVar<int32_t>(path, value, minValue, maxValue)
+{
+	Register();
+}
+
+std::string IntVar::ToString(void) const
+{
+	return std::to_string(Get());
+}
+
+bool IntVar::SetValue(const std::string& text)
+{
+	int32_t Value;
+	if (!ParseInt(text, Value))
+		return false;
+
+	Set(Value);
+	return true;
+}
+
+EnumVar::EnumVar(const char* path, int32_t value, int32_t listLength, const char** listLabels)
+	: TypedVar<int32_t>(path, value, 0, listLength - 1), m_Labels(listLabels)
+{
+	ASSERT(listLength > 0 && value >= 0 && value < listLength, "The value has to be one of the labels");
+	Register();
+}
+
+std::string EnumVar::ToString(void) const
+{
+	return GetLabel();
+}
+
+bool EnumVar::SetValue(const std::string& text)
+{
+	for (int32_t i = 0; i <= GetMax(); ++i)
+	{
+		if (_stricmp(text.c_str(), m_Labels[i]) == 0)
+		{
+			Set(i);
+			return true;
+		}
+	}
+
+	int32_t Value;
+	if (!ParseInt(text, Value) || Value < 0 || Value > GetMax())
+		return false;
+
+	Set(Value);
+	return true;
+}
+
+void HolographicEngine::EngineTuning::Initialize(void)
+{
+	Registry& r = GetRegistry();
+	{
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+		r.Path = GetSettingsPath();
+		if (r.Path.empty())
+			return;
+	}
+
+	ApplySettings(ReadSettings(r.Path));
+}
+
+void HolographicEngine::EngineTuning::Update(float frameTime)
+{
+	Registry& r = GetRegistry();
+	Utility::ByteArray Data;
+	{
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+		if (r.Path.empty())
+			return;
+
+		if (r.ReadDone)
+		{
+			Data = std::move(r.ReadData);
+			r.ReadDone = false;
+			r.Reading = false;
+		}
+
+		r.SinceCheck += frameTime;
+		if (!r.Reading && r.SinceCheck >= kReloadSeconds)
+		{
+			r.SinceCheck = 0.0f;
+			r.Reading = true;
+
+			const std::wstring Path = r.Path;
+			concurrency::create_task([Path]
+			{
+				Utility::ByteArray File = ReadSettings(Path);
+
+				Registry& r = GetRegistry();
+				std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+				r.ReadData = std::move(File);
+				r.ReadDone = true;
+			});
+		}
+	}
+
+	if (Data != nullptr)
+		ApplySettings(Data);
+}
+
+bool HolographicEngine::EngineTuning::Save(void)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+	if (r.Path.empty())
+		return false;
+
+	MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagCache);
+	std::map<std::string, std::string> Values = r.Values;
+	for (const auto& Entry : r.Vars)
+		Values[Entry.first] = Entry.second->ToString();
+
+	std::string Text = kSettingsHeader;
+	for (const auto& Entry : Values)
+		Text += Entry.first + " = " + Entry.second + "\n";
+
+	if (!Utility::WriteFileSync(r.Path, Text.data(), Text.size()))
+		return false;
+
+	// What was just written is already applied, so the next check has nothing to reload.
+	r.Values = std::move(Values);
+	r.FileHash = Hash::Hash64(Text.data(), Text.size());
+	return true;
+}
+
+std::vector<EngineVar*> HolographicEngine::EngineTuning::GetVars(void)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+	std::vector<EngineVar*> Result;
+	for (const auto& Entry : r.Vars)
+		Result.push_back(Entry.second);
+	return Result;
+}
+
+EngineVar* HolographicEngine::EngineTuning::FindVar(const std::string& path)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+	auto Found = r.Vars.find(path);
+	return Found != r.Vars.end() ? Found->second : nullptr;
+}
+
+void HolographicEngine::EngineTuning::Print(void)
+{
+	Utility::Printf("Engine settings:\n");
+	for (EngineVar* Var : GetVars())
+		Utility::Printf("  %s = %s\n", Var->GetPath().c_str(), Var->ToString().c_str());
+}
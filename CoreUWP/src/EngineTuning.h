@@ -0,0 +1,167 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "InstrumentedMutex.h"
+#include <atomic>
+#include <cfloat>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Settings that can be changed while the app runs.
+//
+// Each setting is a static BoolVar, NumVar, IntVar or EnumVar named by a path such as "IO/Max Reads In
+// Flight", and registers itself when constructed.  Code reads one like the value it holds; that is a
+// relaxed atomic load, so a setting can be read on any thread, on hot paths, every frame.
+//
+// The values are kept in EngineTuning.txt in the app's local folder, one "path = value" per line.
+// Initialize loads the file and Update reloads it whenever it changes, so settings can be compared on a
+// running session by editing the file, for instance through the device portal.  Entries for settings
+// that are not registered are kept, and written back by Save.
+//
+// Callbacks added to a setting run after each change of its value, on the thread that changed it.  For
+// changes from the file that is the thread calling Update.
+
+namespace HolographicEngine
+{
+	class EngineVar
+	{
+	public:
+		typedef std::function<void(EngineVar&)> Callback;
+
+		virtual ~EngineVar();
+
+		const std::string& GetPath(void) const { return m_Path; }
+
+		virtual std::string ToString(void) const = 0;
+
+		// Parses the text and sets the value, clamped to the setting's range.  Returns false, changing
+		// nothing, if the text is not a value of this setting.
+		virtual bool SetValue(const std::string& text) = 0;
+
+		// Back to the value the setting was constructed with.
+		virtual void Reset(void) = 0;
+
+		void AddCallback(Callback callback);
+
+	protected:
+		explicit EngineVar(const char* path);
+
+		// Called by the final class's constructor, once the value exists, to add the setting to the
+		// registry and apply a value already loaded from the file.
+		void Register(void);
+
+		void OnChanged(void);
+
+	private:
+		EngineVar(const EngineVar&) = delete;
+		EngineVar& operator=(const EngineVar&) = delete;
+
+		std::string m_Path;
+		InstrumentedMutex m_CallbackMutex;
+		std::vector<Callback> m_Callbacks;
+	};
+
+	template <typename T>
+	class TypedVar : public EngineVar
+	{
+	public:
+		T Get(void) const { return m_Value.load(std::memory_order_relaxed); }
+		operator T() const { return Get(); }
+
+		T GetDefault(void) const { return m_Default; }
+		T GetMin(void) const { return m_Min; }
+		T GetMax(void) const { return m_Max; }
+
+		void Set(T value)
+		{
+			value = value < m_Min ? m_Min : (m_Max < value ? m_Max : value);
+			if (m_Value.exchange(value, std::memory_order_relaxed) != value)
+				OnChanged();
+		}
+
+		void Reset(void) override { Set(m_Default); }
+
+	protected:
+		TypedVar(const char* path, T value, T minValue, T maxValue)
+			: EngineVar(path), m_Value(value), m_Default(value), m_Min(minValue), m_Max(maxValue) {}
+
+	private:
+		std::atomic<T> m_Value;
+		const T m_Default;
+		const T m_Min;
+		const T m_Max;
+	};
+
+	class BoolVar : public TypedVar<bool>
+	{
+	public:
+		BoolVar(const char* path, bool value);
+		BoolVar& operator=(bool value) { Set(value); return *this; }
+
+		std::string ToString(void) const override;
+		bool SetValue(const std::string& text) override;
+	};
+
+	class NumVar : public TypedVar<float>
+	{
+	public:
+		NumVar(const char* path, float value, float minValue = -FLT_MAX, float maxValue = FLT_MAX);
+		NumVar& operator=(float value) { Set(value); return *this; }
+
+		std::string ToString(void) const override;
+		bool SetValue(const std::string& text) override;
+	};
+
+	class IntVar : public TypedVar<int32_t>
+	{
+	public:
+		IntVar(const char* path, int32_t value, int32_t minValue = INT32_MIN, int32_t maxValue = INT32_MAX);
+		IntVar& operator=(int32_t value) { Set(value); return *this; }
+
+		std::string ToString(void) const override;
+		bool SetValue(const std::string& text) override;
+	};
+
+	// One of a list of labels, held as its index.  The file has the label; an index is also accepted.
+	class EnumVar : public TypedVar<int32_t>
+	{
+	public:
+		EnumVar(const char* path, int32_t value, int32_t listLength, const char** listLabels);
+		EnumVar& operator=(int32_t value) { Set(value); return *this; }
+
+		const char* GetLabel(void) const { return m_Labels[Get()]; }
+
+		std::string ToString(void) const override;
+		bool SetValue(const std::string& text) override;
+
+	private:
+		const char** m_Labels;
+	};
+
+	namespace EngineTuning
+	{
+		const float kReloadSeconds = 1.0f;
+
+		// Loads the settings file.  Called once at startup, before the game starts.
+		void Initialize(void);
+
+		// Checks the settings file for changes every kReloadSeconds, reading it in the background.
+		void Update(float frameTime);
+
+		// Writes every setting, and the file's entries for settings that are not registered.
+		bool Save(void);
+
+		// Every registered setting, by path.
+		std::vector<EngineVar*> GetVars(void);
+		EngineVar* FindVar(const std::string& path);
+
+		void Print(void);
+	}
+}
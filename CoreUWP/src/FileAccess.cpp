@@ -0,0 +1,271 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+// The parts of FileUtility.h that need nothing else from the engine: mapped files and their views,
+// inflating zlib and gzip data, and writing files.  Tools that pack or compress assets compile this file
+// instead of FileUtility.cpp, which reads through the engine's codecs, IO scheduler and counters.
+
+#include "pch.h"
+#include "FileUtility.h"
+#include <atomic>
+#include <zlib.h> // From NuGet package
+
+using namespace HolographicEngine::Utility;
+using namespace std;
+
+namespace HolographicEngine::Utility
+{
+	ByteArray NullFile = make_shared<vector<unsigned char> >(vector<unsigned char>());
+}
+
+namespace
+{
+	// Constant-initialized, so they can be set and read during static initialization.
+	atomic<FileObserver> s_OpenObserver{ nullptr };
+	atomic<FileObserver> s_WriteObserver{ nullptr };
+}
+
+void HolographicEngine::Utility::SetOpenObserver(FileObserver observer)
+{
+	s_OpenObserver.store(observer, memory_order_release);
+}
+
+void HolographicEngine::Utility::SetWriteObserver(FileObserver observer)
+{
+	s_WriteObserver.store(observer, memory_order_release);
+}
+
+FileView FileView::SubView(size_t offset, size_t size) const
+{
+	offset = min(offset, m_Size);
+	size = min(size, m_Size - offset);
+
+	FileView view(*this);
+	view.m_Data = m_Data + offset;
+	view.m_Size = size;
+	return view;
+}
+
+ByteArray FileView::ToByteArray(void) const
+{
+	if (m_Bytes != nullptr && m_Data == m_Bytes->data() && m_Size == m_Bytes->size())
+		return m_Bytes;
+
+	return make_shared<vector<unsigned char> >(begin(), end());
+}
+
+shared_ptr<MappedFile> MappedFile::Open(const wstring& fileName, uint32_t hints)
+{
+	CREATEFILE2_EXTENDED_PARAMETERS params = {};
+	params.dwSize = sizeof(params);
+	params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	if (hints & kMapSequential)
+		params.dwFileFlags = FILE_FLAG_SEQUENTIAL_SCAN;
+	else if (hints & kMapRandom)
+		params.dwFileFlags = FILE_FLAG_RANDOM_ACCESS;
+
+	HANDLE file = CreateFile2(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &params);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	// Empty files cannot be mapped, but they are still files.
+	if (fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return shared_ptr<MappedFile>(new MappedFile(nullptr, 0));
+	}
+
+	// The view keeps the section and the file open, so neither handle is needed once it exists.
+	HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return nullptr;
+
+	void* base = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+	CloseHandle(mapping);
+	if (base == nullptr)
+		return nullptr;
+
+	shared_ptr<MappedFile> mappedFile(new MappedFile((const unsigned char*)base, (size_t)fileSize.QuadPart));
+	FileObserver observer = s_OpenObserver.load(memory_order_acquire);
+	if (observer != nullptr)
+		observer(fileName);
+
+	if (hints & kMapWillNeed)
+		mappedFile->Prefetch();
+
+	return mappedFile;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_Base != nullptr)
+		UnmapViewOfFile(m_Base);
+}
+
+FileView MappedFile::View(size_t offset, size_t size) const
+{
+	offset = min(offset, m_Size);
+	size = min(size, m_Size - offset);
+	return FileView(shared_from_this(), m_Base + offset, size);
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const
+{
+	offset = min(offset, m_Size);
+	size = min(size, m_Size - offset);
+	if (size == 0)
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = (void*)(m_Base + offset);
+	range.NumberOfBytes = size;
+
+	// Only a hint; on failure the pages are simply read on demand.
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+InflateStream::InflateStream(FileView source)
+	: m_Source(std::move(source)), m_Stream(new z_stream()), m_TotalOut(0), m_Error(0), m_Finished(false)
+{
+	m_Stream->next_in = (Bytef*)m_Source.Data();
+	m_Stream->avail_in = (uInt)m_Source.Size();
+
+	// 15 window bits, and the +32 tells zlib to detect if using gzip or zlib
+	int err = inflateInit2(m_Stream.get(), 15 + 32);
+	if (err != Z_OK)
+	{
+		m_Error = err;
+		m_Finished = true;
+	}
+}
+
+InflateStream::~InflateStream()
+{
+	inflateEnd(m_Stream.get());
+}
+
+uint64_t InflateStream::GetSizeHint(void) const
+{
+	const unsigned char* data = m_Source.Data();
+	const size_t size = m_Source.Size();
+
+	// A gzip member is at least a 10-byte header and an 8-byte trailer ending in ISIZE, little-endian.
+	if (size < 18 || data[0] != 0x1F || data[1] != 0x8B)
+		return 0;
+
+	const unsigned char* isize = data + size - 4;
+	return (uint64_t)isize[0] | ((uint64_t)isize[1] << 8) | ((uint64_t)isize[2] << 16) | ((uint64_t)isize[3] << 24);
+}
+
+size_t InflateStream::Read(unsigned char* dest, size_t size)
+{
+	size_t written = 0;
+
+	while (written < size && !m_Finished)
+	{
+		// avail_out is 32 bits, so very large reads go in pieces.
+		const uInt chunk = (uInt)min(size - written, (size_t)UINT32_MAX);
+		m_Stream->next_out = dest + written;
+		m_Stream->avail_out = chunk;
+
+		int err = inflate(m_Stream.get(), Z_NO_FLUSH);
+		const size_t produced = chunk - m_Stream->avail_out;
+		written += produced;
+		m_TotalOut += produced;
+
+		if (err == Z_STREAM_END)
+		{
+			// Another gzip member may follow.  Anything else after the stream is ignored, as gunzip does.
+			if (m_Stream->avail_in >= 2 && m_Stream->next_in[0] == 0x1F && m_Stream->next_in[1] == 0x8B)
+				inflateReset(m_Stream.get());
+			else
+				m_Finished = true;
+		}
+		else if (err == Z_BUF_ERROR && produced == 0)
+		{
+			// No progress with output space available means the input ended early.
+			m_Error = Z_DATA_ERROR;
+			m_Finished = true;
+		}
+		else if (err != Z_OK && err != Z_BUF_ERROR)
+		{
+			m_Error = err;
+			m_Finished = true;
+		}
+	}
+
+	return written;
+}
+
+ByteArray HolographicEngine::Utility::Inflate(const FileView& compressedSource, int& error)
+{
+	InflateStream stream(compressedSource);
+
+	// The result is reserved from the trailer, which is right for almost every asset, and grows when it is
+	// missing or wrong.  A vector cannot be sized without zero filling it, so zlib writes into a chunk that
+	// stays in cache and each chunk is appended: the result is written once instead of cleared first.
+	const uint64_t sizeHint = stream.GetSizeHint();
+	const size_t capacity = sizeHint > 0 ? (size_t)sizeHint : max(compressedSource.Size() * 4, (size_t)4096);
+
+	ByteArray byteArray = make_shared<vector<unsigned char> >();
+	byteArray->reserve(capacity);
+
+	const size_t kChunkSize = 64 * 1024;
+	unique_ptr<unsigned char[]> chunk(new unsigned char[kChunkSize]);
+	while (!stream.IsFinished())
+	{
+		const size_t produced = stream.Read(chunk.get(), kChunkSize);
+		byteArray->insert(byteArray->end(), chunk.get(), chunk.get() + produced);
+	}
+
+	error = stream.GetError();
+	if (stream.HasFailed())
+		return NullFile;
+
+	const size_t size = byteArray->size();
+	ASSERT(size > 0, "Nothing to decompress");
+
+	if (byteArray->capacity() - size > size / 8)
+		byteArray->shrink_to_fit();
+
+	return byteArray;
+}
+
+bool HolographicEngine::Utility::WriteFileSync(const wstring& fileName, const void* data, size_t size)
+{
+	HANDLE file = CreateFile2(fileName.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool succeeded = true;
+	size_t offset = 0;
+	while (succeeded && offset < size)
+	{
+		DWORD written = 0;
+		const DWORD chunk = (DWORD)min(size - offset, (size_t)(1 << 30));
+		succeeded = WriteFile(file, (const unsigned char*)data + offset, chunk, &written, nullptr) && written == chunk;
+		offset += written;
+	}
+
+	CloseHandle(file);
+	if (!succeeded)
+		DeleteFileW(fileName.c_str());
+
+	FileObserver observer = s_WriteObserver.load(memory_order_acquire);
+	if (succeeded && observer != nullptr)
+		observer(fileName);
+
+	return succeeded;
+}
@@ -13,113 +13,145 @@
 
 #include "pch.h"
 #include "FileUtility.h"
-#include <fstream>
+#include "Compression.h"
+#include "FrameCounters.h"
+#include "IOScheduler.h"
+#include "InstrumentedMutex.h"
+#include "MemoryTracking.h"
+#include "StartupPrefetch.h"
 #include <mutex>
-#include <zlib.h> // From NuGet package
+#include <unordered_map>
 
 using namespace HolographicEngine::Utility;
 using namespace std;
 
-namespace HolographicEngine::Utility
-{
-	ByteArray NullFile = make_shared<vector<unsigned char> >(vector<unsigned char>());
-}
+ByteArray DecompressFile(const wstring& fileName, const HolographicEngine::Compression::Codec& codec);
 
-ByteArray DecompressZippedFile(wstring& fileName);
-
-ByteArray ReadFileHelper(const wstring& fileName)
+// A view of the mapped file; nothing is copied.  Returns false if the file cannot be opened.
+bool ReadFileHelper(const wstring& fileName, FileView& view)
 {
-	struct _stat64 fileStat;
-	int fileExists = _wstat64(fileName.c_str(), &fileStat);
-	if (fileExists == -1)
-		return NullFile;
-
-	ifstream file(fileName, ios::in | ios::binary);
-	if (!file)
-		return NullFile;
-
-	ByteArray byteArray = make_shared<vector<unsigned char> >(file.seekg(0, ios::end).tellg());
-	file.seekg(0, ios::beg).read((char*)byteArray->data(), byteArray->size());
-	file.close();
-
-	ASSERT(byteArray->size() == (size_t)fileStat.st_size);
+	shared_ptr<MappedFile> file = MappedFile::Open(fileName, kMapSequential);
+	if (file == nullptr)
+		return false;
 
-	return byteArray;
+	HolographicEngine::FrameCounters::Add(HolographicEngine::FrameCounters::kBytesRead, file->Size());
+	view = file->View();
+	return true;
 }
 
-ByteArray ReadFileHelperEx(shared_ptr<wstring> fileName)
+// A view of the decompressed bytes of a compressed copy.
+bool ReadCompressedCopy(const wstring& fileName, const HolographicEngine::Compression::Codec& codec, FileView& view)
 {
-	std::wstring zippedFileName = *fileName + L".gz";
-	ByteArray firstTry = DecompressZippedFile(zippedFileName);
-	if (firstTry != NullFile)
-		return firstTry;
+	ByteArray data = DecompressFile(fileName + codec.GetExtension(), codec);
+	if (data == NullFile)
+		return false;
 
-	return ReadFileHelper(*fileName);
+	view = FileView(std::move(data));
+	return true;
 }
 
-ByteArray Inflate(ByteArray CompressedSource, int& err, uint32_t ChunkSize = 0x100000)
+namespace
 {
-	// Create a dynamic buffer to hold compressed blocks
-	vector<unique_ptr<unsigned char> > blocks;
+	// The codec whose compressed copy each file name was last read from, or null for the plain file.
+	// Looking for a copy costs a failed open per codec, so a name is only probed again when what it was
+	// read from stops reading or WriteFileSync writes a new copy.  Names that read nothing are not kept,
+	// and past kMaxCompressedCopies names the map starts over, so probing for any number of files does
+	// not grow it without bound.
+	const size_t kMaxCompressedCopies = 4096;
 
-	z_stream strm = {};
-	strm.data_type = Z_BINARY;
-	strm.total_in = strm.avail_in = (uInt)CompressedSource->size();
-	strm.next_in = CompressedSource->data();
+	void ForgetCompressedCopy(const wstring& fileName);
 
-	err = inflateInit2(&strm, (15 + 32)); //15 window bits, and the +32 tells zlib to to detect if using gzip or zlib
+	struct CompressedCopies
+	{
+		// Nothing is remembered before the first read, so writes only need watching from then on.
+		CompressedCopies() { SetWriteObserver(&ForgetCompressedCopy); }
+
+		HolographicEngine::InstrumentedMutex Mutex{ "IO/Compressed Copies" };
+		unordered_map<wstring, const HolographicEngine::Compression::Codec*> Codecs;
+	};
 
-	while (err == Z_OK || err == Z_BUF_ERROR)
+	CompressedCopies& GetCompressedCopies(void)
 	{
-		strm.avail_out = ChunkSize;
-		strm.next_out = (unsigned char*)malloc(ChunkSize);
-		blocks.emplace_back(strm.next_out);
-		err = inflate(&strm, Z_NO_FLUSH);
+		static CompressedCopies s_CompressedCopies;
+		return s_CompressedCopies;
 	}
 
-	if (err != Z_STREAM_END)
+	// A new compressed copy, e.g. from Compression::CompressFile, is preferred from the next read on.
+	void ForgetCompressedCopy(const wstring& fileName)
 	{
-		inflateEnd(&strm);
-		return NullFile;
+		for (const HolographicEngine::Compression::Codec* codec : HolographicEngine::Compression::GetCodecs())
+		{
+			const size_t extensionLength = wcslen(codec->GetExtension());
+			if (fileName.size() > extensionLength &&
+				_wcsicmp(fileName.c_str() + fileName.size() - extensionLength, codec->GetExtension()) == 0)
+			{
+				CompressedCopies& copies = GetCompressedCopies();
+				lock_guard<HolographicEngine::InstrumentedMutex> guard(copies.Mutex);
+				copies.Codecs.erase(fileName.substr(0, fileName.size() - extensionLength));
+			}
+		}
 	}
+}
 
-	ASSERT(strm.total_out > 0, "Nothing to decompress");
-
-	HolographicEngine::Utility::ByteArray byteArray = make_shared<vector<unsigned char> >(strm.total_out);
+// Prefers a compressed copy of the file, trying each registered codec's extension in turn.  Returns
+// false if neither a copy nor the file can be read.
+bool ReadFileHelperEx(const wstring& fileName, FileView& view)
+{
+	CompressedCopies& copies = GetCompressedCopies();
+	const HolographicEngine::Compression::Codec* known = nullptr;
+	bool probed = false;
+	{
+		lock_guard<HolographicEngine::InstrumentedMutex> guard(copies.Mutex);
+		auto it = copies.Codecs.find(fileName);
+		if (it != copies.Codecs.end())
+		{
+			known = it->second;
+			probed = true;
+		}
+	}
 
-	// Allocate actual memory for this.
-	// copy the bits into that RAM.
-	// Free everything else up!!
-	void* curDest = byteArray->data();
-	size_t remaining = byteArray->size();
+	if (probed && (known == nullptr ? ReadFileHelper(fileName, view) : ReadCompressedCopy(fileName, *known, view)))
+		return true;
 
-	for (size_t i = 0; i < blocks.size(); ++i)
+	const HolographicEngine::Compression::Codec* found = nullptr;
+	for (const HolographicEngine::Compression::Codec* codec : HolographicEngine::Compression::GetCodecs())
 	{
-		ASSERT(remaining > 0);
+		if (ReadCompressedCopy(fileName, *codec, view))
+		{
+			found = codec;
+			break;
+		}
+	}
 
-		size_t CopySize = min(remaining, (size_t)ChunkSize);
+	const bool read = found != nullptr || ReadFileHelper(fileName, view);
 
-		memcpy(curDest, blocks[i].get(), CopySize);
-		curDest = (std::byte*)curDest + CopySize;
-		remaining -= CopySize;
+	lock_guard<HolographicEngine::InstrumentedMutex> guard(copies.Mutex);
+	if (!read)
+	{
+		copies.Codecs.erase(fileName);
+		return false;
 	}
 
-	inflateEnd(&strm);
+	if (copies.Codecs.size() >= kMaxCompressedCopies && copies.Codecs.find(fileName) == copies.Codecs.end())
+		copies.Codecs.clear();
 
-	return byteArray;
+	HolographicEngine::MemoryTracking::ScopedTag tag(HolographicEngine::MemoryTracking::kTagCache);
+	copies.Codecs[fileName] = found;
+	return true;
 }
 
-ByteArray DecompressZippedFile(wstring& fileName)
+ByteArray DecompressFile(const wstring& fileName, const HolographicEngine::Compression::Codec& codec)
 {
-	ByteArray CompressedFile = ReadFileHelper(fileName);
-	if (CompressedFile == NullFile)
+	// The compressed bytes are only read once, straight from the mapping.
+	shared_ptr<MappedFile> CompressedFile = MappedFile::Open(fileName, kMapSequential);
+	if (CompressedFile == nullptr)
 		return NullFile;
 
-	int error;
-	ByteArray DecompressedFile = Inflate(CompressedFile, error);
+	HolographicEngine::FrameCounters::Add(HolographicEngine::FrameCounters::kBytesRead, CompressedFile->Size());
+	ByteArray DecompressedFile = codec.Decompress(CompressedFile->View().Data(), CompressedFile->Size());
 	if (DecompressedFile->size() == 0)
 	{
-		HolographicEngine::Utility::Printf(L"Couldn't unzip file %s:  Error = %d\n", fileName.c_str(), error);
+		HolographicEngine::Utility::Printf(L"Couldn't decompress file %s with %S\n", fileName.c_str(), codec.GetName());
 		return NullFile;
 	}
 
@@ -128,13 +160,26 @@ ByteArray DecompressZippedFile(wstring& fileName)
 
 ByteArray HolographicEngine::Utility::ReadFileSync(const wstring& fileName)
 {
-	return ReadFileHelperEx(make_shared<wstring>(fileName));
+	MemoryTracking::ScopedTag tag(MemoryTracking::kTagIO);
+	FileView view;
+	if (!ReadFileHelperEx(fileName, view))
+		return NullFile;
+
+	// Decompressed bytes are handed over as they are; only a plain file is copied out of its mapping.
+	return view.ToByteArray();
+}
+
+FileView HolographicEngine::Utility::ReadFileViewSync(const wstring& fileName)
+{
+	MemoryTracking::ScopedTag tag(MemoryTracking::kTagIO);
+	FileView view;
+	ReadFileHelperEx(fileName, view);
+	return view;
 }
 
 task<ByteArray> HolographicEngine::Utility::ReadFileAsync(const wstring& fileName)
 {
-	shared_ptr<wstring> SharedPtr = make_shared<wstring>(fileName);
-	return create_task([=] { return ReadFileHelperEx(SharedPtr); });
+	return IOScheduler::ReadAsync(fileName);
 }
 
 ByteArray HolographicEngine::Utility::ReadFileUWPSync(const wstring& fileName)
@@ -142,14 +187,31 @@ ByteArray HolographicEngine::Utility::ReadFileUWPSync(const wstring& fileName)
 	using namespace winrt::Windows::Storage;
 	using namespace Concurrency;
 
+	MemoryTracking::ScopedTag tag(MemoryTracking::kTagIO);
+
 	auto asyncReadTask = PathIO::ReadBufferAsync(winrt::hstring(fileName.c_str()));
 
-	while (asyncReadTask.Status() != winrt::Windows::Foundation::AsyncStatus::Completed && asyncReadTask.Status() != winrt::Windows::Foundation::AsyncStatus::Error)
+	// Sleep until the completion handler fires instead of polling the status.  The handler runs at once if
+	// the read has already finished.
+	HANDLE completed = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	if (completed == nullptr)
+		return NullFile;
+
+	asyncReadTask.Completed([completed](auto const&, winrt::Windows::Foundation::AsyncStatus)
 	{
-		continue;
-	}
+		SetEvent(completed);
+	});
+
+	WaitForSingleObjectEx(completed, INFINITE, FALSE);
+	CloseHandle(completed);
+
+	if (asyncReadTask.Status() != winrt::Windows::Foundation::AsyncStatus::Completed)
+		return NullFile;
+
+	StartupPrefetch::RecordRequest(fileName);
 
 	auto readBufferTask = asyncReadTask.GetResults();
+	FrameCounters::Add(FrameCounters::kBytesRead, readBufferTask.Length());
 
 	ByteArray returnBuffer = make_shared<vector<unsigned char>>();
 
@@ -11,6 +11,8 @@
 #include <string>
 #include <ppl.h>
 
+struct z_stream_s;
+
 namespace HolographicEngine::Utility
 {
 	using namespace std;
@@ -21,14 +23,150 @@ namespace HolographicEngine::Utility
 	extern ByteArray NullFile;
 
 	// Reads the entire contents of a binary file.  If the file with the same name except with an additional
-	// ".gz" suffix exists, it will be loaded and decompressed instead.
+	// ".gz" suffix, or another registered codec's, exists, it will be loaded and decompressed instead.
+	// Which one exists is looked up once per name and remembered.
 	// This operation blocks until the entire file is read.
 	ByteArray ReadFileSync(const wstring& fileName);
 
-	// Same as previous except that it does not block but instead returns a task.
+	// Same as previous except that it does not block but instead returns a task.  The read goes through
+	// the IOScheduler at visible priority, so it shares a read with other requests for the same file.
 	task<ByteArray> ReadFileAsync(const wstring& fileName);
 
 	ByteArray ReadFileUWPSync(const wstring& fileName);
 
+	// Replaces the file with the given bytes.  A partly written file is deleted.  Returns false on failure.
+	bool WriteFileSync(const wstring& fileName, const void* data, size_t size);
+
+	// Called with the name of each file MappedFile::Open opens, and of each file WriteFileSync writes, on
+	// the thread that did so.  They let StartupPrefetch and the lookup of compressed copies follow file
+	// access without the file code depending on them.  Null, the default, is no observer.
+	typedef void (*FileObserver)(const wstring& fileName);
+	void SetOpenObserver(FileObserver observer);
+	void SetWriteObserver(FileObserver observer);
+
+	class MappedFile;
+
+	// A read-only range of bytes inside a MappedFile.  The view holds a reference to the file, so the
+	// memory stays mapped for as long as any view of it exists.  Copying a view copies no file data.
+	class FileView
+	{
+	public:
+		FileView() : m_Data(nullptr), m_Size(0) {}
+		FileView(shared_ptr<const MappedFile> file, const unsigned char* data, size_t size)
+			: m_File(std::move(file)), m_Data(data), m_Size(size) {}
+
+		// A view of all of the bytes, which it keeps alive.
+		explicit FileView(ByteArray bytes)
+			: m_Bytes(std::move(bytes)), m_Data(m_Bytes->data()), m_Size(m_Bytes->size()) {}
+
+		const unsigned char* Data(void) const { return m_Data; }
+		size_t Size(void) const { return m_Size; }
+		bool IsEmpty(void) const { return m_Size == 0; }
+
+		const unsigned char* begin(void) const { return m_Data; }
+		const unsigned char* end(void) const { return m_Data + m_Size; }
+		unsigned char operator[](size_t i) const { return m_Data[i]; }
+
+		// Offset and size are clamped to this view.
+		FileView SubView(size_t offset, size_t size = SIZE_MAX) const;
+
+		// Copies the bytes, for callers that need a ByteArray.  A view of a whole ByteArray returns that
+		// array instead, shared rather than copied.
+		ByteArray ToByteArray(void) const;
+
+	private:
+		// What keeps the bytes alive: a mapped file or a ByteArray, or neither for memory the caller owns.
+		shared_ptr<const MappedFile> m_File;
+		ByteArray m_Bytes;
+		const unsigned char* m_Data;
+		size_t m_Size;
+	};
+
+	// Same as ReadFileSync, for callers that only need to look at the bytes: a plain file is returned as
+	// a view of its mapping rather than copied, and a compressed copy as a view of the decompressed
+	// bytes.  An empty view if nothing can be read.
+	FileView ReadFileViewSync(const wstring& fileName);
+
+	// Tells the OS how a mapped file is going to be read, in the spirit of madvise().
+	enum MapHint
+	{
+		kMapNormal = 0,
+		kMapSequential = 1,    // Read front to back once; favors read-ahead
+		kMapRandom = 2,        // Read in scattered pieces; disables read-ahead
+		kMapWillNeed = 4,      // Start reading the whole file into memory now
+	};
+
+	// A whole file mapped read-only into memory.  Pages are read from disk the first time they are
+	// touched, so only the parts actually used become resident and nothing is copied.
+	class MappedFile : public enable_shared_from_this<MappedFile>
+	{
+	public:
+		// Returns nullptr if the file cannot be opened.  Hints is a combination of MapHint values.
+		static shared_ptr<MappedFile> Open(const wstring& fileName, uint32_t hints = kMapNormal);
+
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		size_t Size(void) const { return m_Size; }
+
+		FileView View(void) const { return View(0, m_Size); }
+		FileView View(size_t offset, size_t size) const;
+
+		// Asks the OS to start reading a range in the background so that later accesses do not fault.
+		// Offset and size are clamped to the file.
+		void Prefetch(size_t offset = 0, size_t size = SIZE_MAX) const;
+
+	private:
+		MappedFile(const unsigned char* base, size_t size) : m_Base(base), m_Size(size) {}
+
+		const unsigned char* m_Base;
+		size_t m_Size;
+	};
+
+	// Decompresses a zlib or gzip stream into buffers supplied by the caller, one chunk at a time, so
+	// the whole uncompressed file never has to be in memory at once.  Concatenated gzip members are read
+	// as one stream, as gunzip does.
+	class InflateStream
+	{
+	public:
+		// The view keeps the compressed data alive for the lifetime of the stream.
+		explicit InflateStream(FileView source);
+		~InflateStream();
+
+		InflateStream(const InflateStream&) = delete;
+		InflateStream& operator=(const InflateStream&) = delete;
+
+		// Decompresses up to size bytes into dest and returns how many were written.  Fewer than size
+		// are only returned at the end of the stream or on an error.
+		size_t Read(unsigned char* dest, size_t size);
+
+		bool IsFinished(void) const { return m_Finished; }
+		bool HasFailed(void) const { return m_Error != 0; }
+
+		// The zlib error code that stopped the stream, or 0.
+		int GetError(void) const { return m_Error; }
+
+		// Total bytes decompressed so far.
+		uint64_t GetTotalOut(void) const { return m_TotalOut; }
+
+		// The uncompressed size recorded in the gzip trailer, or 0 when the source is not gzip.  The
+		// trailer stores the size modulo 4 GB and only describes the last member, so this is a hint for
+		// presizing buffers, not a promise.
+		uint64_t GetSizeHint(void) const;
+
+	private:
+		FileView m_Source;
+		unique_ptr<z_stream_s> m_Stream;
+		uint64_t m_TotalOut;
+		int m_Error;
+		bool m_Finished;
+	};
+
+	// Decompresses a whole zlib or gzip buffer with a single allocation when the gzip trailer gives the
+	// size.  Returns NullFile and sets error to the zlib error code on failure.
+	ByteArray Inflate(const FileView& compressedSource, int& error);
+
 	//std::future<ByteArray> ReadDataAsync(const std::wstring_view& filename);
 } // namespace Utility
\ No newline at end of file
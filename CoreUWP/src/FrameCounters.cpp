@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "FrameCounters.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::FrameCounters;
+
+namespace
+{
+	const char* kCounterNames[kNumCounters] =
+	{
+		"objects considered",
+		"objects culled",
+		"objects drawn",
+		"draw calls",
+		"triangles",
+		"constant buffer bytes",
+		"state changes",
+		"cameras rendered",
+		"bytes read",
+	};
+
+	struct ThreadAccumulators;
+
+	struct Registry
+	{
+		std::mutex Mutex;
+		std::vector<ThreadAccumulators*> Threads;
+
+		// The final counts of the threads that have exited.
+		uint64_t Retired[kNumCounters] = {};
+
+		// The sum at the last Update, and the difference from the one before, readable without the lock.
+		uint64_t LastTotals[kNumCounters] = {};
+		std::atomic<uint64_t> Frame[kNumCounters] = {};
+	};
+
+	Registry& GetRegistry(void)
+	{
+		static Registry s_Registry;
+		return s_Registry;
+	}
+
+	// Only the owning thread writes its accumulators, so adding needs no atomic read-modify-write; they
+	// are atomic only so that Update can read them.
+	struct ThreadAccumulators
+	{
+		ThreadAccumulators()
+		{
+			Registry& r = GetRegistry();
+			std::lock_guard<std::mutex> guard(r.Mutex);
+			r.Threads.push_back(this);
+		}
+
+		~ThreadAccumulators()
+		{
+			Registry& r = GetRegistry();
+			std::lock_guard<std::mutex> guard(r.Mutex);
+			for (int i = 0; i < kNumCounters; ++i)
+				r.Retired[i] += Values[i].load(std::memory_order_relaxed);
+			r.Threads.erase(std::find(r.Threads.begin(), r.Threads.end(), this));
+		}
+
+		std::atomic<uint64_t> Values[kNumCounters] = {};
+	};
+
+	thread_local ThreadAccumulators t_Accumulators;
+
+	// With the registry locked.
+	Counts SumThreads(const Registry& r)
+	{
+		Counts Result;
+		for (int i = 0; i < kNumCounters; ++i)
+			Result.Values[i] = r.Retired[i];
+
+		for (const ThreadAccumulators* t : r.Threads)
+		{
+			for (int i = 0; i < kNumCounters; ++i)
+				Result.Values[i] += t->Values[i].load(std::memory_order_relaxed);
+		}
+		return Result;
+	}
+}
+
+const char* HolographicEngine::FrameCounters::GetCounterName(Counter counter)
+{
+	return counter < kNumCounters ? kCounterNames[counter] : "";
+}
+
+void HolographicEngine::FrameCounters::Add(Counter counter, uint64_t amount)
+{
+	std::atomic<uint64_t>& Value = t_Accumulators.Values[counter];
+	Value.store(Value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void HolographicEngine::FrameCounters::Update(void)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<std::mutex> guard(r.Mutex);
+
+	const Counts Totals = SumThreads(r);
+	for (int i = 0; i < kNumCounters; ++i)
+	{
+		r.Frame[i].store(Totals.Values[i] - r.LastTotals[i], std::memory_order_relaxed);
+		r.LastTotals[i] = Totals.Values[i];
+	}
+}
+
+Counts HolographicEngine::FrameCounters::GetFrameCounts(void)
+{
+	Registry& r = GetRegistry();
+
+	Counts Result;
+	for (int i = 0; i < kNumCounters; ++i)
+		Result.Values[i] = r.Frame[i].load(std::memory_order_relaxed);
+	return Result;
+}
+
+Counts HolographicEngine::FrameCounters::GetTotals(void)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<std::mutex> guard(r.Mutex);
+	return SumThreads(r);
+}
+
+void HolographicEngine::FrameCounters::Print(void)
+{
+	const Counts Frame = GetFrameCounts();
+
+	Utility::Printf("Frame counters:");
+	for (int i = 0; i < kNumCounters; ++i)
+		Utility::Printf("%s %llu %s", i == 0 ? "" : ",", (unsigned long long)Frame.Values[i], kCounterNames[i]);
+	Utility::Printf("\n");
+}
@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+// How much work each frame submits: objects, draws, triangles, constant buffer updates, state changes
+// and cameras from the rendering path, and the bytes FileUtility reads.
+//
+// Add goes to the calling thread's own accumulators, a plain load and store without a lock or a shared
+// cache line, so it can be called for every draw.  Update, at the start of each frame, sums every
+// thread's accumulators and keeps the difference from the last sum as the counts of the frame that just
+// ended.  Those can be read from any thread without a lock; EngineProfiling prints them with the frame
+// profile and MetricsPublisher exports the draws and triangles.
+
+namespace HolographicEngine::FrameCounters
+{
+	enum Counter
+	{
+		kObjectsConsidered,
+		kObjectsCulled,
+		kObjectsDrawn,
+		kDrawCalls,
+		kTriangles,
+		kConstantBufferBytes,
+		kStateChanges,
+		kCamerasRendered,
+		kBytesRead,
+		kNumCounters
+	};
+
+	const char* GetCounterName(Counter counter);
+
+	void Add(Counter counter, uint64_t amount = 1);
+
+	// A draw of triangle lists, with the vertex or index count passed to D3D.
+	inline void CountDraw(uint32_t vertexCount, uint32_t instanceCount = 1)
+	{
+		Add(kDrawCalls);
+		Add(kTriangles, (uint64_t)(vertexCount / 3) * instanceCount);
+	}
+
+	// The result of culling a set of objects down to the ones that are drawn.
+	inline void CountCulling(uint64_t considered, uint64_t visible)
+	{
+		Add(kObjectsConsidered, considered);
+		Add(kObjectsCulled, considered - visible);
+	}
+
+	// Closes the frame.  Called by the engine at the start of each frame, on the main thread.
+	void Update(void);
+
+	struct Counts
+	{
+		uint64_t Values[kNumCounters];
+
+		uint64_t operator[](Counter counter) const { return Values[counter]; }
+	};
+
+	// The last frame closed by Update.
+	Counts GetFrameCounts(void);
+
+	// Everything counted so far, including the frame in progress.
+	Counts GetTotals(void);
+
+	void Print(void);
+}
@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "FrameStats.h"
+#include "InstrumentedMutex.h"
+#include <algorithm>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::FrameStats;
+
+namespace
+{
+	struct State
+	{
+		InstrumentedMutex Mutex{ "Profiling/Frame Stats" };
+		double RefreshRate = kDefaultRefreshRate;
+
+		// A ring of the last frames, in milliseconds.
+		double Window[kWindowSize];
+		bool WindowMissed[kWindowSize];
+		uint32_t Next = 0;
+		uint32_t Count = 0;
+
+		uint64_t TotalFrames = 0;
+		uint64_t TotalMissedDeadlines = 0;
+		uint64_t TotalMissedVsyncs = 0;
+		double LastMs = 0.0;
+	};
+
+	State& GetState(void)
+	{
+		static State s_State;
+		return s_State;
+	}
+
+	// The value below which the given fraction of the sorted frames fall, by the nearest rank.
+	double Percentile(const std::vector<double>& Sorted, double Fraction)
+	{
+		if (Sorted.empty())
+			return 0.0;
+
+		const size_t Rank = (size_t)ceil(Fraction * Sorted.size());
+		return Sorted[Rank > 0 ? Rank - 1 : 0];
+	}
+}
+
+void HolographicEngine::FrameStats::SetRefreshRate(double hertz)
+{
+	if (hertz <= 0.0)
+		return;
+
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+	s.RefreshRate = hertz;
+}
+
+double HolographicEngine::FrameStats::GetRefreshRate(void)
+{
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+	return s.RefreshRate;
+}
+
+void HolographicEngine::FrameStats::AddFrame(double seconds)
+{
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+
+	// Rounded, so that ordinary jitter around one interval is not a miss.
+	const double Intervals = floor(seconds * s.RefreshRate + 0.5);
+	const bool Missed = Intervals >= 2.0;
+
+	const double Ms = seconds * 1000.0;
+	s.Window[s.Next] = Ms;
+	s.WindowMissed[s.Next] = Missed;
+	s.Next = (s.Next + 1) % kWindowSize;
+	s.Count = min(s.Count + 1, kWindowSize);
+
+	++s.TotalFrames;
+	if (Missed)
+	{
+		++s.TotalMissedDeadlines;
+		s.TotalMissedVsyncs += (uint64_t)Intervals - 1;
+	}
+	s.LastMs = Ms;
+}
+
+uint64_t HolographicEngine::FrameStats::GetFrameCount(void)
+{
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+	return s.TotalFrames;
+}
+
+uint32_t HolographicEngine::FrameStats::GetRecentFrames(double* milliseconds, uint32_t count)
+{
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+
+	count = min(count, s.Count);
+	for (uint32_t i = 0; i < count; ++i)
+		milliseconds[i] = s.Window[(s.Next + kWindowSize - count + i) % kWindowSize];
+	return count;
+}
+
+Summary HolographicEngine::FrameStats::GetSummary(void)
+{
+	State& s = GetState();
+	std::vector<double> Sorted;
+
+	Summary Result = {};
+	{
+		std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+
+		Result.TotalFrames = s.TotalFrames;
+		Result.TotalMissedDeadlines = s.TotalMissedDeadlines;
+		Result.TotalMissedVsyncs = s.TotalMissedVsyncs;
+		Result.NumFrames = s.Count;
+		Result.LastMs = s.LastMs;
+		Result.DeadlineMs = 1000.0 / s.RefreshRate;
+
+		Sorted.assign(s.Window, s.Window + s.Count);
+		for (uint32_t i = 0; i < s.Count; ++i)
+			Result.MissedDeadlines += s.WindowMissed[i] ? 1 : 0;
+	}
+
+	if (Sorted.empty())
+		return Result;
+
+	std::sort(Sorted.begin(), Sorted.end());
+
+	double Total = 0.0;
+	for (double Ms : Sorted)
+		Total += Ms;
+
+	Result.AverageMs = Total / Sorted.size();
+	Result.MinMs = Sorted.front();
+	Result.MaxMs = Sorted.back();
+	Result.P50Ms = Percentile(Sorted, 0.50);
+	Result.P95Ms = Percentile(Sorted, 0.95);
+	Result.P99Ms = Percentile(Sorted, 0.99);
+	return Result;
+}
+
+void HolographicEngine::FrameStats::GetHistogram(uint32_t (&counts)[kHistogramBuckets])
+{
+	memset(counts, 0, sizeof(counts));
+
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+
+	for (uint32_t i = 0; i < s.Count; ++i)
+		++counts[min((uint32_t)s.Window[i], kHistogramBuckets - 1)];
+}
+
+void HolographicEngine::FrameStats::Print(void)
+{
+	const Summary Stats = GetSummary();
+
+	Utility::Printf("Frames, last %u: avg %.2f ms, min %.2f, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f; "
+		"%u missed the %.2f ms deadline (%llu of %llu overall, %llu vsyncs)\n",
+		Stats.NumFrames, Stats.AverageMs, Stats.MinMs, Stats.P50Ms, Stats.P95Ms, Stats.P99Ms, Stats.MaxMs,
+		Stats.MissedDeadlines, Stats.DeadlineMs, Stats.TotalMissedDeadlines, Stats.TotalFrames, Stats.TotalMissedVsyncs);
+
+	uint32_t Histogram[kHistogramBuckets];
+	GetHistogram(Histogram);
+
+	for (uint32_t i = 0; i < kHistogramBuckets; ++i)
+	{
+		if (Histogram[i] == 0)
+			continue;
+
+		const std::string Bar(max(1u, Histogram[i] * 40 / max(1u, Stats.NumFrames)), '#');
+		if (i + 1 < kHistogramBuckets)
+			Utility::Printf("  %2u-%2u ms %5u %s\n", i, i + 1, Histogram[i], Bar.c_str());
+		else
+			Utility::Printf("  %2u+    ms %5u %s\n", i, Histogram[i], Bar.c_str());
+	}
+}
+
+void HolographicEngine::FrameStats::Reset(void)
+{
+	State& s = GetState();
+	std::lock_guard<InstrumentedMutex> guard(s.Mutex);
+
+	s.Next = 0;
+	s.Count = 0;
+	s.TotalFrames = 0;
+	s.TotalMissedDeadlines = 0;
+	s.TotalMissedVsyncs = 0;
+	s.LastMs = 0.0;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+// Statistics over the CPU frame times, measured from one present to the next.
+//
+// The last kWindowSize frames are kept for percentiles and the histogram.  A frame misses its deadline
+// when it spans two or more refresh intervals of the display; each interval beyond the first is a
+// missed vsync, when the previous image stayed on screen.  Graphics::Present adds every frame, and sets
+// the refresh rate from the holographic display when the platform reports it.
+
+namespace HolographicEngine::FrameStats
+{
+	const uint32_t kWindowSize = 512;
+
+	// One bucket per millisecond; the last one also counts every longer frame.
+	const uint32_t kHistogramBuckets = 50;
+
+	const double kDefaultRefreshRate = 60.0;
+
+	void SetRefreshRate(double hertz);
+	double GetRefreshRate(void);
+
+	void AddFrame(double seconds);
+
+	// Frames added since the last Reset.
+	uint64_t GetFrameCount(void);
+
+	// Copies up to count of the latest frame times, in milliseconds, oldest first.  Returns how many.
+	uint32_t GetRecentFrames(double* milliseconds, uint32_t count);
+
+	struct Summary
+	{
+		uint64_t TotalFrames;
+		uint64_t TotalMissedDeadlines;
+		uint64_t TotalMissedVsyncs;
+
+		// Over the window.
+		uint32_t NumFrames;
+		uint32_t MissedDeadlines;
+		double AverageMs;
+		double MinMs;
+		double MaxMs;
+		double P50Ms;
+		double P95Ms;
+		double P99Ms;
+
+		double LastMs;
+		double DeadlineMs;     // One refresh interval
+	};
+
+	Summary GetSummary(void);
+
+	// Counts of the window's frame times.
+	void GetHistogram(uint32_t (&counts)[kHistogramBuckets]);
+
+	void Print(void);
+	void Reset(void);
+}
@@ -0,0 +1,290 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "FrameWatchdog.h"
+#include "AssetCache.h"
+#include "AsyncIO.h"
+#include "EngineProfiling.h"
+#include "FileUtility.h"
+#include "FrameCounters.h"
+#include "FrameStats.h"
+#include "IOScheduler.h"
+#include "InstrumentedMutex.h"
+#include "MemoryTracking.h"
+
+using namespace HolographicEngine;
+
+namespace
+{
+	const char* kCapturePrefix = "Hitch_";
+
+	struct Watchdog
+	{
+		InstrumentedMutex Mutex{ "Profiling/Frame Watchdog" };
+		bool Enabled = FrameWatchdog::kDefaultEnabled;
+		double BudgetMs = 0.0;
+		uint32_t CaptureFrames = FrameWatchdog::kDefaultCaptureFrames;
+		uint32_t MaxCaptures = FrameWatchdog::kDefaultMaxCaptures;
+
+		uint64_t LastFrame = 0;
+		uint64_t NextAllowedFrame = 0;
+		uint32_t Captures = 0;
+		uint32_t Triggered = 0;
+		std::wstring LastCapturePath;
+	};
+
+	Watchdog& GetWatchdog(void)
+	{
+		static Watchdog s_Watchdog;
+		return s_Watchdog;
+	}
+
+	double GetBudgetMs(const Watchdog& w)
+	{
+		return w.BudgetMs > 0.0 ? w.BudgetMs : 1500.0 / FrameStats::GetRefreshRate();
+	}
+
+	// The sequence number keeps a capture taken with Capture from replacing one taken at the same frame.
+	std::wstring GetCapturePath(uint64_t frame, uint32_t sequence)
+	{
+		char Name[64];
+		snprintf(Name, sizeof(Name), "%s%llu_%u.json", kCapturePrefix, (unsigned long long)frame, sequence);
+		const std::wstring FileName(Name, Name + strlen(Name));
+
+		try
+		{
+			using namespace winrt::Windows::Storage;
+			return std::wstring(ApplicationData::Current().LocalFolder().Path().c_str()) + L"\\" + FileName;
+		}
+		catch (winrt::hresult_error const&)
+		{
+			// No package identity, so use the working directory.
+			return FileName;
+		}
+	}
+
+	void Append(std::string& Out, const char* Format, ...)
+	{
+		char Buffer[256];
+		va_list ap;
+		va_start(ap, Format);
+		vsnprintf(Buffer, sizeof(Buffer), Format, ap);
+		va_end(ap);
+		Out += Buffer;
+	}
+
+	// Scope names are string literals in the engine's code, so only quotes and backslashes need escaping.
+	void AppendName(std::string& Out, const char* Name)
+	{
+		Out += '"';
+		for (const char* c = Name; *c != 0; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				Out += '\\';
+			Out += (unsigned char)*c < 0x20 ? ' ' : *c;
+		}
+		Out += '"';
+	}
+
+	// The capture's metadata: why it was taken and the counters that usually explain a hitch.
+	std::string GetCaptureData(uint64_t frame, double budgetMs, uint32_t captureFrames)
+	{
+		std::string Json;
+		Append(Json, "{\"frame\":%llu,\"budgetMs\":%.3f", (unsigned long long)frame, budgetMs);
+
+		std::vector<double> Recent(captureFrames);
+		Recent.resize(FrameStats::GetRecentFrames(Recent.data(), captureFrames));
+		Json += ",\"frameMs\":[";
+		for (size_t i = 0; i < Recent.size(); ++i)
+			Append(Json, i == 0 ? "%.3f" : ",%.3f", Recent[i]);
+		Json += "]";
+
+		const FrameStats::Summary Frames = FrameStats::GetSummary();
+		Append(Json, ",\"frameStats\":{\"frames\":%u,\"averageMs\":%.3f,\"p50Ms\":%.3f,\"p95Ms\":%.3f,\"p99Ms\":%.3f,"
+			"\"maxMs\":%.3f,\"deadlineMs\":%.3f,\"missedDeadlines\":%u,\"totalFrames\":%llu,\"totalMissedDeadlines\":%llu,"
+			"\"totalMissedVsyncs\":%llu}", Frames.NumFrames, Frames.AverageMs, Frames.P50Ms, Frames.P95Ms, Frames.P99Ms,
+			Frames.MaxMs, Frames.DeadlineMs, Frames.MissedDeadlines, (unsigned long long)Frames.TotalFrames,
+			(unsigned long long)Frames.TotalMissedDeadlines, (unsigned long long)Frames.TotalMissedVsyncs);
+
+		// The scopes of the slow frame, which the profiler has just collected.
+		Append(Json, ",\"profilerFrame\":%llu,\"droppedMarkers\":%llu,\"scopes\":[",
+			(unsigned long long)EngineProfiling::GetFrameIndex(), (unsigned long long)EngineProfiling::GetDroppedCount());
+		bool First = true;
+		for (const EngineProfiling::ScopeStats& s : EngineProfiling::GetFrameStats())
+		{
+			if (s.Calls == 0)
+				continue;
+
+			Json += First ? "{\"name\":" : ",{\"name\":";
+			First = false;
+			AppendName(Json, s.Name);
+			Append(Json, ",\"thread\":%u,\"depth\":%u,\"calls\":%u,\"inclusiveMs\":%.3f,\"exclusiveMs\":%.3f,\"averageMs\":%.3f}",
+				s.Thread, s.Depth, s.Calls, s.InclusiveMs, s.ExclusiveMs, s.AverageMs);
+		}
+		Json += "]";
+
+		// What the slow frame submitted.
+		const FrameCounters::Counts Submitted = FrameCounters::GetFrameCounts();
+		Json += ",\"frameCounters\":{";
+		for (int i = 0; i < FrameCounters::kNumCounters; ++i)
+		{
+			if (i != 0)
+				Json += ',';
+			AppendName(Json, FrameCounters::GetCounterName((FrameCounters::Counter)i));
+			Append(Json, ":%llu", (unsigned long long)Submitted.Values[i]);
+		}
+		Json += "}";
+
+		// Allocations in the slow frame and what is live, by tag, in builds that track them.
+		if (MemoryTracking::IsEnabled())
+		{
+			const MemoryTracking::Stats Memory = MemoryTracking::GetStats();
+			Append(Json, ",\"memory\":{\"renderLoopBytes\":%llu,\"renderLoopAllocations\":%llu,\"tags\":[",
+				(unsigned long long)Memory.RenderLoopBytes, (unsigned long long)Memory.RenderLoopAllocations);
+			for (int i = 0; i < MemoryTracking::kNumTags; ++i)
+			{
+				const MemoryTracking::TagStats& t = Memory.Tags[i];
+				Json += i == 0 ? "{\"name\":" : ",{\"name\":";
+				AppendName(Json, MemoryTracking::GetTagName((MemoryTracking::Tag)i));
+				Append(Json, ",\"liveBytes\":%lld,\"liveAllocations\":%lld,\"frameBytes\":%llu,\"frameAllocations\":%llu}",
+					(long long)t.LiveBytes, (long long)t.LiveAllocations, (unsigned long long)t.FrameBytes,
+					(unsigned long long)t.FrameAllocations);
+			}
+			Json += "]}";
+		}
+
+		const AsyncIO::Stats IO = AsyncIO::GetStats();
+		Append(Json, ",\"asyncIO\":{\"submitted\":%llu,\"completed\":%llu,\"failed\":%llu,\"bytesRead\":%llu,\"inFlight\":%u}",
+			(unsigned long long)IO.Submitted, (unsigned long long)IO.Completed, (unsigned long long)IO.Failed,
+			(unsigned long long)IO.BytesRead, IO.InFlight);
+
+		const IOScheduler::Stats Scheduler = IOScheduler::GetStats();
+		uint32_t Queued = 0;
+		for (uint32_t QueueDepth : Scheduler.QueueDepth)
+			Queued += QueueDepth;
+		Append(Json, ",\"ioScheduler\":{\"queued\":%u,\"inFlight\":%u,\"issued\":%llu,\"averageLatencyMs\":%.3f,\"maxLatencyMs\":%.3f}",
+			Queued, Scheduler.InFlight, (unsigned long long)Scheduler.Issued, Scheduler.AverageLatencyMs, Scheduler.MaxLatencyMs);
+
+		const AssetCache::Stats Cache = AssetCache::GetStats();
+		Append(Json, ",\"assetCache\":{\"hits\":%llu,\"misses\":%llu,\"evictions\":%llu,\"entries\":%llu,\"bytes\":%llu}}",
+			(unsigned long long)Cache.Hits, (unsigned long long)Cache.Misses, (unsigned long long)Cache.Evictions,
+			(unsigned long long)Cache.NumEntries, (unsigned long long)Cache.BytesCached);
+
+		return Json;
+	}
+
+	// Takes the capture now, on the calling thread, and writes it in the background.
+	std::wstring CaptureLocked(Watchdog& w, uint64_t frame)
+	{
+		const std::wstring Path = GetCapturePath(frame, w.Captures);
+		const std::string Trace = EngineProfiling::GetChromeTrace(w.CaptureFrames,
+			GetCaptureData(frame, GetBudgetMs(w), w.CaptureFrames));
+
+		concurrency::create_task([Path, Trace] { Utility::WriteFileSync(Path, Trace.data(), Trace.size()); });
+
+		++w.Captures;
+		w.LastCapturePath = Path;
+		return Path;
+	}
+}
+
+void HolographicEngine::FrameWatchdog::SetBudget(double milliseconds)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	w.BudgetMs = max(0.0, milliseconds);
+}
+
+double HolographicEngine::FrameWatchdog::GetBudget(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	return GetBudgetMs(w);
+}
+
+void HolographicEngine::FrameWatchdog::SetCaptureFrames(uint32_t numFrames)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	w.CaptureFrames = max(1u, min(numFrames, (uint32_t)EngineProfiling::kMaxFrameMarks));
+}
+
+uint32_t HolographicEngine::FrameWatchdog::GetCaptureFrames(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	return w.CaptureFrames;
+}
+
+void HolographicEngine::FrameWatchdog::SetMaxCaptures(uint32_t maxCaptures)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	w.MaxCaptures = maxCaptures;
+}
+
+void HolographicEngine::FrameWatchdog::SetEnabled(bool enabled)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	w.Enabled = enabled;
+}
+
+bool HolographicEngine::FrameWatchdog::IsEnabled(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	return w.Enabled;
+}
+
+void HolographicEngine::FrameWatchdog::Update(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+
+	// Nothing to check unless a frame was presented since the last call.
+	const uint64_t Frame = FrameStats::GetFrameCount();
+	if (!w.Enabled || Frame == w.LastFrame)
+		return;
+	w.LastFrame = Frame;
+
+	if (w.Triggered >= w.MaxCaptures || Frame < w.NextAllowedFrame)
+		return;
+
+	double LastMs;
+	if (FrameStats::GetRecentFrames(&LastMs, 1) == 0 || LastMs <= GetBudgetMs(w))
+		return;
+
+	++w.Triggered;
+	w.NextAllowedFrame = Frame + w.CaptureFrames;
+
+	const std::wstring Path = CaptureLocked(w, Frame);
+	Utility::Printf(L"Frame %llu took %.2f ms, over the %.2f ms budget; captured to %s\n",
+		(unsigned long long)Frame, LastMs, GetBudgetMs(w), Path.c_str());
+}
+
+std::wstring HolographicEngine::FrameWatchdog::Capture(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	return CaptureLocked(w, FrameStats::GetFrameCount());
+}
+
+uint32_t HolographicEngine::FrameWatchdog::GetCaptureCount(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	return w.Captures;
+}
+
+std::wstring HolographicEngine::FrameWatchdog::GetLastCapturePath(void)
+{
+	Watchdog& w = GetWatchdog();
+	std::lock_guard<InstrumentedMutex> guard(w.Mutex);
+	return w.LastCapturePath;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <string>
+
+// Captures the frames around a hitch.
+//
+// Update compares the time of each frame with a budget.  When a frame goes over, the profiler spans of the
+// last few frames are written out as a Chrome trace, with the frame times, the FrameStats summary, the
+// profiler's scope times, FrameCounters and MemoryTracking tag totals for the slow frame and the IO and
+// cache counters as its metadata.  So a hitch on a device is caught as it happens without keeping a full
+// trace running.
+//
+// A capture is written in the background, to Hitch_<frame>_<n>.json in the app's local folder, where
+// <frame> counts the frames FrameStats has seen and <n> counts the captures taken in this run.  No other is taken until as many frames have passed as a capture
+// holds, so the frames slowed by one capture, or a run of slow frames, do not each trigger their own.
+
+namespace HolographicEngine::FrameWatchdog
+{
+	const uint32_t kDefaultCaptureFrames = 8;
+	const uint32_t kDefaultMaxCaptures = 16;
+
+	// HE_INSTRUMENTATION builds capture hitches from the start; others only once it is turned on.
+#ifdef HE_INSTRUMENTATION
+	const bool kDefaultEnabled = true;
+#else
+	const bool kDefaultEnabled = false;
+#endif
+
+	// Milliseconds.  Zero, the default, is one and a half refresh intervals, where FrameStats counts a
+	// missed deadline.
+	void SetBudget(double milliseconds);
+	double GetBudget(void);
+
+	void SetCaptureFrames(uint32_t numFrames);
+	uint32_t GetCaptureFrames(void);
+
+	// Captures in one run, at most, so a device that cannot keep up does not fill its storage.
+	void SetMaxCaptures(uint32_t maxCaptures);
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled(void);
+
+	// Checks the last frame.  Called every frame, after EngineProfiling::Update has collected it.
+	void Update(void);
+
+	// Captures the last frames now, whatever their times, and returns the file it is written to.  Does
+	// not count toward the maximum.
+	std::wstring Capture(void);
+
+	uint32_t GetCaptureCount(void);
+	std::wstring GetLastCapturePath(void);
+}
@@ -8,6 +8,16 @@
 #include "pch.h"
 #include "GameCore.h"
 #include "SystemTime.h"
+#include "CpuFeatures.h"
+#include "EngineProfiling.h"
+#include "EngineTuning.h"
+#include "AssetCache.h"
+#include "FrameCounters.h"
+#include "FrameWatchdog.h"
+#include "IOScheduler.h"
+#include "MemoryTracking.h"
+#include "MetricsPublisher.h"
+#include "StartupPrefetch.h"
 #include "Input/GameInput.h"
 
 using namespace winrt::Windows::ApplicationModel;
@@ -38,16 +48,63 @@ namespace HolographicEngine::GameCore
 
 	const bool TestGenerateMips = false;
 
+	// Engine settings that can be changed while the app runs; see EngineTuning.
+	IntVar s_AssetCacheMB("IO/Asset Cache MB", (int32_t)(AssetCache::kDefaultBudget >> 20), 0, 4096);
+	IntVar s_MaxReadsInFlight("IO/Max Reads In Flight", IOScheduler::kDefaultMaxInFlight, 1, 64);
+	BoolVar s_HitchCapture("Profiling/Hitch Capture", FrameWatchdog::kDefaultEnabled);
+	NumVar s_HitchBudgetMs("Profiling/Hitch Budget ms", 0.0f, 0.0f, 1000.0f);
+	IntVar s_HitchCaptureFrames("Profiling/Hitch Capture Frames", FrameWatchdog::kDefaultCaptureFrames, 1,
+		(int32_t)EngineProfiling::kMaxFrameMarks);
+	IntVar s_TraceFrames("Profiling/Trace Frames", EngineProfiling::kDefaultTraceFrames, 1,
+		(int32_t)EngineProfiling::kMaxFrameMarks);
+
+	// Passes the settings on to the modules they belong to, now and whenever one changes.
+	void ApplyEngineSettings(void)
+	{
+		AssetCache::SetBudget((size_t)s_AssetCacheMB << 20);
+		IOScheduler::SetMaxInFlight(s_MaxReadsInFlight);
+		FrameWatchdog::SetEnabled(s_HitchCapture);
+		FrameWatchdog::SetBudget(s_HitchBudgetMs);
+		FrameWatchdog::SetCaptureFrames(s_HitchCaptureFrames);
+
+		// The profiler keeps at least the frames a capture needs.
+		EngineProfiling::SetTraceFrames((uint32_t)max(s_TraceFrames.Get(), s_HitchCaptureFrames.Get()));
+	}
+
 	void LoadApplication(IGameApp& game)
 	{
 		//TODO(Sergio): Implement graphics stuff.
-		Graphics::Initialize();
+		EngineLog::Initialize();
 		SystemTime::Initialize();
-		GameInput::Initialize();
+		CpuFeatures::Initialize();
+
+		EngineTuning::Initialize();
+		EngineVar* const Settings[] = { &s_AssetCacheMB, &s_MaxReadsInFlight, &s_HitchCapture, &s_HitchBudgetMs, &s_HitchCaptureFrames, &s_TraceFrames };
+		for (EngineVar* Var : Settings)
+			Var->AddCallback([](EngineVar&) { ApplyEngineSettings(); });
+		ApplyEngineSettings();
+
+		MetricsPublisher::Initialize();
+
+		// Start reading last run's startup files while the device is created.
+		StartupPrefetch::Initialize();
+
+		{
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagGraphics);
+			Graphics::Initialize();
+		}
+		{
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagInput);
+			GameInput::Initialize();
+		}
+
+		// What the engine holds from here on is kept for the whole run, so it is not reported as leaked.
+		MemoryTracking::SetLeakBaseline();
 	}
 
 	void InitializeApplication(IGameApp& game)
 	{
+		MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagGame);
 		game.Startup();
 	}
 
@@ -63,19 +120,42 @@ namespace HolographicEngine::GameCore
 
 	void TerminateApplication(IGameApp& game)
 	{
+		MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagGame);
 		game.Cleanup();
 		GameInput::Shutdown();
 	}
 
 	bool UpdateApplication(IGameApp& game, HolographicSpace const& space, SpatialStationaryFrameOfReference const& reference)
 	{
-		//	EngineProfiling::Update();
+		MemoryTracking::Update();
+		FrameCounters::Update();
+		{
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagProfiling);
+			EngineProfiling::Update();
+			FrameWatchdog::Update();
+			MetricsPublisher::Update();
+		}
+		PROFILE_SCOPE("Frame");
+
 		float DeltaTime = Graphics::GetFrameTime();
 
-		GameInput::Update(DeltaTime);
-		//	EngineTuning::Update(DeltaTime);
+		{
+			PROFILE_SCOPE("GameInput::Update");
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagInput);
+			GameInput::Update(DeltaTime);
+		}
+		EngineTuning::Update(DeltaTime);
+		StartupPrefetch::Update();
+
+		{
+			PROFILE_SCOPE("Game::Update");
+			MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagGame);
+			game.Update(DeltaTime);
+		}
 
-		game.Update(DeltaTime);
+		// From here to the end of the frame is the render loop, which should not allocate once running.
+		MemoryTracking::RenderLoopScope RenderLoop;
+		MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagGraphics);
 
 		// Before doing the timer update, there is some work to do per-frame
 		// to maintain holographic rendering. First, we will get information
@@ -94,8 +174,15 @@ namespace HolographicEngine::GameCore
 		// resource views and depth buffers as needed.
 		Graphics::EnsureHolographicCameraResources(holographicFrame, prediction);
 
-		if (Graphics::Render(game, holographicFrame, reference))
+		bool rendered;
+		{
+			PROFILE_SCOPE("Graphics::Render");
+			rendered = Graphics::Render(game, holographicFrame, reference);
+		}
+
+		if (rendered)
 		{
+			PROFILE_SCOPE("Graphics::Present");
 			Graphics::Present(holographicFrame);
 		}
 
@@ -308,7 +395,15 @@ namespace HolographicEngine::GameCore
 	{
 		Graphics::Terminate();
 		TerminateApplication(*m_game);
+		IOScheduler::Shutdown();
+		StartupPrefetch::Shutdown();
 		Graphics::Shutdown();
+		MetricsPublisher::Shutdown();
+
+		// What the caches still hold is kept on purpose, not leaked.
+		AssetCache::Trim();
+		MemoryTracking::ReportLeaks();
+		EngineLog::Shutdown();
 	}
 
 	// Called when the application is activated.  For now, there is just one activation kind - Launch.
@@ -343,6 +438,8 @@ namespace HolographicEngine::GameCore
 		// and state are persisted when resuming from suspend. Note that this event
 		// does not occur if the app was previously terminated.
 
+		Graphics::Resume();
+
 		if (m_game != nullptr)
 			ResumeApplication(*m_game);
 	}
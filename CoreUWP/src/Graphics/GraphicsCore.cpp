@@ -2,6 +2,12 @@
 #include "GraphicsCore.h"
 #include "GameCore.h"
 #include "StereographicCameraResource.h"
+#include "AssetCache.h"
+#include "ShaderCache.h"
+#include "FrameCounters.h"
+#include "FrameStats.h"
+#include "InstrumentedMutex.h"
+#include "MemoryTracking.h"
 
 using namespace HolographicEngine::Math;
 using namespace DirectX;
@@ -47,11 +53,19 @@ ComPtr<ID3D11DeviceContext>            g_d3dContext;
 bool								   g_canGetHolographicDisplayForCamera;
 bool								   g_canCommitDirect3D11DepthBuffer;
 
+// Whether FrameStats can read the refresh rate from HolographicCamera.Display.  Kept apart from
+// g_canGetHolographicDisplayForCamera, which nothing sets, so the opaque display clear colour it guards
+// stays off.
+bool								   g_canGetDisplayRefreshRate;
+
 HolographicSpace m_holographicSpace = nullptr;
 
 // Back buffer resources, etc. for attached holographic cameras.
-std::map<UINT32, std::unique_ptr<HolographicEngine::Graphics::StereographicCameraResource>>      g_cameraResources;
-std::mutex												    g_cameraResourcesLock;
+typedef std::unique_ptr<HolographicEngine::Graphics::StereographicCameraResource> CameraResourcePtr;
+std::map<UINT32, CameraResourcePtr, std::less<UINT32>,
+	HolographicEngine::MemoryTracking::TaggedAllocator<std::pair<const UINT32, CameraResourcePtr>,
+	HolographicEngine::MemoryTracking::kTagGraphics>>						g_cameraResources;
+HolographicEngine::InstrumentedMutex						    g_cameraResourcesLock("Graphics/Camera Resources");
 
 winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice g_winRTD3DDevice;
 
@@ -169,12 +183,20 @@ void HolographicEngine::Graphics::Initialize(void)
 
 	//Create DeviceContext and ID3DDevice
 	CreateDeviceResources();
+
+	g_ShaderCache.SetDevice(std::make_shared<D3D11ShaderDevice>(g_Device));
+
+	// HolographicCamera.Display, and with it the refresh rate, arrived in Windows 10 1803.
+	g_canGetDisplayRefreshRate = winrt::Windows::Foundation::Metadata::ApiInformation::IsPropertyPresent(
+		L"Windows.Graphics.Holographic.HolographicCamera", L"Display");
 }
 
 // Call this method when the app suspends. It provides a hint to the driver that the app
 // is entering an idle state and that temporary buffers can be reclaimed for use by other apps.
 void HolographicEngine::Graphics::Trim(void)
 {
+	AssetCache::Trim();
+
 	g_d3dContext->ClearState();
 
 	ComPtr<IDXGIDevice3> dxgiDevice;
@@ -182,6 +204,14 @@ void HolographicEngine::Graphics::Trim(void)
 	dxgiDevice->Trim();
 }
 
+// Call this method when the app resumes.  The first frame after a suspension is not timed, like the
+// first frame after startup, so the time spent suspended is not counted as one long frame.
+void HolographicEngine::Graphics::Resume(void)
+{
+	s_FrameTime = 0.0f;
+	s_FrameStartTick = 0;
+}
+
 void HolographicEngine::Graphics::AttachHolographicSpace(HolographicSpace const& space)
 {
 	//Create a Holographic space for this window.
@@ -190,16 +220,20 @@ void HolographicEngine::Graphics::AttachHolographicSpace(HolographicSpace const&
 
 void HolographicEngine::Graphics::AddHolographicCamera(winrt::Windows::Graphics::Holographic::HolographicCamera const& camera)
 {
+	MemoryTracking::ScopedTag tag(MemoryTracking::kTagGraphics);
 	{
-		std::lock_guard<std::mutex> guard(g_cameraResourcesLock);
+		std::lock_guard<InstrumentedMutex> guard(g_cameraResourcesLock);
 		g_cameraResources[camera.Id()] = std::make_unique<StereographicCameraResource>(camera);
 	}
+
+	if (g_canGetDisplayRefreshRate)
+		FrameStats::SetRefreshRate(camera.Display().RefreshRate());
 }
 
 void HolographicEngine::Graphics::EnsureHolographicCameraResources(winrt::Windows::Graphics::Holographic::HolographicFrame const& frame, winrt::Windows::Graphics::Holographic::HolographicFramePrediction const& prediction)
 {
 	{
-		std::lock_guard<std::mutex> guard(g_cameraResourcesLock);
+		std::lock_guard<InstrumentedMutex> guard(g_cameraResourcesLock);
 
 		for (HolographicCameraPose pose : prediction.CameraPoses())
 		{
@@ -214,7 +248,7 @@ void HolographicEngine::Graphics::EnsureHolographicCameraResources(winrt::Window
 void HolographicEngine::Graphics::RemoveHolographicCamera(winrt::Windows::Graphics::Holographic::HolographicCamera const& camera)
 {
 	{
-		std::lock_guard<std::mutex> guard(g_cameraResourcesLock);
+		std::lock_guard<InstrumentedMutex> guard(g_cameraResourcesLock);
 
 		StereographicCameraResource* pCameraResources = g_cameraResources[camera.Id()].get();
 
@@ -238,6 +272,8 @@ void HolographicEngine::Graphics::Terminate(void)
 
 void HolographicEngine::Graphics::Shutdown(void)
 {
+	g_ShaderCache.SetDevice(nullptr);
+
 	SAFE_RELEASE(g_Device);
 	SAFE_RELEASE(g_Context);
 
@@ -261,7 +297,12 @@ void HolographicEngine::Graphics::Present(winrt::Windows::Graphics::Holographic:
 		HandleDeviceLost();
 	}
 
-	s_FrameTime = (float)SystemTime::TimeBetweenTicks(s_FrameStartTick, CurrentTick);
+	// The first frame, and the first after a resume, has nothing to be timed from.
+	if (s_FrameStartTick != 0)
+	{
+		s_FrameTime = (float)SystemTime::TimeBetweenTicks(s_FrameStartTick, CurrentTick);
+		FrameStats::AddFrame(s_FrameTime);
+	}
 
 	s_FrameStartTick = CurrentTick;
 	++s_FrameIndex;
@@ -275,7 +316,7 @@ bool HolographicEngine::Graphics::Render(GameCore::IGameApp& app, HolographicFra
 
 	bool atLeastOneCameraRendered = false;
 	{
-		std::lock_guard<std::mutex> guard(g_cameraResourcesLock);
+		std::lock_guard<InstrumentedMutex> guard(g_cameraResourcesLock);
 
 		for (auto cameraPose : prediction.CameraPoses())
 		{
@@ -285,6 +326,7 @@ bool HolographicEngine::Graphics::Render(GameCore::IGameApp& app, HolographicFra
 			ID3D11RenderTargetView* const targets[1] = { pCameraResources->GetRenderTargetView() };
 
 			g_Context->OMSetRenderTargets(1, targets, depthStencilView);
+			FrameCounters::Add(FrameCounters::kStateChanges);
 
 			// Clear the back buffer and depth stencil view.
 			if (g_canGetHolographicDisplayForCamera && cameraPose.HolographicCamera().Display().IsOpaque())
@@ -312,6 +354,8 @@ bool HolographicEngine::Graphics::Render(GameCore::IGameApp& app, HolographicFra
 			// Only render world-locked content when positional tracking is active.
 			if (cameraActive)
 			{
+				FrameCounters::Add(FrameCounters::kCamerasRendered);
+
 				// Draw the sample hologram.
 				app.RenderScene();
 
@@ -359,10 +403,10 @@ uint64_t HolographicEngine::Graphics::GetFrameCount(void)
 
 float HolographicEngine::Graphics::GetFrameTime(void)
 {
-	return s_FrameTime == 0.0f ? 0.0f : 1.0f / s_FrameTime;
+	return s_FrameTime;
 }
 
 float HolographicEngine::Graphics::GetFrameRate(void)
 {
-	return 0.0f;
+	return s_FrameTime == 0.0f ? 0.0f : 1.0f / s_FrameTime;
 }
\ No newline at end of file
@@ -21,6 +21,7 @@ namespace HolographicEngine::Graphics
 
 	void Resize(uint32_t width, uint32_t height);
 	void Trim();
+	void Resume(void);
 	void Terminate(void);
 	void Shutdown(void);
 
@@ -41,7 +42,8 @@ namespace HolographicEngine::Graphics
 	// between calls to present each frame.
 	float GetFrameTime(void);
 
-	// The total number of frames per second
+	// The total number of frames per second, from the last completed frame.  FrameStats has the
+	// distribution over recent frames.
 	float GetFrameRate(void);
 
 	extern uint32_t g_DisplayWidth;
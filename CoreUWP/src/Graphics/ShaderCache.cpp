@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "ShaderCache.h"
+#include "Archive.h"
+#include "AssetCache.h"
+#include "FrameCounters.h"
+#include "Hash.h"
+#include "MemoryTracking.h"
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Graphics;
+using namespace Microsoft::WRL;
+
+namespace HolographicEngine::Graphics
+{
+	ShaderCache g_ShaderCache;
+}
+
+namespace
+{
+	// Shared by every copy of the default loader, since the cache copies its loader before calling it.
+	struct ArchiveState
+	{
+		std::once_flag Opened;
+		std::shared_ptr<Utility::Archive> ShaderArchive;
+	};
+
+	ShaderCache::Loader CreateDefaultLoader(void)
+	{
+		std::shared_ptr<ArchiveState> state = std::make_shared<ArchiveState>();
+
+		return [state](const std::wstring& fileName)
+		{
+			if (fileName.empty())
+				return Utility::NullFile;
+
+			Utility::ByteArray bytecode = AssetCache::Find(fileName);
+			if (bytecode != Utility::NullFile)
+				return bytecode;
+
+			// The archive is opened on first use, since most apps never load a shader after startup.
+			std::call_once(state->Opened, [&]
+			{
+				MemoryTracking::ScopedTag tag(MemoryTracking::kTagCache);
+				state->ShaderArchive = Utility::Archive::Open(L"Shaders.pak");
+			});
+
+			if (state->ShaderArchive != nullptr)
+				bytecode = state->ShaderArchive->Read(fileName);
+			if (bytecode == Utility::NullFile)
+				bytecode = Utility::ReadFileUWPSync(fileName);
+			if (bytecode == Utility::NullFile)
+				return bytecode;
+
+			return AssetCache::Insert(fileName, bytecode);
+		};
+	}
+
+	bool IsEmpty(const Utility::ByteArray& bytecode)
+	{
+		return bytecode == nullptr || bytecode->empty();
+	}
+
+	uint64_t HashBytecode(const Utility::ByteArray& bytecode)
+	{
+		return Hash::Hash64(bytecode->data(), bytecode->size());
+	}
+}
+
+HRESULT D3D11ShaderDevice::CreateVertexShader(const void* bytecode, size_t size, ID3D11VertexShader** shader)
+{
+	return m_device->CreateVertexShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11ShaderDevice::CreateGeometryShader(const void* bytecode, size_t size, ID3D11GeometryShader** shader)
+{
+	return m_device->CreateGeometryShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11ShaderDevice::CreatePixelShader(const void* bytecode, size_t size, ID3D11PixelShader** shader)
+{
+	return m_device->CreatePixelShader(bytecode, size, nullptr, shader);
+}
+
+HRESULT D3D11ShaderDevice::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32_t numElements,
+	const void* bytecode, size_t size, ID3D11InputLayout** layout)
+{
+	return m_device->CreateInputLayout(elements, numElements, bytecode, size, layout);
+}
+
+HRESULT NullShaderDevice::CreateVertexShader(const void*, size_t, ID3D11VertexShader** shader)
+{
+	*shader = nullptr;
+	++m_numCreated;
+	return S_OK;
+}
+
+HRESULT NullShaderDevice::CreateGeometryShader(const void*, size_t, ID3D11GeometryShader** shader)
+{
+	*shader = nullptr;
+	++m_numCreated;
+	return S_OK;
+}
+
+HRESULT NullShaderDevice::CreatePixelShader(const void*, size_t, ID3D11PixelShader** shader)
+{
+	*shader = nullptr;
+	++m_numCreated;
+	return S_OK;
+}
+
+HRESULT NullShaderDevice::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, uint32_t, const void*, size_t, ID3D11InputLayout** layout)
+{
+	*layout = nullptr;
+	++m_numCreated;
+	return S_OK;
+}
+
+void ShaderProgram::Bind(ID3D11DeviceContext* context) const
+{
+	context->IASetInputLayout(InputLayout.Get());
+	context->VSSetShader(VertexShader.Get(), nullptr, 0);
+	context->GSSetShader(GeometryShader.Get(), nullptr, 0);
+	context->PSSetShader(PixelShader.Get(), nullptr, 0);
+	FrameCounters::Add(FrameCounters::kStateChanges, 4);
+}
+
+ShaderCache::ShaderCache(void) : m_loader(CreateDefaultLoader())
+{
+}
+
+void ShaderCache::SetDevice(std::shared_ptr<IShaderDevice> device)
+{
+	std::lock_guard<InstrumentedMutex> guard(m_mutex);
+
+	m_vertexShaders.clear();
+	m_geometryShaders.clear();
+	m_pixelShaders.clear();
+	m_inputLayouts.clear();
+	m_device = std::move(device);
+}
+
+void ShaderCache::SetLoader(Loader loader)
+{
+	std::lock_guard<InstrumentedMutex> guard(m_mutex);
+	m_loader = loader ? std::move(loader) : CreateDefaultLoader();
+}
+
+Utility::ByteArray ShaderCache::LoadBytecode(const std::wstring& fileName)
+{
+	Loader currentLoader;
+	{
+		std::lock_guard<InstrumentedMutex> guard(m_mutex);
+		currentLoader = m_loader;
+	}
+
+	// Called without the lock held, since it may read from disk.
+	return currentLoader(fileName);
+}
+
+template <typename T, typename CreateFn>
+ComPtr<T> ShaderCache::GetShader(ShaderMap<T>& map, const Utility::ByteArray& bytecode, CreateFn create)
+{
+	if (IsEmpty(bytecode))
+		return nullptr;
+
+	const uint64_t key = HashBytecode(bytecode);
+
+	std::lock_guard<InstrumentedMutex> guard(m_mutex);
+	ASSERT(m_device != nullptr, "The shader cache has no device");
+
+	++m_requests;
+	auto range = map.equal_range(key);
+	for (auto existing = range.first; existing != range.second; ++existing)
+	{
+		const Utility::ByteArray& cached = existing->second.Bytecode;
+		if (cached == bytecode || (cached->size() == bytecode->size() && memcmp(cached->data(), bytecode->data(), bytecode->size()) == 0))
+		{
+			++m_hits;
+			return existing->second.Shader;
+		}
+	}
+
+	CachedShader<T> result;
+	result.Bytecode = bytecode;
+	winrt::check_hresult(create(*m_device, bytecode->data(), bytecode->size(), result.Shader.GetAddressOf()));
+	MemoryTracking::ScopedTag tag(MemoryTracking::kTagCache);
+	map.emplace(key, result);
+	return result.Shader;
+}
+
+ComPtr<ID3D11VertexShader> ShaderCache::GetVertexShader(const Utility::ByteArray& bytecode)
+{
+	return GetShader(m_vertexShaders, bytecode, [](IShaderDevice& device, const void* data, size_t size, ID3D11VertexShader** shader)
+	{
+		return device.CreateVertexShader(data, size, shader);
+	});
+}
+
+ComPtr<ID3D11GeometryShader> ShaderCache::GetGeometryShader(const Utility::ByteArray& bytecode)
+{
+	return GetShader(m_geometryShaders, bytecode, [](IShaderDevice& device, const void* data, size_t size, ID3D11GeometryShader** shader)
+	{
+		return device.CreateGeometryShader(data, size, shader);
+	});
+}
+
+ComPtr<ID3D11PixelShader> ShaderCache::GetPixelShader(const Utility::ByteArray& bytecode)
+{
+	return GetShader(m_pixelShaders, bytecode, [](IShaderDevice& device, const void* data, size_t size, ID3D11PixelShader** shader)
+	{
+		return device.CreatePixelShader(data, size, shader);
+	});
+}
+
+ComPtr<ID3D11InputLayout> ShaderCache::GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32_t numElements,
+	const Utility::ByteArray& vertexShaderBytecode)
+{
+	if (IsEmpty(vertexShaderBytecode) || numElements == 0)
+		return nullptr;
+
+	// The semantic names are hashed by content, since callers often build the descriptions on the stack.
+	Hash::Hash64Stream keyHash;
+	for (uint32_t i = 0; i < numElements; ++i)
+	{
+		const D3D11_INPUT_ELEMENT_DESC& e = elements[i];
+		const uint32_t fields[] = { e.SemanticIndex, (uint32_t)e.Format, e.InputSlot, e.AlignedByteOffset,
+			(uint32_t)e.InputSlotClass, e.InstanceDataStepRate };
+
+		keyHash.Update(e.SemanticName, strlen(e.SemanticName) + 1);
+		keyHash.Update(fields, sizeof(fields));
+	}
+
+	const uint64_t bytecodeHash = HashBytecode(vertexShaderBytecode);
+	keyHash.Update(&bytecodeHash, sizeof(bytecodeHash));
+	const uint64_t key = keyHash.Digest();
+
+	std::lock_guard<InstrumentedMutex> guard(m_mutex);
+	ASSERT(m_device != nullptr, "The shader cache has no device");
+
+	++m_requests;
+	auto existing = m_inputLayouts.find(key);
+	if (existing != m_inputLayouts.end())
+	{
+		++m_hits;
+		return existing->second;
+	}
+
+	ComPtr<ID3D11InputLayout> result;
+	winrt::check_hresult(m_device->CreateInputLayout(elements, numElements, vertexShaderBytecode->data(),
+		vertexShaderBytecode->size(), result.GetAddressOf()));
+	MemoryTracking::ScopedTag tag(MemoryTracking::kTagCache);
+	m_inputLayouts.emplace(key, result);
+	return result;
+}
+
+ShaderProgram ShaderCache::LoadProgram(const ShaderProgramDesc& desc, bool useVprt)
+{
+	// A program missing a stage would draw nothing, so fail where the file is named instead.
+	auto loadStage = [this](const std::wstring& fileName)
+	{
+		Utility::ByteArray bytecode = LoadBytecode(fileName);
+		if (IsEmpty(bytecode))
+		{
+			throw winrt::hresult_error(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND), winrt::hstring(L"Couldn't load shader " + fileName));
+		}
+		return bytecode;
+	};
+
+	// The VPRT vertex shader writes the render target array index itself, which saves running a
+	// geometry shader stage for every triangle.
+	const Utility::ByteArray vertexBytecode = loadStage(useVprt ? desc.VprtVertexShader : desc.VertexShader);
+
+	ShaderProgram result;
+	result.UsesVprt = useVprt;
+	result.VertexShader = GetVertexShader(vertexBytecode);
+	result.PixelShader = GetPixelShader(loadStage(desc.PixelShader));
+	result.InputLayout = GetInputLayout(desc.InputElements, desc.NumInputElements, vertexBytecode);
+
+	if (!useVprt)
+		result.GeometryShader = GetGeometryShader(loadStage(desc.GeometryShader));
+
+	return result;
+}
+
+void ShaderCache::Clear(void)
+{
+	std::lock_guard<InstrumentedMutex> guard(m_mutex);
+
+	m_vertexShaders.clear();
+	m_geometryShaders.clear();
+	m_pixelShaders.clear();
+	m_inputLayouts.clear();
+	m_requests = 0;
+	m_hits = 0;
+}
+
+ShaderCache::Stats ShaderCache::GetStats(void)
+{
+	std::lock_guard<InstrumentedMutex> guard(m_mutex);
+
+	Stats result;
+	result.Requests = m_requests;
+	result.Hits = m_hits;
+	result.NumShaders = (uint32_t)(m_vertexShaders.size() + m_geometryShaders.size() + m_pixelShaders.size());
+	result.NumInputLayouts = (uint32_t)m_inputLayouts.size();
+	return result;
+}
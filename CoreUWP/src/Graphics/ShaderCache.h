@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "GraphicsCore.h"
+#include "FileUtility.h"
+#include "InstrumentedMutex.h"
+#include <functional>
+#include <unordered_map>
+
+// Creates each shader and input layout once, however many times it is asked for.
+//
+// Objects are keyed by a hash of their bytecode rather than by file name, so two files holding the same
+// compiled shader share one object.  The cache keeps the bytecode of each shader and compares it on a
+// hash hit, so bytecode that only hashes the same gets an object of its own.  Input layouts are keyed by their elements and the bytecode of the
+// vertex shader they were validated against.
+//
+// The cache talks to the GPU through an IShaderDevice.  Graphics::Initialize gives g_ShaderCache one over
+// g_Device; a NullShaderDevice creates nothing and only counts, which is enough to exercise the cache
+// without a GPU.
+
+namespace HolographicEngine::Graphics
+{
+	// The device calls the cache makes.  They have the same meaning as the ID3D11Device methods.
+	class IShaderDevice
+	{
+	public:
+		virtual ~IShaderDevice() {}
+
+		virtual HRESULT CreateVertexShader(const void* bytecode, size_t size, ID3D11VertexShader** shader) = 0;
+		virtual HRESULT CreateGeometryShader(const void* bytecode, size_t size, ID3D11GeometryShader** shader) = 0;
+		virtual HRESULT CreatePixelShader(const void* bytecode, size_t size, ID3D11PixelShader** shader) = 0;
+		virtual HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32_t numElements,
+			const void* bytecode, size_t size, ID3D11InputLayout** layout) = 0;
+	};
+
+	class D3D11ShaderDevice : public IShaderDevice
+	{
+	public:
+		explicit D3D11ShaderDevice(ID3D11Device* device) : m_device(device) {}
+
+		HRESULT CreateVertexShader(const void* bytecode, size_t size, ID3D11VertexShader** shader) override;
+		HRESULT CreateGeometryShader(const void* bytecode, size_t size, ID3D11GeometryShader** shader) override;
+		HRESULT CreatePixelShader(const void* bytecode, size_t size, ID3D11PixelShader** shader) override;
+		HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32_t numElements,
+			const void* bytecode, size_t size, ID3D11InputLayout** layout) override;
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D11Device> m_device;
+	};
+
+	// Succeeds without creating anything, so every object it hands out is null.
+	class NullShaderDevice : public IShaderDevice
+	{
+	public:
+		HRESULT CreateVertexShader(const void*, size_t, ID3D11VertexShader** shader) override;
+		HRESULT CreateGeometryShader(const void*, size_t, ID3D11GeometryShader** shader) override;
+		HRESULT CreatePixelShader(const void*, size_t, ID3D11PixelShader** shader) override;
+		HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, uint32_t, const void*, size_t, ID3D11InputLayout** layout) override;
+
+		uint32_t GetNumCreated(void) const { return m_numCreated; }
+
+	private:
+		uint32_t m_numCreated = 0;
+	};
+
+	// The files making up one pipeline.  Devices that can set the render target array index from the
+	// vertex shader use VprtVertexShader; the others use VertexShader followed by the pass-through
+	// GeometryShader.
+	struct ShaderProgramDesc
+	{
+		std::wstring VprtVertexShader;
+		std::wstring VertexShader;
+		std::wstring GeometryShader;
+		std::wstring PixelShader;
+		const D3D11_INPUT_ELEMENT_DESC* InputElements = nullptr;
+		uint32_t NumInputElements = 0;
+	};
+
+	struct ShaderProgram
+	{
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
+		Microsoft::WRL::ComPtr<ID3D11GeometryShader> GeometryShader;    // Null for the VPRT variant
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayout;
+		bool UsesVprt = false;
+
+		// Sets all four stages, clearing the geometry shader when the program has none.
+		void Bind(ID3D11DeviceContext* context) const;
+	};
+
+	class ShaderCache
+	{
+	public:
+		// Returns the bytecode in a file, or NullFile.
+		typedef std::function<Utility::ByteArray(const std::wstring&)> Loader;
+
+		ShaderCache(void);
+
+		// Drops every cached object, since they belong to the previous device.  Pass null to release them.
+		void SetDevice(std::shared_ptr<IShaderDevice> device);
+
+		// The default loader looks in Shaders.pak in the install folder, then for the loose file, and keeps
+		// what it reads in the AssetCache.  Tools/AssetPacker builds Shaders.pak from the compiled .cso
+		// files; SpiningCubeWinRT runs it as a build step and packages the result.
+		void SetLoader(Loader loader);
+		Utility::ByteArray LoadBytecode(const std::wstring& fileName);
+
+		// Each returns the cached object for this bytecode, creating it first if needed.  Empty bytecode
+		// gives null; a device failure throws, as creating the object directly would.
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> GetVertexShader(const Utility::ByteArray& bytecode);
+		Microsoft::WRL::ComPtr<ID3D11GeometryShader> GetGeometryShader(const Utility::ByteArray& bytecode);
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> GetPixelShader(const Utility::ByteArray& bytecode);
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32_t numElements,
+			const Utility::ByteArray& vertexShaderBytecode);
+
+		// Loads and creates the VPRT variant of the program when useVprt is set, and the geometry shader
+		// variant otherwise.  Throws winrt::hresult_error if a stage the variant needs cannot be read.
+		ShaderProgram LoadProgram(const ShaderProgramDesc& desc, bool useVprt = g_supportsVprt);
+
+		void Clear(void);
+
+		struct Stats
+		{
+			uint64_t Requests;
+			uint64_t Hits;
+			uint32_t NumShaders;
+			uint32_t NumInputLayouts;
+		};
+
+		Stats GetStats(void);
+
+	private:
+		template <typename T>
+		struct CachedShader
+		{
+			Utility::ByteArray Bytecode;
+			Microsoft::WRL::ComPtr<T> Shader;
+		};
+
+		template <typename T>
+		using ShaderMap = std::unordered_multimap<uint64_t, CachedShader<T> >;
+
+		template <typename T, typename CreateFn>
+		Microsoft::WRL::ComPtr<T> GetShader(ShaderMap<T>& map, const Utility::ByteArray& bytecode, CreateFn create);
+
+		InstrumentedMutex m_mutex{ "Graphics/Shader Cache" };
+		std::shared_ptr<IShaderDevice> m_device;
+		Loader m_loader;
+
+		ShaderMap<ID3D11VertexShader> m_vertexShaders;
+		ShaderMap<ID3D11GeometryShader> m_geometryShaders;
+		ShaderMap<ID3D11PixelShader> m_pixelShaders;
+		std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11InputLayout> > m_inputLayouts;
+
+		uint64_t m_requests = 0;
+		uint64_t m_hits = 0;
+	};
+
+	extern ShaderCache g_ShaderCache;
+}
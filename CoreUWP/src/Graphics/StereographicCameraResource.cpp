@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "StereographicCameraResource.h"
+#include "FrameCounters.h"
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -183,6 +184,7 @@ namespace HolographicEngine::Graphics
 		{
 			// Update the view and projection matrices in the actual GPU buffer.
 			context->UpdateSubresource(m_viewProjectionConstantBuffer.Get(), 0, nullptr, &viewProjectionConstantBufferData, 0, 0);
+			FrameCounters::Add(FrameCounters::kConstantBufferBytes, sizeof(viewProjectionConstantBufferData));
 
 			m_framePending = true;
 		}
@@ -203,6 +205,7 @@ namespace HolographicEngine::Graphics
 
 		// Send the constant buffer to the vertex shader.
 		context->VSSetConstantBuffers(1, 1, m_viewProjectionConstantBuffer.GetAddressOf());
+		FrameCounters::Add(FrameCounters::kStateChanges, 2);
 
 		// The template includes a pass-through geometry shader that is used by
 		// default on systems that don't support the D3D11_FEATURE_D3D11_OPTIONS3::
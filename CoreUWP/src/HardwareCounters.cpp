@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "HardwareCounters.h"
+#include "SystemTime.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::HardwareCounters;
+
+namespace
+{
+	const char* kCounterNames[kNumCounters] =
+	{
+		"cycles",
+		"instructions",
+		"L1D misses",
+		"LLC misses",
+		"branch misses",
+	};
+
+#if defined(__linux__)
+
+	struct CounterConfig
+	{
+		uint32_t Type;
+		uint64_t Config;
+	};
+
+	const CounterConfig kCounterConfigs[kNumCounters] =
+	{
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	};
+
+	// The thread's counter group.  The first counter that opens leads it, and the whole group is read at
+	// once, in the order the counters were opened.
+	struct ThreadCounters
+	{
+		ThreadCounters()
+		{
+			for (int i = 0; i < kNumCounters; ++i)
+			{
+				perf_event_attr Attr = {};
+				Attr.size = sizeof(Attr);
+				Attr.type = kCounterConfigs[i].Type;
+				Attr.config = kCounterConfigs[i].Config;
+				Attr.disabled = Leader < 0 ? 1 : 0;
+				Attr.exclude_kernel = 1;
+				Attr.exclude_hv = 1;
+				Attr.read_format = PERF_FORMAT_GROUP;
+
+				const int Fd = (int)syscall(__NR_perf_event_open, &Attr, 0, -1, Leader, 0);
+				if (Fd < 0)
+					continue;
+
+				if (Leader < 0)
+					Leader = Fd;
+				Fds[NumOpen] = Fd;
+				Order[NumOpen++] = (Counter)i;
+				Available |= 1u << i;
+			}
+
+			if (Leader >= 0)
+				ioctl(Leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+
+		~ThreadCounters()
+		{
+			for (uint32_t i = 0; i < NumOpen; ++i)
+				close(Fds[i]);
+		}
+
+		void Read(Sample& Result)
+		{
+			memset(&Result, 0, sizeof(Result));
+			if (Leader < 0)
+				return;
+
+			// The number of counters, then each count.
+			uint64_t Buffer[1 + kNumCounters];
+			if (read(Leader, Buffer, sizeof(Buffer)) < (ssize_t)sizeof(uint64_t))
+				return;
+
+			for (uint32_t i = 0; i < NumOpen && i < Buffer[0]; ++i)
+				Result.Values[Order[i]] = Buffer[1 + i];
+		}
+
+		int Leader = -1;
+		int Fds[kNumCounters];
+		Counter Order[kNumCounters];
+		uint32_t NumOpen = 0;
+		uint32_t Available = 0;
+	};
+
+#else
+
+	struct ThreadCounters
+	{
+		void Read(Sample& Result)
+		{
+			memset(&Result, 0, sizeof(Result));
+#if defined(_WIN32)
+			ULONG64 Cycles;
+			if (QueryThreadCycleTime(GetCurrentThread(), &Cycles))
+				Result.Values[kCycles] = Cycles;
+#endif
+		}
+
+#if defined(_WIN32)
+		uint32_t Available = 1u << kCycles;
+#else
+		uint32_t Available = 0;
+#endif
+	};
+
+#endif
+
+	thread_local ThreadCounters t_Counters;
+}
+
+const char* HolographicEngine::HardwareCounters::GetCounterName(Counter counter)
+{
+	return counter < kNumCounters ? kCounterNames[counter] : "";
+}
+
+uint32_t HolographicEngine::HardwareCounters::GetAvailable(void)
+{
+	return t_Counters.Available;
+}
+
+void HolographicEngine::HardwareCounters::Read(Sample& sample)
+{
+	t_Counters.Read(sample);
+}
+
+void HolographicEngine::HardwareCounters::CounterTimer::Start(void)
+{
+	if (m_Running)
+		return;
+
+	m_Running = true;
+	Read(m_Start);
+	m_StartTick = SystemTime::GetCurrentTick();
+}
+
+void HolographicEngine::HardwareCounters::CounterTimer::Stop(void)
+{
+	if (!m_Running)
+		return;
+
+	const int64_t EndTick = SystemTime::GetCurrentTick();
+	Sample End;
+	Read(End);
+
+	m_Running = false;
+	m_ElapsedTicks += EndTick - m_StartTick;
+	for (int i = 0; i < kNumCounters; ++i)
+		m_Counts.Values[i] += End.Values[i] - m_Start.Values[i];
+}
+
+void HolographicEngine::HardwareCounters::CounterTimer::Reset(void)
+{
+	m_Running = false;
+	m_StartTick = 0;
+	m_ElapsedTicks = 0;
+	memset(&m_Start, 0, sizeof(m_Start));
+	memset(&m_Counts, 0, sizeof(m_Counts));
+}
+
+double HolographicEngine::HardwareCounters::CounterTimer::GetTime(void) const
+{
+	return SystemTime::TicksToSeconds(m_ElapsedTicks);
+}
@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+// Hardware performance counters for the calling thread.
+//
+// On Linux the counters come from perf_event_open: cycles, instructions, L1 data cache read misses, last
+// level cache misses and branch misses, counted in user mode as one group so they cover the same
+// instructions.  Windows does not let an app program the PMU, so there only cycles are counted, through
+// QueryThreadCycleTime.  GetAvailable says which counters are live; the others always read zero.
+//
+// A thread's counters are opened the first time it reads them and closed when it exits.  A read is a
+// system call, around a microsecond, so counters belong around work of thousands of items, not single
+// calls.  CounterTimer accumulates them like CpuTimer accumulates time.
+
+namespace HolographicEngine::HardwareCounters
+{
+	enum Counter
+	{
+		kCycles,
+		kInstructions,
+		kL1DMisses,
+		kLLCMisses,
+		kBranchMisses,
+		kNumCounters
+	};
+
+	const char* GetCounterName(Counter counter);
+
+	struct Sample
+	{
+		uint64_t Values[kNumCounters];
+
+		uint64_t operator[](Counter counter) const { return Values[counter]; }
+
+		// Instructions per cycle, or 0 when either is not counted.
+		double GetIPC(void) const
+		{
+			return Values[kCycles] != 0 ? (double)Values[kInstructions] / Values[kCycles] : 0.0;
+		}
+	};
+
+	// Bit (1 << counter) is set for each counter this thread can read.
+	uint32_t GetAvailable(void);
+	inline bool IsAvailable(Counter counter) { return (GetAvailable() & (1u << counter)) != 0; }
+
+	// The calling thread's counts since its counters were opened.
+	void Read(Sample& sample);
+
+	// Counts between Start and Stop calls, summed, like CpuTimer.
+	class CounterTimer
+	{
+	public:
+		CounterTimer() { Reset(); }
+
+		void Start(void);
+		void Stop(void);
+		void Reset(void);
+
+		double GetTime(void) const;
+		const Sample& GetCounts(void) const { return m_Counts; }
+
+	private:
+		bool m_Running;
+		int64_t m_StartTick;
+		int64_t m_ElapsedTicks;
+		Sample m_Start;
+		Sample m_Counts;
+	};
+}
@@ -0,0 +1,271 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Hash.h"
+#include "CpuFeatures.h"
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Hash;
+
+namespace
+{
+	//
+	// CRC32C
+	//
+
+	const uint32_t kCastagnoli = 0x82F63B78;    // Reflected polynomial
+
+	// Table[k][b] is the CRC of byte b followed by k zero bytes, so eight table lookups advance the CRC by
+	// eight bytes at once.
+	struct Crc32CTables
+	{
+		uint32_t Table[8][256];
+
+		Crc32CTables()
+		{
+			for (uint32_t b = 0; b < 256; ++b)
+			{
+				uint32_t Crc = b;
+				for (int Bit = 0; Bit < 8; ++Bit)
+					Crc = (Crc >> 1) ^ (kCastagnoli & (0u - (Crc & 1)));
+				Table[0][b] = Crc;
+			}
+
+			for (uint32_t b = 0; b < 256; ++b)
+			{
+				for (int k = 1; k < 8; ++k)
+					Table[k][b] = (Table[k - 1][b] >> 8) ^ Table[0][Table[k - 1][b] & 0xFF];
+			}
+		}
+	};
+
+	const Crc32CTables& GetTables(void)
+	{
+		static Crc32CTables s_Tables;
+		return s_Tables;
+	}
+
+	__forceinline uint64_t Read64(const unsigned char* p)
+	{
+		uint64_t Value;
+		memcpy(&Value, p, sizeof(Value));
+		return Value;
+	}
+
+	__forceinline uint32_t Read32(const unsigned char* p)
+	{
+		uint32_t Value;
+		memcpy(&Value, p, sizeof(Value));
+		return Value;
+	}
+
+	// Takes and returns the CRC register, without the initial and final inversion.
+	uint32_t Crc32CScalar(uint32_t Crc, const unsigned char* p, size_t Size)
+	{
+		const Crc32CTables& t = GetTables();
+
+		for (; Size >= 8; Size -= 8, p += 8)
+		{
+			const uint32_t Low = Read32(p) ^ Crc;
+			const uint32_t High = Read32(p + 4);
+
+			Crc = t.Table[7][Low & 0xFF] ^ t.Table[6][(Low >> 8) & 0xFF] ^
+				t.Table[5][(Low >> 16) & 0xFF] ^ t.Table[4][Low >> 24] ^
+				t.Table[3][High & 0xFF] ^ t.Table[2][(High >> 8) & 0xFF] ^
+				t.Table[1][(High >> 16) & 0xFF] ^ t.Table[0][High >> 24];
+		}
+
+		for (; Size > 0; --Size, ++p)
+			Crc = (Crc >> 8) ^ t.Table[0][(Crc ^ *p) & 0xFF];
+
+		return Crc;
+	}
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+	uint32_t Crc32CSSE42(uint32_t Crc, const unsigned char* p, size_t Size)
+	{
+#if defined(_M_X64)
+		uint64_t Crc64 = Crc;
+		for (; Size >= 8; Size -= 8, p += 8)
+			Crc64 = _mm_crc32_u64(Crc64, Read64(p));
+		Crc = (uint32_t)Crc64;
+#endif
+		for (; Size >= 4; Size -= 4, p += 4)
+			Crc = _mm_crc32_u32(Crc, Read32(p));
+
+		for (; Size > 0; --Size, ++p)
+			Crc = _mm_crc32_u8(Crc, *p);
+
+		return Crc;
+	}
+
+#endif
+
+	typedef uint32_t(*Crc32CKernel)(uint32_t, const unsigned char*, size_t);
+
+	// SSE4.2 is not a tier of its own, so the instruction goes in the SSE4.1 slot when the CPU has it.
+	// That depends on the CPU, so unlike the other tables this one is built on first use.
+	CpuFeatures::DispatchTable<Crc32CKernel>& GetCrc32CKernels(void)
+	{
+#if defined(_M_IX86) || defined(_M_X64)
+		static CpuFeatures::DispatchTable<Crc32CKernel> s_Crc32CKernels(Crc32CScalar, nullptr,
+			CpuFeatures::Has(CpuFeatures::kFeatureSSE42) ? Crc32CSSE42 : nullptr);
+#else
+		static CpuFeatures::DispatchTable<Crc32CKernel> s_Crc32CKernels(Crc32CScalar);
+#endif
+		return s_Crc32CKernels;
+	}
+
+	//
+	// XXH64
+	//
+
+	const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+	const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+	const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+	__forceinline uint64_t RotateLeft(uint64_t x, int r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	__forceinline uint64_t Round(uint64_t Accumulator, uint64_t Input)
+	{
+		Accumulator += Input * kPrime2;
+		Accumulator = RotateLeft(Accumulator, 31);
+		return Accumulator * kPrime1;
+	}
+
+	__forceinline uint64_t MergeRound(uint64_t Hash, uint64_t Accumulator)
+	{
+		Hash ^= Round(0, Accumulator);
+		return Hash * kPrime1 + kPrime4;
+	}
+
+	void InitAccumulators(uint64_t v[4], uint64_t Seed)
+	{
+		v[0] = Seed + kPrime1 + kPrime2;
+		v[1] = Seed + kPrime2;
+		v[2] = Seed;
+		v[3] = Seed - kPrime1;
+	}
+
+	// Consumes whole 32-byte stripes and returns how many bytes that was.
+	size_t ConsumeStripes(uint64_t v[4], const unsigned char* p, size_t Size)
+	{
+		const unsigned char* Start = p;
+		for (; Size >= 32; Size -= 32, p += 32)
+		{
+			v[0] = Round(v[0], Read64(p));
+			v[1] = Round(v[1], Read64(p + 8));
+			v[2] = Round(v[2], Read64(p + 16));
+			v[3] = Round(v[3], Read64(p + 24));
+		}
+		return p - Start;
+	}
+
+	uint64_t MergeAccumulators(const uint64_t v[4])
+	{
+		uint64_t Hash = RotateLeft(v[0], 1) + RotateLeft(v[1], 7) + RotateLeft(v[2], 12) + RotateLeft(v[3], 18);
+		for (int i = 0; i < 4; ++i)
+			Hash = MergeRound(Hash, v[i]);
+		return Hash;
+	}
+
+	// Mixes in the last bytes, fewer than 32, and the length.
+	uint64_t Finalize(uint64_t Hash, uint64_t TotalSize, const unsigned char* p, size_t Size)
+	{
+		Hash += TotalSize;
+
+		for (; Size >= 8; Size -= 8, p += 8)
+			Hash = RotateLeft(Hash ^ Round(0, Read64(p)), 27) * kPrime1 + kPrime4;
+
+		if (Size >= 4)
+		{
+			Hash = RotateLeft(Hash ^ (Read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+			Size -= 4;
+			p += 4;
+		}
+
+		for (; Size > 0; --Size, ++p)
+			Hash = RotateLeft(Hash ^ (*p * kPrime5), 11) * kPrime1;
+
+		Hash ^= Hash >> 33;
+		Hash *= kPrime2;
+		Hash ^= Hash >> 29;
+		Hash *= kPrime3;
+		Hash ^= Hash >> 32;
+		return Hash;
+	}
+}
+
+uint32_t HolographicEngine::Hash::Crc32C(const void* data, size_t size, uint32_t crc)
+{
+	return ~GetCrc32CKernels().Get()(~crc, (const unsigned char*)data, size);
+}
+
+uint64_t HolographicEngine::Hash::Hash64(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	uint64_t Hash;
+
+	if (size >= 32)
+	{
+		uint64_t v[4];
+		InitAccumulators(v, seed);
+		const size_t Consumed = ConsumeStripes(v, p, size);
+		Hash = MergeAccumulators(v);
+		return Finalize(Hash, size, p + Consumed, size - Consumed);
+	}
+
+	Hash = seed + kPrime5;
+	return Finalize(Hash, size, p, size);
+}
+
+void Hash64Stream::Reset(uint64_t seed)
+{
+	InitAccumulators(m_Accumulators, seed);
+	m_Seed = seed;
+	m_TotalSize = 0;
+	m_BufferSize = 0;
+}
+
+void Hash64Stream::Update(const void* data, size_t size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	m_TotalSize += size;
+
+	// Top up a partial stripe first.
+	if (m_BufferSize > 0)
+	{
+		const size_t Fill = min(size, sizeof(m_Buffer) - m_BufferSize);
+		memcpy(m_Buffer + m_BufferSize, p, Fill);
+		m_BufferSize += (uint32_t)Fill;
+		p += Fill;
+		size -= Fill;
+
+		if (m_BufferSize < sizeof(m_Buffer))
+			return;
+
+		ConsumeStripes(m_Accumulators, m_Buffer, sizeof(m_Buffer));
+		m_BufferSize = 0;
+	}
+
+	const size_t Consumed = ConsumeStripes(m_Accumulators, p, size);
+	memcpy(m_Buffer, p + Consumed, size - Consumed);
+	m_BufferSize = (uint32_t)(size - Consumed);
+}
+
+uint64_t Hash64Stream::Digest(void) const
+{
+	const uint64_t Hash = m_TotalSize >= 32 ? MergeAccumulators(m_Accumulators) : m_Seed + kPrime5;
+	return Finalize(Hash, m_TotalSize, m_Buffer, m_BufferSize);
+}
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "FileUtility.h"
+
+// Fast non-cryptographic checksums for validating data and keying caches.
+//
+// Crc32C is the Castagnoli CRC used by iSCSI and ext4.  It runs on the SSE4.2 crc32 instruction when the
+// CPU has it and the active CpuFeatures tier is at least SSE4.1, and on slicing-by-8 tables otherwise;
+// both give the same result.  Hash64 is XXH64, which is faster still and has a much wider result, so it
+// is the better key; Crc32C is the better checksum where a format already stores 32 bits.
+//
+// Both can be computed a piece at a time.  Crc32C continues from a previous result; Hash64 uses a
+// Hash64Stream.
+
+namespace HolographicEngine::Hash
+{
+	// Pass the previous result as crc to continue a checksum over data split into pieces.
+	uint32_t Crc32C(const void* data, size_t size, uint32_t crc = 0);
+	inline uint32_t Crc32C(const Utility::FileView& view) { return Crc32C(view.Data(), view.Size()); }
+
+	uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+	inline uint64_t Hash64(const Utility::FileView& view) { return Hash64(view.Data(), view.Size()); }
+
+	// Gives the same result as Hash64 over all the data passed to Update.
+	class Hash64Stream
+	{
+	public:
+		explicit Hash64Stream(uint64_t seed = 0) { Reset(seed); }
+
+		void Reset(uint64_t seed = 0);
+		void Update(const void* data, size_t size);
+		uint64_t Digest(void) const;
+
+	private:
+		uint64_t m_Accumulators[4];
+		uint64_t m_Seed;
+		uint64_t m_TotalSize;
+		unsigned char m_Buffer[32];
+		uint32_t m_BufferSize;
+	};
+}
@@ -0,0 +1,342 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "IOScheduler.h"
+#include "InstrumentedMutex.h"
+#include "SystemTime.h"
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::IOScheduler;
+
+namespace
+{
+	struct Request
+	{
+		wstring FileName;
+		Priority CurrentPriority;
+		task_completion_event<ByteArray> Event;
+		int64_t RequestTick;
+
+		// Callers that have not canceled.  A request nobody is waiting for is dropped if it has not started.
+		uint32_t NumWaiters;
+		bool Started;
+		bool Dropped;
+		bool Finished;
+
+		std::vector<std::pair<cancellation_token, cancellation_token_registration> > Registrations;
+	};
+
+	typedef shared_ptr<Request> RequestPtr;
+
+	struct Scheduler
+	{
+		InstrumentedMutex Mutex{ "IO/Scheduler" };
+		std::condition_variable_any Idle;
+
+		// Every request that is queued or in flight, by file name.
+		std::unordered_map<wstring, RequestPtr> Requests;
+
+		// A promoted request is left behind in its old queue and skipped when it comes up there.
+		std::deque<RequestPtr> Queues[kNumPriorities];
+
+		uint32_t QueueDepth[kNumPriorities] = {};
+		uint32_t MaxInFlight = kDefaultMaxInFlight;
+		uint32_t InFlight = 0;
+		uint32_t PrefetchInFlight = 0;
+		bool ShuttingDown = false;
+
+		uint64_t Issued = 0;
+		uint64_t Coalesced = 0;
+		uint64_t Cancelled = 0;
+		uint64_t Completed = 0;
+		double TotalLatencyMs = 0.0;
+		double MaxLatencyMs = 0.0;
+	};
+
+	Scheduler& GetScheduler(void)
+	{
+		static Scheduler s_Scheduler;
+		return s_Scheduler;
+	}
+
+	void Start(const std::vector<RequestPtr>& Requests);
+
+	// Takes as many requests off the queues as there are free slots, highest priority first.  The caller
+	// starts them once it has released the lock.
+	std::vector<RequestPtr> TakeRunnable(Scheduler& s)
+	{
+		std::vector<RequestPtr> Runnable;
+		const uint32_t MaxPrefetches = max(s.MaxInFlight / 2, 1u);
+
+		for (int p = 0; p < kNumPriorities; ++p)
+		{
+			std::deque<RequestPtr>& Queue = s.Queues[p];
+			while (!Queue.empty() && s.InFlight < s.MaxInFlight)
+			{
+				if (p == kPriorityPrefetch && s.PrefetchInFlight >= MaxPrefetches)
+					break;
+
+				RequestPtr r = Queue.front();
+				Queue.pop_front();
+
+				if (r->Started || r->Dropped || r->CurrentPriority != p)
+					continue;
+
+				r->Started = true;
+				--s.QueueDepth[p];
+				++s.InFlight;
+				if (p == kPriorityPrefetch)
+					++s.PrefetchInFlight;
+				++s.Issued;
+
+				Runnable.push_back(r);
+			}
+		}
+
+		return Runnable;
+	}
+
+	void Complete(const RequestPtr& r, ByteArray Result)
+	{
+		Scheduler& s = GetScheduler();
+		std::vector<RequestPtr> Runnable;
+
+		{
+			std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+
+			auto it = s.Requests.find(r->FileName);
+			if (it != s.Requests.end() && it->second == r)
+				s.Requests.erase(it);
+
+			r->Finished = true;
+			--s.InFlight;
+			if (r->CurrentPriority == kPriorityPrefetch)
+				--s.PrefetchInFlight;
+
+			const double LatencyMs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - r->RequestTick);
+			++s.Completed;
+			s.TotalLatencyMs += LatencyMs;
+			s.MaxLatencyMs = max(s.MaxLatencyMs, LatencyMs);
+
+			if (!s.ShuttingDown)
+				Runnable = TakeRunnable(s);
+		}
+
+		s.Idle.notify_all();
+
+		r->Event.set(Result);
+
+		// Finished is set, so a callback that runs now does nothing.  Deregistering waits for one that is
+		// already running, which is why the lock is not held here.
+		for (auto& Registration : r->Registrations)
+			Registration.first.deregister_callback(Registration.second);
+
+		Start(Runnable);
+	}
+
+	void Start(const std::vector<RequestPtr>& Requests)
+	{
+		for (const RequestPtr& r : Requests)
+		{
+			create_task([r] { return Utility::ReadFileSync(r->FileName); })
+				.then([r](task<ByteArray> Read)
+			{
+				ByteArray Result = Utility::NullFile;
+				try
+				{
+					Result = Read.get();
+				}
+				catch (...)
+				{
+				}
+				Complete(r, Result);
+			});
+		}
+	}
+
+	void OnCanceled(const RequestPtr& r)
+	{
+		Scheduler& s = GetScheduler();
+		std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+
+		if (r->Finished || r->Dropped || --r->NumWaiters > 0 || r->Started)
+			return;
+
+		r->Dropped = true;
+		--s.QueueDepth[r->CurrentPriority];
+		++s.Cancelled;
+		s.Requests.erase(r->FileName);
+	}
+}
+
+task<ByteArray> HolographicEngine::IOScheduler::ReadAsync(const wstring& fileName, Priority priority, cancellation_token token)
+{
+	Scheduler& s = GetScheduler();
+	RequestPtr r;
+	std::vector<RequestPtr> Runnable;
+
+	{
+		std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+
+		if (s.ShuttingDown)
+			return task_from_result(Utility::NullFile);
+
+		auto it = s.Requests.find(fileName);
+		if (it != s.Requests.end())
+		{
+			r = it->second;
+			++r->NumWaiters;
+			++s.Coalesced;
+
+			if (!r->Started && priority < r->CurrentPriority)
+			{
+				--s.QueueDepth[r->CurrentPriority];
+				++s.QueueDepth[priority];
+				r->CurrentPriority = priority;
+				s.Queues[priority].push_back(r);
+			}
+		}
+		else
+		{
+			r = make_shared<Request>();
+			r->FileName = fileName;
+			r->CurrentPriority = priority;
+			r->RequestTick = SystemTime::GetCurrentTick();
+			r->NumWaiters = 1;
+			r->Started = false;
+			r->Dropped = false;
+			r->Finished = false;
+
+			s.Requests.emplace(fileName, r);
+			s.Queues[priority].push_back(r);
+			++s.QueueDepth[priority];
+		}
+
+		Runnable = TakeRunnable(s);
+	}
+
+	Start(Runnable);
+
+	// The caller's task is canceled by its own token, whatever happens to the shared read.
+	task<ByteArray> Result(r->Event, task_options(token));
+
+	if (token.is_cancelable())
+	{
+		cancellation_token_registration Registration = token.register_callback([r] { OnCanceled(r); });
+
+		bool Kept = false;
+		{
+			std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+			if (!r->Finished)
+			{
+				r->Registrations.emplace_back(token, Registration);
+				Kept = true;
+			}
+		}
+
+		if (!Kept)
+			token.deregister_callback(Registration);
+	}
+
+	return Result;
+}
+
+void HolographicEngine::IOScheduler::SetMaxInFlight(uint32_t maxInFlight)
+{
+	ASSERT(maxInFlight > 0, "At least one read has to be allowed in flight");
+
+	Scheduler& s = GetScheduler();
+	std::vector<RequestPtr> Runnable;
+	{
+		std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+		s.MaxInFlight = maxInFlight;
+		if (!s.ShuttingDown)
+			Runnable = TakeRunnable(s);
+	}
+	Start(Runnable);
+}
+
+uint32_t HolographicEngine::IOScheduler::GetMaxInFlight(void)
+{
+	Scheduler& s = GetScheduler();
+	std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+	return s.MaxInFlight;
+}
+
+Stats HolographicEngine::IOScheduler::GetStats(void)
+{
+	Scheduler& s = GetScheduler();
+	std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+
+	Stats Result;
+	for (int p = 0; p < kNumPriorities; ++p)
+		Result.QueueDepth[p] = s.QueueDepth[p];
+	Result.InFlight = s.InFlight;
+	Result.Issued = s.Issued;
+	Result.Coalesced = s.Coalesced;
+	Result.Cancelled = s.Cancelled;
+	Result.AverageLatencyMs = s.Completed > 0 ? s.TotalLatencyMs / s.Completed : 0.0;
+	Result.MaxLatencyMs = s.MaxLatencyMs;
+	return Result;
+}
+
+void HolographicEngine::IOScheduler::ResetStats(void)
+{
+	Scheduler& s = GetScheduler();
+	std::lock_guard<InstrumentedMutex> Guard(s.Mutex);
+
+	s.Issued = 0;
+	s.Coalesced = 0;
+	s.Cancelled = 0;
+	s.Completed = 0;
+	s.TotalLatencyMs = 0.0;
+	s.MaxLatencyMs = 0.0;
+}
+
+void HolographicEngine::IOScheduler::Shutdown(void)
+{
+	Scheduler& s = GetScheduler();
+	std::vector<RequestPtr> Dropped;
+
+	{
+		std::unique_lock<InstrumentedMutex> Lock(s.Mutex);
+		s.ShuttingDown = true;
+
+		for (auto& Queue : s.Queues)
+		{
+			for (const RequestPtr& r : Queue)
+			{
+				if (!r->Started && !r->Dropped)
+				{
+					r->Dropped = true;
+					r->Finished = true;
+					Dropped.push_back(r);
+				}
+			}
+			Queue.clear();
+		}
+
+		for (uint32_t& Depth : s.QueueDepth)
+			Depth = 0;
+
+		for (const RequestPtr& r : Dropped)
+			s.Requests.erase(r->FileName);
+
+		s.Idle.wait(Lock, [&s] { return s.InFlight == 0; });
+	}
+
+	for (const RequestPtr& r : Dropped)
+	{
+		r->Event.set_exception(std::make_exception_ptr(task_canceled()));
+		for (auto& Registration : r->Registrations)
+			Registration.first.deregister_callback(Registration.second);
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "FileUtility.h"
+
+// Queues file reads by priority and runs a limited number of them at once.
+//
+// A read of a file that is already queued or being read joins the existing request instead of starting
+// another, and every caller gets the same ByteArray.  A caller that no longer needs its file cancels the
+// token it passed in; its task is canceled at once, and the read itself is dropped if it has not started
+// and no other caller is waiting on it.  A queued request is promoted when a caller asks for the same file
+// at a higher priority.
+
+namespace HolographicEngine::IOScheduler
+{
+	using namespace std;
+	using namespace concurrency;
+	using Utility::ByteArray;
+
+	enum Priority
+	{
+		kPriorityCritical,     // Needed to finish the current frame or load
+		kPriorityVisible,      // On screen soon
+		kPriorityPrefetch,     // May be needed later
+		kNumPriorities
+	};
+
+	struct Stats
+	{
+		uint32_t QueueDepth[kNumPriorities];
+		uint32_t InFlight;
+		uint64_t Issued;          // Reads actually started
+		uint64_t Coalesced;       // Requests that joined one already queued or in flight
+		uint64_t Cancelled;       // Queued reads dropped because every caller canceled
+		double AverageLatencyMs;  // From the first request to completion, including the time queued
+		double MaxLatencyMs;
+	};
+
+	// Reads through Utility::ReadFileSync, so compressed copies are found the same way.  The task
+	// completes with NullFile if the file cannot be read.
+	task<ByteArray> ReadAsync(const wstring& fileName, Priority priority = kPriorityVisible,
+		cancellation_token token = cancellation_token::none());
+
+	const uint32_t kDefaultMaxInFlight = 4;
+
+	// Reads started at once, at most.  Prefetches only use half of them, so that a critical or visible
+	// request never waits for a queue full of prefetches to drain.
+	void SetMaxInFlight(uint32_t maxInFlight);
+	uint32_t GetMaxInFlight(void);
+
+	Stats GetStats(void);
+	void ResetStats(void);
+
+	// Drops every queued read, canceling its callers, and waits for those in flight to finish.
+	void Shutdown(void);
+}
@@ -0,0 +1,217 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "InstrumentedMutex.h"
+#include "MemoryTracking.h"
+#include "SystemTime.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::LockStats;
+
+namespace HolographicEngine::LockStats
+{
+	struct Counters
+	{
+		const char* Name;
+		std::atomic<uint32_t> Instances;
+		std::atomic<uint64_t> Acquisitions;
+		std::atomic<uint64_t> Contended;
+		std::atomic<int64_t> TotalWaitTicks;
+		std::atomic<int64_t> MaxWaitTicks;
+		std::atomic<int64_t> TotalHoldTicks;
+		std::atomic<int64_t> MaxHoldTicks;
+		std::atomic<uint64_t> WaitHistogram[kHistogramBuckets];
+	};
+}
+
+namespace
+{
+	// Locked only to add a name, never to take an InstrumentedMutex, so it is a plain mutex.
+	struct Registry
+	{
+		std::mutex Mutex;
+		std::deque<Counters> Locks;
+	};
+
+	// Never destroyed: global mutexes may still be taken while the other statics are destroyed.
+	Registry& GetRegistry(void)
+	{
+		static Registry* s_Registry = new Registry;
+		return *s_Registry;
+	}
+
+	void UpdateMax(std::atomic<int64_t>& Max, int64_t Value)
+	{
+		int64_t Current = Max.load(std::memory_order_relaxed);
+		while (Value > Current && !Max.compare_exchange_weak(Current, Value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	uint32_t GetBucket(int64_t WaitTicks)
+	{
+		const double Microseconds = SystemTime::TicksToSeconds(WaitTicks) * 1e6;
+
+		uint32_t Bucket = 0;
+		for (double Limit = 1.0; Bucket + 1 < kHistogramBuckets && Microseconds >= Limit; Limit *= 2.0)
+			++Bucket;
+		return Bucket;
+	}
+
+	double TicksToMs(int64_t Ticks)
+	{
+		return SystemTime::TicksToSeconds(Ticks) * 1000.0;
+	}
+}
+
+Counters* HolographicEngine::LockStats::Register(const char* name)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<std::mutex> guard(r.Mutex);
+
+	for (Counters& c : r.Locks)
+	{
+		if (strcmp(c.Name, name) == 0)
+		{
+			c.Instances.fetch_add(1, std::memory_order_relaxed);
+			return &c;
+		}
+	}
+
+	// A deque never moves what it holds, and value-initializes the atomics to zero.
+	MemoryTracking::ScopedTag Tagged(MemoryTracking::kTagProfiling);
+	r.Locks.emplace_back();
+	Counters& c = r.Locks.back();
+	c.Name = name;
+	c.Instances.store(1, std::memory_order_relaxed);
+	return &c;
+}
+
+std::vector<Stats> HolographicEngine::LockStats::GetStats(void)
+{
+	Registry& r = GetRegistry();
+	std::vector<Stats> Result;
+	{
+		std::lock_guard<std::mutex> guard(r.Mutex);
+		for (const Counters& c : r.Locks)
+		{
+			Stats s;
+			s.Name = c.Name;
+			s.Instances = c.Instances.load(std::memory_order_relaxed);
+			s.Acquisitions = c.Acquisitions.load(std::memory_order_relaxed);
+			s.Contended = c.Contended.load(std::memory_order_relaxed);
+			s.TotalWaitMs = TicksToMs(c.TotalWaitTicks.load(std::memory_order_relaxed));
+			s.MaxWaitMs = TicksToMs(c.MaxWaitTicks.load(std::memory_order_relaxed));
+			s.TotalHoldMs = TicksToMs(c.TotalHoldTicks.load(std::memory_order_relaxed));
+			s.MaxHoldMs = TicksToMs(c.MaxHoldTicks.load(std::memory_order_relaxed));
+			for (uint32_t b = 0; b < kHistogramBuckets; ++b)
+				s.WaitHistogram[b] = c.WaitHistogram[b].load(std::memory_order_relaxed);
+			Result.push_back(s);
+		}
+	}
+
+	std::sort(Result.begin(), Result.end(), [](const Stats& a, const Stats& b) { return strcmp(a.Name, b.Name) < 0; });
+	return Result;
+}
+
+void HolographicEngine::LockStats::Reset(void)
+{
+	Registry& r = GetRegistry();
+	std::lock_guard<std::mutex> guard(r.Mutex);
+
+	for (Counters& c : r.Locks)
+	{
+		c.Acquisitions.store(0, std::memory_order_relaxed);
+		c.Contended.store(0, std::memory_order_relaxed);
+		c.TotalWaitTicks.store(0, std::memory_order_relaxed);
+		c.MaxWaitTicks.store(0, std::memory_order_relaxed);
+		c.TotalHoldTicks.store(0, std::memory_order_relaxed);
+		c.MaxHoldTicks.store(0, std::memory_order_relaxed);
+		for (std::atomic<uint64_t>& Bucket : c.WaitHistogram)
+			Bucket.store(0, std::memory_order_relaxed);
+	}
+}
+
+void HolographicEngine::LockStats::Print(void)
+{
+	const std::vector<Stats> Locks = GetStats();
+	if (Locks.empty())
+		return;
+
+	Utility::Printf("Locks, ms: acquisitions (contended), wait total (max), hold total (max); waits by microseconds\n");
+	for (const Stats& s : Locks)
+	{
+		if (s.Acquisitions == 0)
+			continue;
+
+		Utility::Printf("  %s x%u: %llu (%llu), %.3f (%.3f), %.3f (%.3f);", s.Name, s.Instances,
+			(unsigned long long)s.Acquisitions, (unsigned long long)s.Contended, s.TotalWaitMs, s.MaxWaitMs,
+			s.TotalHoldMs, s.MaxHoldMs);
+
+		for (uint32_t b = 0; b < kHistogramBuckets; ++b)
+		{
+			if (s.WaitHistogram[b] == 0)
+				continue;
+			if (b + 1 == kHistogramBuckets)
+				Utility::Printf(" >=%u: %llu", 1u << (b - 1), (unsigned long long)s.WaitHistogram[b]);
+			else
+				Utility::Printf(" <%u: %llu", 1u << b, (unsigned long long)s.WaitHistogram[b]);
+		}
+		Utility::Printf("\n");
+	}
+}
+
+#if ENABLE_LOCK_STATS
+
+void InstrumentedMutex::lock(void)
+{
+	int64_t WaitTicks = 0;
+	if (m_Mutex.try_lock())
+	{
+		m_LockTick = SystemTime::GetCurrentTick();
+	}
+	else
+	{
+		const int64_t StartTick = SystemTime::GetCurrentTick();
+		m_Mutex.lock();
+		m_LockTick = SystemTime::GetCurrentTick();
+		WaitTicks = m_LockTick - StartTick;
+
+		m_Counters->Contended.fetch_add(1, std::memory_order_relaxed);
+		m_Counters->TotalWaitTicks.fetch_add(WaitTicks, std::memory_order_relaxed);
+		UpdateMax(m_Counters->MaxWaitTicks, WaitTicks);
+	}
+
+	m_Counters->Acquisitions.fetch_add(1, std::memory_order_relaxed);
+	m_Counters->WaitHistogram[WaitTicks == 0 ? 0 : GetBucket(WaitTicks)].fetch_add(1, std::memory_order_relaxed);
+}
+
+bool InstrumentedMutex::try_lock(void)
+{
+	if (!m_Mutex.try_lock())
+		return false;
+
+	m_LockTick = SystemTime::GetCurrentTick();
+	m_Counters->Acquisitions.fetch_add(1, std::memory_order_relaxed);
+	m_Counters->WaitHistogram[0].fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void InstrumentedMutex::unlock(void)
+{
+	const int64_t HoldTicks = SystemTime::GetCurrentTick() - m_LockTick;
+	m_Counters->TotalHoldTicks.fetch_add(HoldTicks, std::memory_order_relaxed);
+	UpdateMax(m_Counters->MaxHoldTicks, HoldTicks);
+
+	m_Mutex.unlock();
+}
+
+#endif
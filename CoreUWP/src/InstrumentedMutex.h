@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// A mutex that measures itself: how often it is taken, how often a thread had to wait for it, a
+// histogram of the waits, and how long it is held.  Mutexes with the same name, such as the members of
+// one class, add up to one set of statistics.
+//
+// InstrumentedMutex works with std::lock_guard and std::unique_lock like std::mutex, and with
+// std::condition_variable_any.  Taking it free costs a try_lock and a clock read; only a thread that has
+// to wait reads the clock twice.  The statistics are opt-in, kept only in builds that define
+// HE_INSTRUMENTATION or ENABLE_LOCK_STATS; otherwise it is a plain std::mutex and LockStats has nothing
+// to report.
+
+#ifndef ENABLE_LOCK_STATS
+#ifdef HE_INSTRUMENTATION
+#define ENABLE_LOCK_STATS 1
+#else
+#define ENABLE_LOCK_STATS 0
+#endif
+#endif
+
+namespace HolographicEngine
+{
+	namespace LockStats
+	{
+		// Bucket 0 has the waits under a microsecond, bucket b those under 2^b microseconds, and the last
+		// one every longer wait.
+		const uint32_t kHistogramBuckets = 24;
+
+		struct Stats
+		{
+			const char* Name;
+			uint32_t Instances;
+			uint64_t Acquisitions;
+			uint64_t Contended;			// Acquisitions that had to wait
+			double TotalWaitMs;
+			double MaxWaitMs;
+			double TotalHoldMs;
+			double MaxHoldMs;
+			uint64_t WaitHistogram[kHistogramBuckets];
+		};
+
+		// The counters a named lock adds to.  Never freed, so a mutex can outlive everything else.
+		struct Counters;
+
+		Counters* Register(const char* name);
+
+		// Every named lock, by name.
+		std::vector<Stats> GetStats(void);
+		void Reset(void);
+		void Print(void);
+	}
+
+#if ENABLE_LOCK_STATS
+
+	class InstrumentedMutex
+	{
+	public:
+		// The name must be a string literal.
+		explicit InstrumentedMutex(const char* name) : m_Counters(LockStats::Register(name)) {}
+
+		void lock(void);
+		bool try_lock(void);
+		void unlock(void);
+
+	private:
+		InstrumentedMutex(const InstrumentedMutex&) = delete;
+		InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+		std::mutex m_Mutex;
+		LockStats::Counters* m_Counters;
+
+		// Written by the owner only, while it holds the lock.
+		int64_t m_LockTick = 0;
+	};
+
+#else
+
+	class InstrumentedMutex : public std::mutex
+	{
+	public:
+		explicit InstrumentedMutex(const char*) {}
+	};
+
+#endif
+}
@@ -0,0 +1,350 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Compression.h"
+
+using namespace HolographicEngine::Compression;
+using namespace HolographicEngine::Utility;
+
+// A byte-oriented LZ77 codec built for decompression speed rather than ratio.  There is no entropy coding:
+// the stream is a series of sequences, each a run of literals copied as is followed by a match copied from
+// earlier output, so decoding is little more than memcpy.
+//
+//    File     "LZB1", uint64_t decompressed size, sequences
+//    Sequence token, [literal length bytes], literals, [uint16_t offset, [match length bytes]]
+//
+// The high nibble of the token is the literal count and the low nibble the match length minus 4.  A
+// nibble of 15 continues in the following bytes, each added to it, until a byte less than 255.  Offsets
+// are little-endian and from 1 to 65535.  The last sequence has no match; it ends when the output is full.
+
+namespace
+{
+	const unsigned char kMagic[4] = { 'L', 'Z', 'B', '1' };
+	const size_t kHeaderSize = sizeof(kMagic) + sizeof(uint64_t);
+
+	const size_t kMinMatch = 4;
+	const size_t kMaxOffset = 65535;
+	const int kHashBits = 16;
+
+	// Decoding copies in blocks of this size where the buffers leave room to overshoot.
+	const size_t kWildCopySize = 16;
+
+	__forceinline uint32_t Read32(const unsigned char* p)
+	{
+		uint32_t Value;
+		memcpy(&Value, p, sizeof(Value));
+		return Value;
+	}
+
+	__forceinline uint32_t Hash(uint32_t Sequence)
+	{
+		return (Sequence * 2654435761u) >> (32 - kHashBits);
+	}
+
+	// Copies NumBytes, possibly writing up to kWildCopySize - 1 bytes past the end.
+	__forceinline void WildCopy(unsigned char* Dest, const unsigned char* Source, size_t NumBytes)
+	{
+		unsigned char* End = Dest + NumBytes;
+		do
+		{
+			memcpy(Dest, Source, kWildCopySize);
+			Dest += kWildCopySize;
+			Source += kWildCopySize;
+		} while (Dest < End);
+	}
+
+#if defined(_M_X64) || defined(_M_ARM64)
+	typedef uint64_t MatchWord;
+
+	__forceinline size_t FirstDifferentByte(MatchWord Difference)
+	{
+		unsigned long Bit;
+		_BitScanForward64(&Bit, Difference);
+		return Bit / 8;
+	}
+#else
+	typedef uint32_t MatchWord;
+
+	__forceinline size_t FirstDifferentByte(MatchWord Difference)
+	{
+		unsigned long Bit;
+		_BitScanForward(&Bit, Difference);
+		return Bit / 8;
+	}
+#endif
+
+	// Length of the common prefix of a and b, stopping at bEnd.  Compares a word at a time.
+	size_t CountMatch(const unsigned char* a, const unsigned char* b, const unsigned char* bEnd)
+	{
+		const unsigned char* Start = b;
+
+		while (b + sizeof(MatchWord) <= bEnd)
+		{
+			MatchWord x, y;
+			memcpy(&x, a, sizeof(x));
+			memcpy(&y, b, sizeof(y));
+			if (x != y)
+				return (b - Start) + FirstDifferentByte(x ^ y);
+
+			a += sizeof(MatchWord);
+			b += sizeof(MatchWord);
+		}
+
+		while (b < bEnd && *a == *b)
+		{
+			++a;
+			++b;
+		}
+
+		return b - Start;
+	}
+
+	void WriteLength(vector<unsigned char>& Out, size_t Length)
+	{
+		for (; Length >= 255; Length -= 255)
+			Out.push_back(255);
+		Out.push_back((unsigned char)Length);
+	}
+
+	void WriteSequence(vector<unsigned char>& Out, const unsigned char* Literals, size_t NumLiterals, size_t Offset, size_t MatchLength)
+	{
+		const size_t MatchCode = MatchLength > 0 ? MatchLength - kMinMatch : 0;
+		Out.push_back((unsigned char)((min(NumLiterals, (size_t)15) << 4) | min(MatchCode, (size_t)15)));
+
+		if (NumLiterals >= 15)
+			WriteLength(Out, NumLiterals - 15);
+
+		Out.insert(Out.end(), Literals, Literals + NumLiterals);
+
+		if (MatchLength == 0)
+			return;
+
+		Out.push_back((unsigned char)(Offset & 0xFF));
+		Out.push_back((unsigned char)(Offset >> 8));
+
+		if (MatchCode >= 15)
+			WriteLength(Out, MatchCode - 15);
+	}
+
+	// Reads the continuation bytes of a nibble that was 15.  Returns false if the input runs out.
+	__forceinline bool ReadLength(const unsigned char*& In, const unsigned char* InEnd, size_t& Length)
+	{
+		unsigned char Byte;
+		do
+		{
+			if (In == InEnd)
+				return false;
+			Byte = *In++;
+			Length += Byte;
+		} while (Byte == 255);
+
+		return true;
+	}
+
+	class LZCodec : public Codec
+	{
+	public:
+		const char* GetName(void) const override { return "LZB"; }
+		const wchar_t* GetExtension(void) const override { return L".lzb"; }
+
+		bool MatchesHeader(const unsigned char* data, size_t size) const override
+		{
+			return size >= kHeaderSize && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+		}
+
+		bool GetDecompressedSize(const unsigned char* data, size_t size, uint64_t& decompressedSize) const override
+		{
+			if (!MatchesHeader(data, size))
+				return false;
+
+			memcpy(&decompressedSize, data + sizeof(kMagic), sizeof(decompressedSize));
+			return true;
+		}
+
+		bool DecompressInto(const unsigned char* data, size_t size, unsigned char* dest, size_t destSize) const override
+		{
+			uint64_t decompressedSize;
+			if (!GetDecompressedSize(data, size, decompressedSize) || decompressedSize != destSize)
+				return false;
+
+			return Decode(data + kHeaderSize, data + size, dest, dest + destSize);
+		}
+
+		ByteArray Compress(const unsigned char* data, size_t size, int level) const override;
+
+	private:
+		static bool Decode(const unsigned char* In, const unsigned char* InEnd, unsigned char* Out, unsigned char* OutEnd);
+	};
+
+	bool LZCodec::Decode(const unsigned char* In, const unsigned char* InEnd, unsigned char* Out, unsigned char* OutEnd)
+	{
+		unsigned char* const OutStart = Out;
+
+		for (;;)
+		{
+			if (In == InEnd)
+				return false;
+
+			const unsigned char Token = *In++;
+
+			size_t NumLiterals = Token >> 4;
+			if (NumLiterals == 15 && !ReadLength(In, InEnd, NumLiterals))
+				return false;
+
+			if (NumLiterals > (size_t)(InEnd - In) || NumLiterals > (size_t)(OutEnd - Out))
+				return false;
+
+			if (NumLiterals + kWildCopySize <= (size_t)(InEnd - In) && NumLiterals + kWildCopySize <= (size_t)(OutEnd - Out))
+				WildCopy(Out, In, NumLiterals);
+			else
+				memcpy(Out, In, NumLiterals);
+
+			In += NumLiterals;
+			Out += NumLiterals;
+
+			// The last sequence is literals only.
+			if (Out == OutEnd)
+				return In == InEnd;
+
+			if (InEnd - In < 2)
+				return false;
+
+			const size_t Offset = In[0] | (In[1] << 8);
+			In += 2;
+
+			size_t MatchLength = Token & 15;
+			if (MatchLength == 15 && !ReadLength(In, InEnd, MatchLength))
+				return false;
+			MatchLength += kMinMatch;
+
+			if (Offset == 0 || Offset > (size_t)(Out - OutStart) || MatchLength > (size_t)(OutEnd - Out))
+				return false;
+
+			const unsigned char* Match = Out - Offset;
+
+			if (Offset >= kWildCopySize && MatchLength + kWildCopySize <= (size_t)(OutEnd - Out))
+			{
+				WildCopy(Out, Match, MatchLength);
+			}
+			else if (Offset >= 8 && MatchLength + 8 <= (size_t)(OutEnd - Out))
+			{
+				// Eight bytes at a time never reads bytes this loop has not written yet.
+				for (size_t i = 0; i < MatchLength; i += 8)
+					memcpy(Out + i, Match + i, 8);
+			}
+			else
+			{
+				// Short offsets repeat a pattern, so each byte may depend on one just written.
+				for (size_t i = 0; i < MatchLength; ++i)
+					Out[i] = Match[i];
+			}
+
+			Out += MatchLength;
+		}
+	}
+
+	// Greedy parsing.  Level 0 checks one candidate per position and skips faster through data that does
+	// not compress; higher levels follow a hash chain through the whole window, trading compression time
+	// for ratio.  Decoding speed is the same either way.
+	ByteArray LZCodec::Compress(const unsigned char* data, size_t size, int level) const
+	{
+		level = min(max(level, 0), kMaxLevel);
+		const int MaxAttempts = level == 0 ? 1 : 1 << (level - 1);
+
+		ByteArray result = make_shared<vector<unsigned char> >();
+		vector<unsigned char>& Out = *result;
+		Out.reserve(kHeaderSize + size + size / 255 + 16);
+
+		const uint64_t Size64 = size;
+		Out.insert(Out.end(), kMagic, kMagic + sizeof(kMagic));
+		Out.insert(Out.end(), (const unsigned char*)&Size64, (const unsigned char*)&Size64 + sizeof(Size64));
+
+		// Head holds the last position + 1 with each hash, 0 meaning none.  Chain links a position to the
+		// previous one with the same hash, as a distance so that it fits in the window.
+		vector<uint32_t> Head((size_t)1 << kHashBits, 0);
+		vector<uint16_t> Chain(level > 0 ? kMaxOffset + 1 : 0, 0);
+
+		auto Insert = [&](size_t Position)
+		{
+			const uint32_t h = Hash(Read32(data + Position));
+			if (!Chain.empty())
+			{
+				const size_t Previous = Head[h];
+				Chain[Position & kMaxOffset] = (uint16_t)(Previous != 0 && Position + 1 - Previous <= kMaxOffset ? Position + 1 - Previous : 0);
+			}
+			Head[h] = (uint32_t)(Position + 1);
+		};
+
+		size_t Anchor = 0;
+		size_t Position = 0;
+
+		while (Position + kMinMatch <= size)
+		{
+			const uint32_t Sequence = Read32(data + Position);
+			size_t Candidate = Head[Hash(Sequence)];
+			size_t BestLength = 0;
+			size_t BestOffset = 0;
+
+			for (int Attempt = 0; Attempt < MaxAttempts && Candidate != 0; ++Attempt)
+			{
+				const size_t CandidatePosition = Candidate - 1;
+				const size_t Offset = Position - CandidatePosition;
+				if (Offset > kMaxOffset)
+					break;
+
+				if (Read32(data + CandidatePosition) == Sequence)
+				{
+					const size_t Length = kMinMatch + CountMatch(data + CandidatePosition + kMinMatch, data + Position + kMinMatch, data + size);
+					if (Length > BestLength)
+					{
+						BestLength = Length;
+						BestOffset = Offset;
+					}
+				}
+
+				if (Chain.empty() || Chain[CandidatePosition & kMaxOffset] == 0)
+					break;
+				Candidate -= Chain[CandidatePosition & kMaxOffset];
+			}
+
+			Insert(Position);
+
+			if (BestLength < kMinMatch)
+			{
+				Position += level == 0 ? 1 + ((Position - Anchor) >> 6) : 1;
+				continue;
+			}
+
+			WriteSequence(Out, data + Anchor, Position - Anchor, BestOffset, BestLength);
+
+			// Index the positions inside the match too, where there are enough bytes left to hash.
+			const size_t MatchEnd = Position + BestLength;
+			if (level > 0)
+			{
+				for (size_t p = Position + 1; p < MatchEnd && p + kMinMatch <= size; ++p)
+					Insert(p);
+			}
+			else if (MatchEnd >= 2 && MatchEnd - 2 + kMinMatch <= size)
+			{
+				Insert(MatchEnd - 2);
+			}
+
+			Position = MatchEnd;
+			Anchor = Position;
+		}
+
+		WriteSequence(Out, data + Anchor, size - Anchor, 0, 0);
+		return result;
+	}
+}
+
+const Codec& HolographicEngine::Compression::GetLZCodec(void)
+{
+	static LZCodec s_Codec;
+	return s_Codec;
+}
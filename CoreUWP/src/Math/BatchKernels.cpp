@@ -0,0 +1,248 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "BatchKernels.h"
+#include "CpuFeatures.h"
+#include "EngineProfiling.h"
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Math;
+
+namespace
+{
+	// Matrices are passed as 16 floats, one basis row after another, and frusta as six (a, b, c, d)
+	// planes, so the kernels do not depend on the XMVECTOR layout.
+	typedef void (*TransformPointsKernel)(const float* M, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, size_t Count);
+	typedef size_t(*CullSpheresKernel)(const float* Planes, const float* Spheres, size_t Count, uint32_t* VisibleIndices);
+
+	void TransformPointsScalar(const float* M, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, size_t Count)
+	{
+		for (size_t i = 0; i < Count; ++i)
+		{
+			const float x = InX[i], y = InY[i], z = InZ[i];
+			OutX[i] = x * M[0] + y * M[4] + z * M[8] + M[12];
+			OutY[i] = x * M[1] + y * M[5] + z * M[9] + M[13];
+			OutZ[i] = x * M[2] + y * M[6] + z * M[10] + M[14];
+		}
+	}
+
+	size_t CullSpheresScalar(const float* Planes, const float* Spheres, size_t Count, uint32_t* VisibleIndices)
+	{
+		size_t NumVisible = 0;
+
+		for (size_t i = 0; i < Count; ++i)
+		{
+			const float* s = Spheres + i * 4;
+			bool Visible = true;
+
+			for (int p = 0; p < 6 && Visible; ++p)
+			{
+				const float* Plane = Planes + p * 4;
+				Visible = s[0] * Plane[0] + s[1] * Plane[1] + s[2] * Plane[2] + Plane[3] + s[3] >= 0.0f;
+			}
+
+			if (Visible)
+				VisibleIndices[NumVisible++] = (uint32_t)i;
+		}
+
+		return NumVisible;
+	}
+
+	// Appends Base + the index of each set bit of Mask.
+	__forceinline size_t AppendIndices(uint32_t Mask, uint32_t Base, uint32_t* VisibleIndices)
+	{
+		size_t NumWritten = 0;
+		unsigned long Bit;
+
+		while (_BitScanForward(&Bit, Mask))
+		{
+			VisibleIndices[NumWritten++] = Base + Bit;
+			Mask &= Mask - 1;
+		}
+
+		return NumWritten;
+	}
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+	void TransformPointsSSE2(const float* M, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, size_t Count)
+	{
+		const __m128 M0 = _mm_set1_ps(M[0]), M1 = _mm_set1_ps(M[1]), M2 = _mm_set1_ps(M[2]);
+		const __m128 M4 = _mm_set1_ps(M[4]), M5 = _mm_set1_ps(M[5]), M6 = _mm_set1_ps(M[6]);
+		const __m128 M8 = _mm_set1_ps(M[8]), M9 = _mm_set1_ps(M[9]), M10 = _mm_set1_ps(M[10]);
+		const __m128 M12 = _mm_set1_ps(M[12]), M13 = _mm_set1_ps(M[13]), M14 = _mm_set1_ps(M[14]);
+
+		size_t i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			const __m128 x = _mm_loadu_ps(InX + i);
+			const __m128 y = _mm_loadu_ps(InY + i);
+			const __m128 z = _mm_loadu_ps(InZ + i);
+
+			_mm_storeu_ps(OutX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, M0), _mm_mul_ps(y, M4)), _mm_add_ps(_mm_mul_ps(z, M8), M12)));
+			_mm_storeu_ps(OutY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, M1), _mm_mul_ps(y, M5)), _mm_add_ps(_mm_mul_ps(z, M9), M13)));
+			_mm_storeu_ps(OutZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, M2), _mm_mul_ps(y, M6)), _mm_add_ps(_mm_mul_ps(z, M10), M14)));
+		}
+
+		TransformPointsScalar(M, InX + i, InY + i, InZ + i, OutX + i, OutY + i, OutZ + i, Count - i);
+	}
+
+	void TransformPointsAVX2(const float* M, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, size_t Count)
+	{
+		const __m256 M0 = _mm256_set1_ps(M[0]), M1 = _mm256_set1_ps(M[1]), M2 = _mm256_set1_ps(M[2]);
+		const __m256 M4 = _mm256_set1_ps(M[4]), M5 = _mm256_set1_ps(M[5]), M6 = _mm256_set1_ps(M[6]);
+		const __m256 M8 = _mm256_set1_ps(M[8]), M9 = _mm256_set1_ps(M[9]), M10 = _mm256_set1_ps(M[10]);
+		const __m256 M12 = _mm256_set1_ps(M[12]), M13 = _mm256_set1_ps(M[13]), M14 = _mm256_set1_ps(M[14]);
+
+		size_t i = 0;
+		for (; i + 8 <= Count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(InX + i);
+			const __m256 y = _mm256_loadu_ps(InY + i);
+			const __m256 z = _mm256_loadu_ps(InZ + i);
+
+			_mm256_storeu_ps(OutX + i, _mm256_fmadd_ps(x, M0, _mm256_fmadd_ps(y, M4, _mm256_fmadd_ps(z, M8, M12))));
+			_mm256_storeu_ps(OutY + i, _mm256_fmadd_ps(x, M1, _mm256_fmadd_ps(y, M5, _mm256_fmadd_ps(z, M9, M13))));
+			_mm256_storeu_ps(OutZ + i, _mm256_fmadd_ps(x, M2, _mm256_fmadd_ps(y, M6, _mm256_fmadd_ps(z, M10, M14))));
+		}
+
+		_mm256_zeroupper();
+		TransformPointsSSE2(M, InX + i, InY + i, InZ + i, OutX + i, OutY + i, OutZ + i, Count - i);
+	}
+
+	size_t CullSpheresSSE2(const float* Planes, const float* Spheres, size_t Count, uint32_t* VisibleIndices)
+	{
+		__m128 PlaneX[6], PlaneY[6], PlaneZ[6], PlaneW[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			PlaneX[p] = _mm_set1_ps(Planes[p * 4 + 0]);
+			PlaneY[p] = _mm_set1_ps(Planes[p * 4 + 1]);
+			PlaneZ[p] = _mm_set1_ps(Planes[p * 4 + 2]);
+			PlaneW[p] = _mm_set1_ps(Planes[p * 4 + 3]);
+		}
+
+		const __m128 Zero = _mm_setzero_ps();
+		size_t NumVisible = 0;
+		size_t i = 0;
+
+		for (; i + 4 <= Count; i += 4)
+		{
+			// Four spheres in, one component per register out.
+			__m128 x = _mm_loadu_ps(Spheres + i * 4 + 0);
+			__m128 y = _mm_loadu_ps(Spheres + i * 4 + 4);
+			__m128 z = _mm_loadu_ps(Spheres + i * 4 + 8);
+			__m128 r = _mm_loadu_ps(Spheres + i * 4 + 12);
+			_MM_TRANSPOSE4_PS(x, y, z, r);
+
+			__m128 Outside = Zero;
+			for (int p = 0; p < 6; ++p)
+			{
+				__m128 Distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, PlaneX[p]), _mm_mul_ps(y, PlaneY[p])),
+					_mm_add_ps(_mm_mul_ps(z, PlaneZ[p]), _mm_add_ps(PlaneW[p], r)));
+				Outside = _mm_or_ps(Outside, _mm_cmplt_ps(Distance, Zero));
+			}
+
+			NumVisible += AppendIndices(~_mm_movemask_ps(Outside) & 0xF, (uint32_t)i, VisibleIndices + NumVisible);
+		}
+
+		size_t NumTail = CullSpheresScalar(Planes, Spheres + i * 4, Count - i, VisibleIndices + NumVisible);
+		for (size_t t = 0; t < NumTail; ++t)
+			VisibleIndices[NumVisible + t] += (uint32_t)i;
+
+		return NumVisible + NumTail;
+	}
+
+	size_t CullSpheresAVX2(const float* Planes, const float* Spheres, size_t Count, uint32_t* VisibleIndices)
+	{
+		__m256 PlaneX[6], PlaneY[6], PlaneZ[6], PlaneW[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			PlaneX[p] = _mm256_set1_ps(Planes[p * 4 + 0]);
+			PlaneY[p] = _mm256_set1_ps(Planes[p * 4 + 1]);
+			PlaneZ[p] = _mm256_set1_ps(Planes[p * 4 + 2]);
+			PlaneW[p] = _mm256_set1_ps(Planes[p * 4 + 3]);
+		}
+
+		const __m256 Zero = _mm256_setzero_ps();
+		size_t NumVisible = 0;
+		size_t i = 0;
+
+		for (; i + 8 <= Count; i += 8)
+		{
+			// Spheres 0-3 go to the low lanes and 4-7 to the high lanes, then each half is transposed.
+			const float* s = Spheres + i * 4;
+			const __m256 t0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(s + 0)), _mm_loadu_ps(s + 16), 1);
+			const __m256 t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(s + 4)), _mm_loadu_ps(s + 20), 1);
+			const __m256 t2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(s + 8)), _mm_loadu_ps(s + 24), 1);
+			const __m256 t3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(s + 12)), _mm_loadu_ps(s + 28), 1);
+
+			const __m256 xy01 = _mm256_unpacklo_ps(t0, t1);
+			const __m256 xy23 = _mm256_unpacklo_ps(t2, t3);
+			const __m256 zw01 = _mm256_unpackhi_ps(t0, t1);
+			const __m256 zw23 = _mm256_unpackhi_ps(t2, t3);
+
+			const __m256 x = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 y = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+			const __m256 z = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 r = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(3, 2, 3, 2));
+
+			__m256 Outside = Zero;
+			for (int p = 0; p < 6; ++p)
+			{
+				__m256 Distance = _mm256_fmadd_ps(x, PlaneX[p], _mm256_fmadd_ps(y, PlaneY[p], _mm256_fmadd_ps(z, PlaneZ[p], _mm256_add_ps(PlaneW[p], r))));
+				Outside = _mm256_or_ps(Outside, _mm256_cmp_ps(Distance, Zero, _CMP_LT_OQ));
+			}
+
+			NumVisible += AppendIndices(~_mm256_movemask_ps(Outside) & 0xFF, (uint32_t)i, VisibleIndices + NumVisible);
+		}
+
+		_mm256_zeroupper();
+
+		size_t NumTail = CullSpheresSSE2(Planes, Spheres + i * 4, Count - i, VisibleIndices + NumVisible);
+		for (size_t t = 0; t < NumTail; ++t)
+			VisibleIndices[NumVisible + t] += (uint32_t)i;
+
+		return NumVisible + NumTail;
+	}
+
+	CpuFeatures::DispatchTable<TransformPointsKernel> s_TransformPoints(TransformPointsScalar, TransformPointsSSE2, nullptr, TransformPointsAVX2);
+	CpuFeatures::DispatchTable<CullSpheresKernel> s_CullSpheres(CullSpheresScalar, CullSpheresSSE2, nullptr, CullSpheresAVX2);
+
+#else
+
+	CpuFeatures::DispatchTable<TransformPointsKernel> s_TransformPoints(TransformPointsScalar);
+	CpuFeatures::DispatchTable<CullSpheresKernel> s_CullSpheres(CullSpheresScalar);
+
+#endif
+}
+
+void HolographicEngine::Math::TransformPointsSoA(const Matrix4& Transform,
+	const float* InX, const float* InY, const float* InZ,
+	float* OutX, float* OutY, float* OutZ, size_t Count)
+{
+	PROFILE_COUNTERS("Math::TransformPointsSoA", Count);
+
+	XMFLOAT4X4 M;
+	XMStoreFloat4x4(&M, Transform);
+	s_TransformPoints.Get()(&M.m[0][0], InX, InY, InZ, OutX, OutY, OutZ, Count);
+}
+
+size_t HolographicEngine::Math::CullSpheres(const Frustum& frustum, const XMFLOAT4* Spheres, size_t Count, uint32_t* VisibleIndices)
+{
+	PROFILE_COUNTERS("Math::CullSpheres", Count);
+
+	XMFLOAT4 Planes[6];
+	for (int p = 0; p < 6; ++p)
+		XMStoreFloat4(&Planes[p], Vector4(frustum.GetFrustumPlane((Frustum::PlaneID)p)));
+
+	return s_CullSpheres.Get()(&Planes[0].x, &Spheres[0].x, Count, VisibleIndices);
+}
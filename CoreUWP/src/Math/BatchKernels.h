@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "Frustum.h"
+
+namespace HolographicEngine::Math
+{
+	// Kernels over plain arrays, for work that is too wide for one Vector3 at a time.  Each is
+	// dispatched to the active CpuFeatures tier, so forcing a tier exercises the matching path.
+
+	// Transforms Count points (w = 1) stored as separate X, Y and Z arrays.  The outputs may alias the
+	// inputs.
+	void TransformPointsSoA(const Matrix4& Transform,
+		const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, size_t Count);
+
+	// Tests Count spheres, each packed as (center.x, center.y, center.z, radius), against the frustum with
+	// the same rule as Frustum::IntersectSphere.  Writes the indices of the spheres that intersect it to
+	// VisibleIndices, in increasing order, and returns how many were written.
+	size_t CullSpheres(const Frustum& frustum, const XMFLOAT4* Spheres, size_t Count, uint32_t* VisibleIndices);
+} // namespace Math
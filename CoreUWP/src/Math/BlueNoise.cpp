@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "BlueNoise.h"
+#include "Random.h"
+
+using namespace HolographicEngine::Math;
+
+namespace
+{
+	// Incrementally maintained energy field: the toroidal Gaussian-filtered density of the set pixels.
+	// Adding or removing a pixel only touches the precomputed kernel, so each step is O(Size^2).
+	class EnergyField
+	{
+	public:
+		EnergyField(uint32_t size, float sigma) : m_Size(size), m_Energy(size * size, 0.0f), m_Kernel(size * size)
+		{
+			const float inv2Sigma2 = 1.0f / (2.0f * sigma * sigma);
+
+			for (uint32_t y = 0; y < size; ++y)
+			{
+				for (uint32_t x = 0; x < size; ++x)
+				{
+					// Distance to the nearest periodic copy makes the result tile seamlessly.
+					float dx = (float)min(x, size - x);
+					float dy = (float)min(y, size - y);
+					m_Kernel[y * size + x] = expf(-(dx * dx + dy * dy) * inv2Sigma2);
+				}
+			}
+		}
+
+		void Splat(uint32_t index, float sign)
+		{
+			const uint32_t px = index % m_Size;
+			const uint32_t py = index / m_Size;
+			const uint32_t mask = m_Size - 1;
+
+			for (uint32_t y = 0; y < m_Size; ++y)
+			{
+				const float* kernelRow = &m_Kernel[((y - py) & mask) * m_Size];
+				float* energyRow = &m_Energy[y * m_Size];
+
+				for (uint32_t x = 0; x < m_Size; ++x)
+					energyRow[x] += sign * kernelRow[(x - px) & mask];
+			}
+		}
+
+		// The set pixel with the highest energy.
+		uint32_t TightestCluster(const std::vector<uint8_t>& pattern) const
+		{
+			uint32_t best = 0;
+			float bestEnergy = -FLT_MAX;
+
+			for (uint32_t i = 0; i < (uint32_t)pattern.size(); ++i)
+			{
+				if (pattern[i] && m_Energy[i] > bestEnergy)
+				{
+					bestEnergy = m_Energy[i];
+					best = i;
+				}
+			}
+
+			return best;
+		}
+
+		// The empty pixel with the lowest energy.
+		uint32_t LargestVoid(const std::vector<uint8_t>& pattern) const
+		{
+			uint32_t best = 0;
+			float bestEnergy = FLT_MAX;
+
+			for (uint32_t i = 0; i < (uint32_t)pattern.size(); ++i)
+			{
+				if (!pattern[i] && m_Energy[i] < bestEnergy)
+				{
+					bestEnergy = m_Energy[i];
+					best = i;
+				}
+			}
+
+			return best;
+		}
+
+	private:
+
+		uint32_t m_Size;
+		std::vector<float> m_Energy;
+		std::vector<float> m_Kernel;
+	};
+}
+
+BlueNoiseTable::BlueNoiseTable(uint32_t Size, uint32_t Seed, float Sigma)
+{
+	ASSERT(Size >= 4 && IsPowerOfTwo(Size), "Blue-noise tables must be a power of two in size");
+	ASSERT(Size <= 256, "Ranks are stored as 16-bit values");
+
+	m_Size = Size;
+	m_Mask = Size - 1;
+
+	const uint32_t pixelCount = Size * Size;
+	const uint32_t initialCount = max(pixelCount / 10, 1u);
+
+	RandomNumberGenerator rng;
+	rng.SetSeed(Seed);
+
+	// Initial binary pattern: sparse random points, then swap tightest clusters into largest voids until
+	// the pattern stops changing.
+	std::vector<uint8_t> prototype(pixelCount, 0);
+	EnergyField prototypeEnergy(Size, Sigma);
+
+	for (uint32_t placed = 0; placed < initialCount;)
+	{
+		uint32_t index = (uint32_t)rng.NextInt((int32_t)pixelCount - 1);
+		if (prototype[index])
+			continue;
+
+		prototype[index] = 1;
+		prototypeEnergy.Splat(index, 1.0f);
+		++placed;
+	}
+
+	for (uint32_t iteration = 0; iteration < pixelCount; ++iteration)
+	{
+		uint32_t cluster = prototypeEnergy.TightestCluster(prototype);
+		prototype[cluster] = 0;
+		prototypeEnergy.Splat(cluster, -1.0f);
+
+		uint32_t voidIndex = prototypeEnergy.LargestVoid(prototype);
+		prototype[voidIndex] = 1;
+		prototypeEnergy.Splat(voidIndex, 1.0f);
+
+		if (voidIndex == cluster)
+			break;
+	}
+
+	m_Ranks.resize(pixelCount);
+
+	// Phase 1: peel tightest clusters off a copy of the prototype to rank its points from the top down.
+	{
+		std::vector<uint8_t> pattern = prototype;
+		EnergyField energy = prototypeEnergy;
+
+		for (uint32_t rank = initialCount; rank-- > 0;)
+		{
+			uint32_t cluster = energy.TightestCluster(pattern);
+			pattern[cluster] = 0;
+			energy.Splat(cluster, -1.0f);
+			m_Ranks[cluster] = (uint16_t)rank;
+		}
+	}
+
+	// Phase 2: fill the largest voids of the prototype until every pixel is set.  Past the halfway point
+	// the largest void of the ones is also the tightest cluster of the zeros, so a single rule suffices.
+	{
+		std::vector<uint8_t>& pattern = prototype;
+		EnergyField& energy = prototypeEnergy;
+
+		for (uint32_t rank = initialCount; rank < pixelCount; ++rank)
+		{
+			uint32_t voidIndex = energy.LargestVoid(pattern);
+			pattern[voidIndex] = 1;
+			energy.Splat(voidIndex, 1.0f);
+			m_Ranks[voidIndex] = (uint16_t)rank;
+		}
+	}
+
+	m_Values.resize(pixelCount);
+	const float invCount = 1.0f / pixelCount;
+	for (uint32_t i = 0; i < pixelCount; ++i)
+		m_Values[i] = (m_Ranks[i] + 0.5f) * invCount;
+}
+
+void BlueNoiseTable::Fill(float* Out, int32_t x, int32_t y, uint32_t Width, uint32_t Height) const
+{
+	for (uint32_t row = 0; row < Height; ++row)
+	{
+		const float* src = &m_Values[((uint32_t)(y + row) & m_Mask) * m_Size];
+		uint32_t column = (uint32_t)x & m_Mask;
+
+		for (uint32_t i = 0; i < Width; ++i)
+		{
+			*Out++ = src[column];
+			column = (column + 1) & m_Mask;
+		}
+	}
+}
+
+void BlueNoiseTable::Gather(float* Out, const int32_t* Coordinates, uint32_t Count) const
+{
+	for (uint32_t i = 0; i < Count; ++i, Coordinates += 2)
+		Out[i] = Sample(Coordinates[0], Coordinates[1]);
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace HolographicEngine::Math
+{
+	// A tileable blue-noise threshold table built with Ulichney's void-and-cluster method.  Every value
+	// in [0, 1) appears exactly once, and any threshold of the table yields points that are evenly spread
+	// with no low frequency clumping, including across the wrap-around edges.  Use it to jitter
+	// per-pixel or per-instance sampling patterns so that the error that remains is high frequency.
+	class BlueNoiseTable
+	{
+	public:
+		BlueNoiseTable() : m_Size(0), m_Mask(0) {}
+
+		// Size must be a power of two.  Generation is O(Size^4), so build tables once at load time; 64x64
+		// takes a few tens of milliseconds.
+		explicit BlueNoiseTable(uint32_t Size, uint32_t Seed = 0, float Sigma = 1.5f);
+
+		uint32_t GetSize(void) const { return m_Size; }
+
+		// The rank of every cell, from 0 to Size * Size - 1.
+		const std::vector<uint16_t>& GetRanks(void) const { return m_Ranks; }
+
+		// Wrapping lookup, so any integer coordinate is valid.
+		float Sample(int32_t x, int32_t y) const
+		{
+			return m_Values[((uint32_t)y & m_Mask) * m_Size + ((uint32_t)x & m_Mask)];
+		}
+
+		// Writes Width * Height values starting at (x, y) into a tightly packed row-major buffer.
+		void Fill(float* Out, int32_t x, int32_t y, uint32_t Width, uint32_t Height) const;
+
+		// Writes the blue-noise value at each of Count coordinate pairs.
+		void Gather(float* Out, const int32_t* Coordinates, uint32_t Count) const;
+
+	private:
+
+		uint32_t m_Size;
+		uint32_t m_Mask;
+		std::vector<uint16_t> m_Ranks;
+		std::vector<float> m_Values;
+	};
+} // namespace Math
@@ -85,32 +85,7 @@ namespace HolographicEngine::Math
 		//return _mm_cvtepi32_ps(_mm_srli_epi32(SetAllBits(zero), 31));                // return (float)1;  (alternate method)
 	}
 
-#if defined(_XM_SSE4_INTRINSICS_)
-	INLINE XMVECTOR CreateXUnitVector(XMVECTOR one = SplatOne())
-	{
-		return _mm_insert_ps(one, one, 0x0E);
-	}
-	INLINE XMVECTOR CreateYUnitVector(XMVECTOR one = SplatOne())
-	{
-		return _mm_insert_ps(one, one, 0x0D);
-	}
-	INLINE XMVECTOR CreateZUnitVector(XMVECTOR one = SplatOne())
-	{
-		return _mm_insert_ps(one, one, 0x0B);
-	}
-	INLINE XMVECTOR CreateWUnitVector(XMVECTOR one = SplatOne())
-	{
-		return _mm_insert_ps(one, one, 0x07);
-	}
-	INLINE XMVECTOR SetWToZero(FXMVECTOR vec)
-	{
-		return _mm_insert_ps(vec, vec, 0x08);
-	}
-	INLINE XMVECTOR SetWToOne(FXMVECTOR vec)
-	{
-		return _mm_blend_ps(vec, SplatOne(), 0x8);
-	}
-#else
+	// SSE2 only, whatever the compiler targets: these are inlined everywhere, outside CpuFeatures dispatch.
 	INLINE XMVECTOR CreateXUnitVector(XMVECTOR one = SplatOne())
 	{
 		return _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(one), 12));
@@ -138,7 +113,6 @@ namespace HolographicEngine::Math
 	{
 		return _mm_movelh_ps(vec, _mm_unpackhi_ps(vec, SplatOne()));
 	}
-#endif
 
 #else // !_XM_SSE_INTRINSICS_
 
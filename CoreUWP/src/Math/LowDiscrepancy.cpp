@@ -0,0 +1,327 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "LowDiscrepancy.h"
+
+using namespace HolographicEngine::Math;
+
+namespace
+{
+	const uint32_t s_Primes[HaltonSequence::kMaxDimensions] =
+	{
+		2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53
+	};
+
+	// Primitive polynomials and initial direction numbers from Joe & Kuo (new-joe-kuo-6.21201) for
+	// dimensions 2 through 16.  The first dimension is the Van der Corput sequence and needs no entry.
+	struct SobolPolynomial
+	{
+		uint32_t Degree;
+		uint32_t Coefficients;
+		uint32_t InitialNumbers[6];
+	};
+
+	const SobolPolynomial s_SobolPolynomials[SobolSequence::kMaxDimensions - 1] =
+	{
+		{ 1,  0, { 1 } },
+		{ 2,  1, { 1, 3 } },
+		{ 3,  1, { 1, 3, 1 } },
+		{ 3,  2, { 1, 1, 1 } },
+		{ 4,  1, { 1, 1, 3, 3 } },
+		{ 4,  4, { 1, 3, 5, 13 } },
+		{ 5,  2, { 1, 1, 5, 5, 17 } },
+		{ 5,  4, { 1, 1, 5, 5, 5 } },
+		{ 5,  7, { 1, 1, 7, 11, 19 } },
+		{ 5, 11, { 1, 1, 5, 1, 1 } },
+		{ 5, 13, { 1, 1, 1, 3, 11 } },
+		{ 5, 14, { 1, 3, 5, 5, 31 } },
+		{ 6,  1, { 1, 3, 3, 9, 7, 49 } },
+		{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+		{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+	};
+
+	// Direction numbers are expanded once, at static initialization, into a flat table indexed by
+	// [dimension][bit].
+	struct SobolDirectionTable
+	{
+		uint32_t V[SobolSequence::kMaxDimensions][32];
+
+		SobolDirectionTable()
+		{
+			for (uint32_t i = 0; i < 32; ++i)
+				V[0][i] = 1u << (31 - i);
+
+			for (uint32_t d = 1; d < SobolSequence::kMaxDimensions; ++d)
+			{
+				const SobolPolynomial& poly = s_SobolPolynomials[d - 1];
+				const uint32_t s = poly.Degree;
+				uint32_t* v = V[d];
+
+				for (uint32_t i = 0; i < s; ++i)
+					v[i] = poly.InitialNumbers[i] << (31 - i);
+
+				for (uint32_t i = s; i < 32; ++i)
+				{
+					v[i] = v[i - s] ^ (v[i - s] >> s);
+					for (uint32_t k = 1; k < s; ++k)
+						v[i] ^= ((poly.Coefficients >> (s - 1 - k)) & 1) * v[i - k];
+				}
+			}
+		}
+	};
+
+	const SobolDirectionTable s_SobolDirections;
+
+	// Integer hash used to derive independent per-dimension scrambles from a single seed.
+	uint32_t HashUInt32(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+		x ^= x >> 16;
+		return x;
+	}
+
+	uint32_t CountTrailingZeros(uint32_t value)
+	{
+		unsigned long index;
+		return _BitScanForward(&index, value) ? (uint32_t)index : 32;
+	}
+}
+
+float HolographicEngine::Math::RadicalInverseBase2(uint32_t index)
+{
+	index = (index << 16) | (index >> 16);
+	index = ((index & 0x00ff00ff) << 8) | ((index & 0xff00ff00) >> 8);
+	index = ((index & 0x0f0f0f0f) << 4) | ((index & 0xf0f0f0f0) >> 4);
+	index = ((index & 0x33333333) << 2) | ((index & 0xcccccccc) >> 2);
+	index = ((index & 0x55555555) << 1) | ((index & 0xaaaaaaaa) >> 1);
+	return FixedPointToUnitFloat(index);
+}
+
+float HolographicEngine::Math::RadicalInverse(uint32_t index, uint32_t base)
+{
+	if (base == 2)
+		return RadicalInverseBase2(index);
+
+	const double invBase = 1.0 / base;
+	double scale = invBase;
+	double result = 0.0;
+
+	while (index > 0)
+	{
+		result += (index % base) * scale;
+		index /= base;
+		scale *= invBase;
+	}
+
+	return (float)min(result, 0.99999994);
+}
+
+//=======================================================================================================
+// HaltonSequence
+//
+
+HaltonSequence::HaltonSequence(uint32_t Dimensions, uint32_t StartIndex)
+{
+	ASSERT(Dimensions > 0 && Dimensions <= kMaxDimensions, "Halton sequences support 1 to %u dimensions", kMaxDimensions);
+	m_Dimensions = Dimensions;
+	Seek(StartIndex);
+}
+
+float HaltonSequence::Sample(uint32_t Index, uint32_t Dimension) const
+{
+	ASSERT(Dimension < m_Dimensions);
+	return RadicalInverse(Index, s_Primes[Dimension]);
+}
+
+void HaltonSequence::Seek(uint32_t Index)
+{
+	m_Index = Index;
+
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+	{
+		const uint32_t base = s_Primes[d];
+		const double invBase = 1.0 / base;
+		double scale = invBase;
+		double value = 0.0;
+		uint32_t remaining = Index;
+
+		for (uint32_t i = 0; i < kMaxDigits; ++i)
+		{
+			uint32_t digit = remaining % base;
+			m_Digits[d][i] = (uint8_t)digit;
+			value += digit * scale;
+			remaining /= base;
+			scale *= invBase;
+		}
+
+		m_Values[d] = value;
+	}
+}
+
+void HaltonSequence::Increment(void)
+{
+	++m_Index;
+
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+	{
+		const uint32_t base = s_Primes[d];
+		const double invBase = 1.0 / base;
+		double scale = invBase;
+		uint8_t* digits = m_Digits[d];
+
+		// Add one to the least significant digit and carry, exactly like an odometer.  The value is
+		// mirrored, so every carry removes (base - 1) units at its scale and adds one unit further down.
+		for (uint32_t i = 0; i < kMaxDigits; ++i)
+		{
+			if (digits[i] + 1u < base)
+			{
+				++digits[i];
+				m_Values[d] += scale;
+				break;
+			}
+
+			m_Values[d] -= (base - 1) * scale;
+			digits[i] = 0;
+			scale *= invBase;
+		}
+	}
+}
+
+void HaltonSequence::Next(float* Out)
+{
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+		Out[d] = (float)min(max(m_Values[d], 0.0), 0.99999994);
+
+	Increment();
+}
+
+void HaltonSequence::Generate(float* Out, uint32_t Count)
+{
+	for (uint32_t i = 0; i < Count; ++i, Out += m_Dimensions)
+		Next(Out);
+}
+
+//=======================================================================================================
+// SobolSequence
+//
+
+SobolSequence::SobolSequence(uint32_t Dimensions, uint32_t Seed)
+{
+	ASSERT(Dimensions > 0 && Dimensions <= kMaxDimensions, "Sobol sequences support 1 to %u dimensions", kMaxDimensions);
+	m_Dimensions = Dimensions;
+
+	for (uint32_t d = 0; d < kMaxDimensions; ++d)
+		m_Shift[d] = Seed == 0 ? 0 : HashUInt32(Seed + d * 0x9e3779b9U);
+
+	Seek(0);
+}
+
+uint32_t SobolSequence::SampleFixed(uint32_t Index, uint32_t Dimension) const
+{
+	ASSERT(Dimension < m_Dimensions);
+
+	const uint32_t* v = s_SobolDirections.V[Dimension];
+	uint32_t gray = Index ^ (Index >> 1);
+	uint32_t result = 0;
+
+	for (uint32_t bit = 0; gray != 0; ++bit, gray >>= 1)
+	{
+		if (gray & 1)
+			result ^= v[bit];
+	}
+
+	return result ^ m_Shift[Dimension];
+}
+
+void SobolSequence::Seek(uint32_t Index)
+{
+	m_Index = Index;
+
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+		m_State[d] = SampleFixed(Index, d);
+}
+
+void SobolSequence::Next(float* Out)
+{
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+		Out[d] = FixedPointToUnitFloat(m_State[d]);
+
+	// Consecutive Gray codes differ in exactly one bit: the lowest set bit of the new index.
+	const uint32_t bit = CountTrailingZeros(++m_Index);
+	if (bit < 32)
+	{
+		for (uint32_t d = 0; d < m_Dimensions; ++d)
+			m_State[d] ^= s_SobolDirections.V[d][bit];
+	}
+}
+
+void SobolSequence::Generate(float* Out, uint32_t Count)
+{
+	for (uint32_t i = 0; i < Count; ++i, Out += m_Dimensions)
+		Next(Out);
+}
+
+//=======================================================================================================
+// RdSequence
+//
+
+RdSequence::RdSequence(uint32_t Dimensions, float Offset)
+{
+	ASSERT(Dimensions > 0 && Dimensions <= kMaxDimensions, "R sequences support 1 to %u dimensions", kMaxDimensions);
+	m_Dimensions = Dimensions;
+	m_Index = 0;
+	m_Offset = (uint32_t)((double)(Offset - floorf(Offset)) * 4294967296.0);
+
+	// The generalized golden ratio is the unique positive root of x^(d+1) = x + 1.
+	double g = 2.0;
+	for (int i = 0; i < 32; ++i)
+		g = pow(1.0 + g, 1.0 / (Dimensions + 1.0));
+
+	double alpha = 1.0;
+	for (uint32_t d = 0; d < kMaxDimensions; ++d)
+	{
+		alpha /= g;
+		double fraction = alpha - floor(alpha);
+		m_Alpha[d] = (uint32_t)(fraction * 4294967296.0);
+	}
+}
+
+float RdSequence::Sample(uint32_t Index, uint32_t Dimension) const
+{
+	ASSERT(Dimension < m_Dimensions);
+	return FixedPointToUnitFloat(m_Offset + Index * m_Alpha[Dimension]);
+}
+
+void RdSequence::Next(float* Out)
+{
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+		Out[d] = FixedPointToUnitFloat(m_Offset + m_Index * m_Alpha[d]);
+
+	++m_Index;
+}
+
+void RdSequence::Generate(float* Out, uint32_t Count)
+{
+	uint32_t accum[kMaxDimensions];
+	for (uint32_t d = 0; d < m_Dimensions; ++d)
+		accum[d] = m_Offset + m_Index * m_Alpha[d];
+
+	for (uint32_t i = 0; i < Count; ++i, Out += m_Dimensions)
+	{
+		for (uint32_t d = 0; d < m_Dimensions; ++d)
+		{
+			Out[d] = FixedPointToUnitFloat(accum[d]);
+			accum[d] += m_Alpha[d];
+		}
+	}
+
+	m_Index += Count;
+}
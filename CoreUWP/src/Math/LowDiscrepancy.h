@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <cstdint>
+
+namespace HolographicEngine::Math
+{
+	// Low-discrepancy sequences fill the unit hypercube far more evenly than white noise, so sampling
+	// workloads (jittered placement, AO kernels, stochastic effects) converge with fewer samples.  All
+	// generators produce values in [0.0f, 1.0f) and the batch APIs write points interleaved, i.e.
+	// Out[i * Dimensions + d] is dimension d of point i.
+
+	// Maps the high 24 bits of a 32-bit fixed point fraction to [0.0f, 1.0f) without ever rounding to 1.0f.
+	inline float FixedPointToUnitFloat(uint32_t value)
+	{
+		return (float)(value >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// Van der Corput sequence in base 2 (the bits of the index mirrored around the binary point).
+	float RadicalInverseBase2(uint32_t index);
+
+	// Radical inverse of the index in an arbitrary base.
+	float RadicalInverse(uint32_t index, uint32_t base);
+
+	class HaltonSequence
+	{
+	public:
+		static const uint32_t kMaxDimensions = 16;
+
+		// Each dimension uses the next prime as its base.  Skipping a few initial points avoids the
+		// correlated start of the higher dimensions.
+		HaltonSequence(uint32_t Dimensions = 2, uint32_t StartIndex = 0);
+
+		uint32_t GetDimensions(void) const { return m_Dimensions; }
+		uint32_t GetIndex(void) const { return m_Index; }
+
+		// Random access to one coordinate of any point.
+		float Sample(uint32_t Index, uint32_t Dimension) const;
+
+		// Restarts the incremental generator at Index.
+		void Seek(uint32_t Index);
+
+		// Writes the next point (GetDimensions() floats) and advances.
+		void Next(float* Out);
+
+		// Writes Count points (Count * GetDimensions() floats) and advances.  The digits of every
+		// dimension are incremented in place, so each point costs amortized O(Dimensions).
+		void Generate(float* Out, uint32_t Count);
+
+	private:
+
+		static const uint32_t kMaxDigits = 32;
+
+		void Increment(void);
+
+		uint32_t m_Dimensions;
+		uint32_t m_Index;
+		double m_Values[kMaxDimensions];
+		uint8_t m_Digits[kMaxDimensions][kMaxDigits];
+	};
+
+	class SobolSequence
+	{
+	public:
+		static const uint32_t kMaxDimensions = 16;
+
+		// A non-zero seed applies a random digital shift per dimension, which keeps the stratification
+		// properties while decorrelating independent users of the sequence.
+		SobolSequence(uint32_t Dimensions = 2, uint32_t Seed = 0);
+
+		uint32_t GetDimensions(void) const { return m_Dimensions; }
+		uint32_t GetIndex(void) const { return m_Index; }
+
+		// Random access to one coordinate of any point, as a 32-bit fixed point fraction or a float.
+		uint32_t SampleFixed(uint32_t Index, uint32_t Dimension) const;
+		float Sample(uint32_t Index, uint32_t Dimension) const { return FixedPointToUnitFloat(SampleFixed(Index, Dimension)); }
+
+		void Seek(uint32_t Index);
+
+		void Next(float* Out);
+
+		// Gray code order lets each point be produced from the previous one with a single XOR per dimension.
+		void Generate(float* Out, uint32_t Count);
+
+	private:
+
+		uint32_t m_Dimensions;
+		uint32_t m_Index;
+		uint32_t m_State[kMaxDimensions];
+		uint32_t m_Shift[kMaxDimensions];
+	};
+
+	// Roberts' R-sequence: an additive recurrence with the generalized golden ratio for the given number
+	// of dimensions.  It has no upper bound on the point count and is the cheapest generator here.
+	class RdSequence
+	{
+	public:
+		static const uint32_t kMaxDimensions = 16;
+
+		RdSequence(uint32_t Dimensions = 2, float Offset = 0.5f);
+
+		uint32_t GetDimensions(void) const { return m_Dimensions; }
+		uint32_t GetIndex(void) const { return m_Index; }
+
+		float Sample(uint32_t Index, uint32_t Dimension) const;
+
+		void Seek(uint32_t Index) { m_Index = Index; }
+
+		void Next(float* Out);
+
+		void Generate(float* Out, uint32_t Count);
+
+	private:
+
+		// Everything is kept in 32-bit fixed point so that the recurrence wraps exactly and never loses
+		// precision for large indices.
+		uint32_t m_Dimensions;
+		uint32_t m_Index;
+		uint32_t m_Alpha[kMaxDimensions];
+		uint32_t m_Offset;
+	};
+
+	// The two dimensional member of the family, the usual choice for screen space and disk sampling.
+	class R2Sequence : public RdSequence
+	{
+	public:
+		R2Sequence(float Offset = 0.5f) : RdSequence(2, Offset) {}
+	};
+} // namespace Math
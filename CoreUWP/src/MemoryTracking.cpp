@@ -0,0 +1,309 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "MemoryTracking.h"
+#include "EngineTuning.h"
+#include <atomic>
+#include <cstdlib>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::MemoryTracking;
+
+namespace
+{
+	const char* kTagNames[kNumTags] =
+	{
+		"General",
+		"IO",
+		"Graphics",
+		"Input",
+		"Profiling",
+		"Game",
+		"Cache",
+	};
+
+	BoolVar s_AssertNoRenderAllocations("Profiling/Assert No Render Allocations", false);
+
+	// Plain atomics, zero before any constructor runs, so allocations made during static initialization
+	// are counted too.  Each tag has its own cache line since they are updated from every thread.
+	struct alignas(64) TagCounters
+	{
+		std::atomic<int64_t> LiveBytes;
+		std::atomic<int64_t> LiveAllocations;
+		std::atomic<uint64_t> TotalBytes;
+		std::atomic<uint64_t> TotalAllocations;
+		std::atomic<uint64_t> FrameBytes;
+		std::atomic<uint64_t> FrameAllocations;
+
+		// Copied at the end of each frame, and by SetLeakBaseline.
+		std::atomic<uint64_t> LastFrameBytes;
+		std::atomic<uint64_t> LastFrameAllocations;
+		std::atomic<int64_t> BaselineBytes;
+		std::atomic<int64_t> BaselineAllocations;
+	};
+
+	TagCounters s_Tags[kNumTags];
+	std::atomic<uint64_t> s_Frame;
+	std::atomic<uint64_t> s_RenderLoopBytes;
+	std::atomic<uint64_t> s_RenderLoopAllocations;
+	std::atomic<uint64_t> s_LastRenderLoopBytes;
+	std::atomic<uint64_t> s_LastRenderLoopAllocations;
+
+	thread_local Tag t_Tag = kTagGeneral;
+	thread_local uint32_t t_RenderLoopDepth = 0;
+
+#if ENABLE_MEMORY_TRACKING
+
+	// In front of every block.  Offset is from the start of what malloc returned, which is further back
+	// than the header when the block is over-aligned.
+	struct BlockHeader
+	{
+		uint64_t Size;
+		uint32_t Offset;
+		uint32_t Tag;
+	};
+	static_assert(sizeof(BlockHeader) == 16, "The header keeps blocks 16 byte aligned");
+
+	const size_t kMallocAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	void* Allocate(size_t Size, size_t Alignment) noexcept
+	{
+		if (Alignment < kMallocAlignment)
+			Alignment = kMallocAlignment;
+
+		const size_t Padding = Alignment > kMallocAlignment ? Alignment - 1 : 0;
+		if (Size > SIZE_MAX - sizeof(BlockHeader) - Padding)
+			return nullptr;
+
+		unsigned char* Raw = (unsigned char*)malloc(Size + sizeof(BlockHeader) + Padding);
+		if (Raw == nullptr)
+			return nullptr;
+
+		unsigned char* Block = (unsigned char*)(((uintptr_t)Raw + sizeof(BlockHeader) + Alignment - 1) & ~(uintptr_t)(Alignment - 1));
+		BlockHeader* Header = (BlockHeader*)Block - 1;
+		Header->Size = Size;
+		Header->Offset = (uint32_t)(Block - Raw);
+		Header->Tag = t_Tag;
+
+		TagCounters& c = s_Tags[t_Tag];
+		c.LiveBytes.fetch_add((int64_t)Size, std::memory_order_relaxed);
+		c.LiveAllocations.fetch_add(1, std::memory_order_relaxed);
+		c.TotalBytes.fetch_add(Size, std::memory_order_relaxed);
+		c.TotalAllocations.fetch_add(1, std::memory_order_relaxed);
+		c.FrameBytes.fetch_add(Size, std::memory_order_relaxed);
+		c.FrameAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		if (t_RenderLoopDepth != 0)
+		{
+			s_RenderLoopBytes.fetch_add(Size, std::memory_order_relaxed);
+			s_RenderLoopAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		return Block;
+	}
+
+	void Free(void* Block) noexcept
+	{
+		if (Block == nullptr)
+			return;
+
+		const BlockHeader* Header = (const BlockHeader*)Block - 1;
+		TagCounters& c = s_Tags[Header->Tag];
+		c.LiveBytes.fetch_sub((int64_t)Header->Size, std::memory_order_relaxed);
+		c.LiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+		free((unsigned char*)Block - Header->Offset);
+	}
+
+	// What the throwing operators do on failure: call the new handler until it gives up.
+	void* AllocateOrThrow(size_t Size, size_t Alignment)
+	{
+		for (;;)
+		{
+			void* Block = Allocate(Size, Alignment);
+			if (Block != nullptr)
+				return Block;
+
+			std::new_handler Handler = std::get_new_handler();
+			if (Handler == nullptr)
+				throw std::bad_alloc();
+			Handler();
+		}
+	}
+
+	void* AllocateNoThrow(size_t Size, size_t Alignment) noexcept
+	{
+		try
+		{
+			return AllocateOrThrow(Size, Alignment);
+		}
+		catch (...)
+		{
+			return nullptr;
+		}
+	}
+
+#endif
+
+	TagStats GetTagStats(const TagCounters& c)
+	{
+		TagStats Result;
+		Result.LiveBytes = c.LiveBytes.load(std::memory_order_relaxed);
+		Result.LiveAllocations = c.LiveAllocations.load(std::memory_order_relaxed);
+		Result.TotalBytes = c.TotalBytes.load(std::memory_order_relaxed);
+		Result.TotalAllocations = c.TotalAllocations.load(std::memory_order_relaxed);
+		Result.FrameBytes = c.LastFrameBytes.load(std::memory_order_relaxed);
+		Result.FrameAllocations = c.LastFrameAllocations.load(std::memory_order_relaxed);
+		return Result;
+	}
+}
+
+#if ENABLE_MEMORY_TRACKING
+
+void* operator new(size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, (size_t)alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, (size_t)alignment); }
+
+void operator delete(void* block) noexcept { Free(block); }
+void operator delete[](void* block) noexcept { Free(block); }
+void operator delete(void* block, size_t) noexcept { Free(block); }
+void operator delete[](void* block, size_t) noexcept { Free(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { Free(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { Free(block); }
+void operator delete(void* block, std::align_val_t) noexcept { Free(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { Free(block); }
+void operator delete(void* block, size_t, std::align_val_t) noexcept { Free(block); }
+void operator delete[](void* block, size_t, std::align_val_t) noexcept { Free(block); }
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept { Free(block); }
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept { Free(block); }
+
+#endif
+
+const char* HolographicEngine::MemoryTracking::GetTagName(Tag tag)
+{
+	return tag < kNumTags ? kTagNames[tag] : "";
+}
+
+Tag HolographicEngine::MemoryTracking::GetCurrentTag(void)
+{
+	return t_Tag;
+}
+
+void HolographicEngine::MemoryTracking::SetCurrentTag(Tag tag)
+{
+	ASSERT(tag < kNumTags, "Not a memory tag");
+	t_Tag = tag;
+}
+
+HolographicEngine::MemoryTracking::RenderLoopScope::RenderLoopScope()
+{
+	++t_RenderLoopDepth;
+}
+
+HolographicEngine::MemoryTracking::RenderLoopScope::~RenderLoopScope()
+{
+	--t_RenderLoopDepth;
+}
+
+bool HolographicEngine::MemoryTracking::IsEnabled(void)
+{
+	return ENABLE_MEMORY_TRACKING != 0;
+}
+
+void HolographicEngine::MemoryTracking::Update(void)
+{
+	for (TagCounters& c : s_Tags)
+	{
+		c.LastFrameBytes.store(c.FrameBytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		c.LastFrameAllocations.store(c.FrameAllocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	const uint64_t RenderLoopAllocations = s_RenderLoopAllocations.exchange(0, std::memory_order_relaxed);
+	s_LastRenderLoopAllocations.store(RenderLoopAllocations, std::memory_order_relaxed);
+	s_LastRenderLoopBytes.store(s_RenderLoopBytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+	s_Frame.fetch_add(1, std::memory_order_relaxed);
+
+	ASSERT(!s_AssertNoRenderAllocations || RenderLoopAllocations == 0, "The render loop allocated during the last frame");
+}
+
+Stats HolographicEngine::MemoryTracking::GetStats(void)
+{
+	Stats Result;
+	Result.Frame = s_Frame.load(std::memory_order_relaxed);
+	for (int i = 0; i < kNumTags; ++i)
+		Result.Tags[i] = GetTagStats(s_Tags[i]);
+	Result.RenderLoopBytes = s_LastRenderLoopBytes.load(std::memory_order_relaxed);
+	Result.RenderLoopAllocations = s_LastRenderLoopAllocations.load(std::memory_order_relaxed);
+	return Result;
+}
+
+uint64_t HolographicEngine::MemoryTracking::GetRenderLoopAllocations(void)
+{
+	return s_LastRenderLoopAllocations.load(std::memory_order_relaxed);
+}
+
+void HolographicEngine::MemoryTracking::SetLeakBaseline(void)
+{
+	for (TagCounters& c : s_Tags)
+	{
+		c.BaselineBytes.store(c.LiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		c.BaselineAllocations.store(c.LiveAllocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+void HolographicEngine::MemoryTracking::ReportLeaks(void)
+{
+	if (!IsEnabled())
+		return;
+
+	// Only the tags whose live allocations grew since the baseline; memory freed by then is not a leak,
+	// and what startup keeps for the whole run is not either.  Nor is what the profiler and the caches
+	// have collected since, which they keep until the process exits.
+	bool Leaked = false;
+	for (int i = 0; i < kNumTags; ++i)
+	{
+		if (i == kTagProfiling || i == kTagCache)
+			continue;
+
+		const TagCounters& c = s_Tags[i];
+		const int64_t Allocations = c.LiveAllocations.load(std::memory_order_relaxed) - c.BaselineAllocations.load(std::memory_order_relaxed);
+		const int64_t Bytes = c.LiveBytes.load(std::memory_order_relaxed) - c.BaselineBytes.load(std::memory_order_relaxed);
+		if (Allocations <= 0)
+			continue;
+
+		if (!Leaked)
+			Utility::Printf("Memory still allocated at shutdown, beyond the startup baseline:\n");
+		Leaked = true;
+		Utility::Printf("  %-10s %lld bytes in %lld allocations\n", kTagNames[i], (long long)Bytes, (long long)Allocations);
+	}
+
+	if (!Leaked)
+		Utility::Printf("No memory leaked since the startup baseline\n");
+}
+
+void HolographicEngine::MemoryTracking::Print(void)
+{
+	if (!IsEnabled())
+		return;
+
+	const Stats s = GetStats();
+	Utility::Printf("Frame %llu allocations: %llu in the render loop (%llu bytes)\n", s.Frame,
+		s.RenderLoopAllocations, s.RenderLoopBytes);
+	Utility::Printf("  %-10s %12s %10s %10s %10s\n", "Tag", "Live bytes", "Live", "Frame", "Frame KB");
+	for (int i = 0; i < kNumTags; ++i)
+	{
+		const TagStats& t = s.Tags[i];
+		Utility::Printf("  %-10s %12lld %10lld %10llu %10.1f\n", kTagNames[i], (long long)t.LiveBytes,
+			(long long)t.LiveAllocations, t.FrameAllocations, t.FrameBytes / 1024.0);
+	}
+}
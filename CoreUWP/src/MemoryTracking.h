@@ -0,0 +1,159 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Counts heap allocations by subsystem and by frame.
+//
+// Every operator new and delete in the app goes through this module, which puts a small header in front
+// of each block recording its size and the tag it was allocated under.  The tag is the calling thread's
+// current one, set with ScopedTag around a subsystem's work, or fixed for a container's blocks with
+// TaggedAllocator.  Frees are counted against the tag of the allocation, whichever thread frees it.
+//
+// Update closes a frame, so GetStats has both the live totals and the last frame's allocations.  Work
+// inside a RenderLoopScope is counted apart: in steady state the render loop should not allocate at all,
+// and with "Profiling/Assert No Render Allocations" set a frame that does asserts.  ReportLeaks, at
+// shutdown, prints what is still allocated since SetLeakBaseline, except under the Profiling and Cache
+// tags: the profiler and the caches keep what they collect for the rest of the run, up to their limits.
+//
+// Tracking costs a 16 byte header and a few atomic adds per allocation, and replaces the global operator
+// new and delete of whatever links this file, so a block must be freed by the module that allocated it.
+// It is opt-in: only builds that define HE_INSTRUMENTATION, as the Debug configurations do, track.
+// Elsewhere the counters all read zero.  Define ENABLE_MEMORY_TRACKING to choose either way.
+
+#ifndef ENABLE_MEMORY_TRACKING
+#ifdef HE_INSTRUMENTATION
+#define ENABLE_MEMORY_TRACKING 1
+#else
+#define ENABLE_MEMORY_TRACKING 0
+#endif
+#endif
+
+namespace HolographicEngine::MemoryTracking
+{
+	enum Tag : uint8_t
+	{
+		kTagGeneral,
+		kTagIO,
+		kTagGraphics,
+		kTagInput,
+		kTagProfiling,
+		kTagGame,
+		kTagCache,          // The bookkeeping of caches and registries that live for the whole run
+		kNumTags
+	};
+
+	const char* GetTagName(Tag tag);
+
+	// The tag the calling thread's allocations are counted under.
+	Tag GetCurrentTag(void);
+	void SetCurrentTag(Tag tag);
+
+	class ScopedTag
+	{
+	public:
+		explicit ScopedTag(Tag tag) : m_Previous(GetCurrentTag()) { SetCurrentTag(tag); }
+		~ScopedTag() { SetCurrentTag(m_Previous); }
+
+	private:
+		ScopedTag(const ScopedTag&) = delete;
+		ScopedTag& operator=(const ScopedTag&) = delete;
+
+		Tag m_Previous;
+	};
+
+	// Counts the calling thread's allocations as the render loop's while it lives.  Scopes nest.
+	class RenderLoopScope
+	{
+	public:
+		RenderLoopScope();
+		~RenderLoopScope();
+
+	private:
+		RenderLoopScope(const RenderLoopScope&) = delete;
+		RenderLoopScope& operator=(const RenderLoopScope&) = delete;
+	};
+
+	// An STL allocator whose blocks are always counted under one tag, for containers that outlive the
+	// scope they are filled in, or are filled from many.
+	template <typename T, Tag tag>
+	class TaggedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind
+		{
+			typedef TaggedAllocator<U, tag> other;
+		};
+
+		TaggedAllocator() noexcept {}
+		template <typename U>
+		TaggedAllocator(const TaggedAllocator<U, tag>&) noexcept {}
+
+		T* allocate(size_t count)
+		{
+			ScopedTag Tagged(tag);
+			return static_cast<T*>(::operator new(count * sizeof(T)));
+		}
+
+		void deallocate(T* pointer, size_t)
+		{
+			::operator delete(pointer);
+		}
+
+		template <typename U>
+		bool operator==(const TaggedAllocator<U, tag>&) const noexcept { return true; }
+		template <typename U>
+		bool operator!=(const TaggedAllocator<U, tag>&) const noexcept { return false; }
+	};
+
+	struct TagStats
+	{
+		int64_t LiveBytes;
+		int64_t LiveAllocations;
+		uint64_t TotalBytes;
+		uint64_t TotalAllocations;
+
+		// During the last frame closed by Update.
+		uint64_t FrameBytes;
+		uint64_t FrameAllocations;
+	};
+
+	struct Stats
+	{
+		uint64_t Frame;
+		TagStats Tags[kNumTags];
+
+		// Made inside a RenderLoopScope during the last frame.
+		uint64_t RenderLoopBytes;
+		uint64_t RenderLoopAllocations;
+	};
+
+	// False when the tracking is compiled out.
+	bool IsEnabled(void);
+
+	// Closes the frame.  Called once per frame, first thing.
+	void Update(void);
+
+	Stats GetStats(void);
+	uint64_t GetRenderLoopAllocations(void);
+
+	// Marks what is allocated now, once startup is done, as not leaked.
+	void SetLeakBaseline(void);
+
+	// Prints, by tag, what is allocated beyond the baseline.  Called at shutdown, once the caches are
+	// trimmed, so that only their bookkeeping is left.
+	void ReportLeaks(void);
+
+	void Print(void);
+}
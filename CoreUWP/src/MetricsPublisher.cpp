@@ -0,0 +1,264 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "MetricsPublisher.h"
+#include "AsyncIO.h"
+#include "EngineTuning.h"
+#include "FrameCounters.h"
+#include "HardwareCounters.h"
+#include "MemoryTracking.h"
+#include <mutex>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::MetricsRing;
+
+namespace
+{
+	const wchar_t* kRingName = L"EngineMetrics.bin";
+
+	// On by default only in HE_INSTRUMENTATION builds; EngineTuning.txt can turn it on in any.
+#ifdef HE_INSTRUMENTATION
+	BoolVar s_MetricsExport("Profiling/Metrics Export", true);
+#else
+	BoolVar s_MetricsExport("Profiling/Metrics Export", false);
+#endif
+
+	enum BuiltInChannel
+	{
+		kChannelFrameMs,
+		kChannelMainMcycles,
+		kChannelFrameAllocations,
+		kChannelRenderLoopAllocations,
+		kChannelLiveMB,
+		kChannelReadsInFlight,
+		kChannelReadMB,
+		kChannelDrawCalls,
+		kChannelTriangles,
+		kNumBuiltInChannels
+	};
+
+	const char* kBuiltInNames[kNumBuiltInChannels] =
+	{
+		"Frame ms",
+		"Main Mcycles",
+		"Allocations",
+		"Render Allocs",
+		"Live MB",
+		"Reads In Flight",
+		"Read MB",
+		"Draw Calls",
+		"Triangles",
+	};
+
+	struct Publisher
+	{
+		Publisher()
+		{
+			for (int i = 0; i < kNumBuiltInChannels; ++i)
+				strncpy_s(Names[i], kBuiltInNames[i], kMaxNameLength - 1);
+			NumChannels = kNumBuiltInChannels;
+
+			// Only published where instructions are counted, rather than as a column of zeros.
+			if (HardwareCounters::IsAvailable(HardwareCounters::kInstructions))
+			{
+				strncpy_s(Names[NumChannels], "Main IPC", kMaxNameLength - 1);
+				MainIPCChannel = (int)NumChannels++;
+			}
+		}
+
+		// Adding channels is the only thing that locks.
+		std::mutex ChannelMutex;
+		char Names[kMaxChannels][kMaxNameLength] = {};
+		std::atomic<uint32_t> NumChannels;
+		std::atomic<float> Values[kMaxChannels] = {};
+
+		HANDLE File = INVALID_HANDLE_VALUE;
+		HANDLE Mapping = nullptr;
+		Header* Ring = nullptr;
+
+		// Main thread only.
+		int64_t StartTick = 0;
+		HardwareCounters::Sample LastCounts = {};
+		int MainIPCChannel = -1;
+		uint64_t LastBytesRead = 0;
+	};
+
+	Publisher& GetPublisher(void)
+	{
+		static Publisher s_Publisher;
+		return s_Publisher;
+	}
+
+	std::wstring GetRingPath(void)
+	{
+		try
+		{
+			using namespace winrt::Windows::Storage;
+			return std::wstring(ApplicationData::Current().LocalFolder().Path().c_str()) + L"\\" + kRingName;
+		}
+		catch (winrt::hresult_error const&)
+		{
+			return std::wstring();
+		}
+	}
+
+	// The frame's figures from the engine, all read without a lock.
+	void SetBuiltInValues(Publisher& p)
+	{
+		p.Values[kChannelFrameMs].store(Graphics::GetFrameTime() * 1000.0f, std::memory_order_relaxed);
+
+		HardwareCounters::Sample Counts;
+		HardwareCounters::Read(Counts);
+		HardwareCounters::Sample Delta;
+		for (int i = 0; i < HardwareCounters::kNumCounters; ++i)
+			Delta.Values[i] = Counts.Values[i] - p.LastCounts.Values[i];
+		p.LastCounts = Counts;
+		p.Values[kChannelMainMcycles].store((float)(Delta[HardwareCounters::kCycles] * 1e-6), std::memory_order_relaxed);
+		if (p.MainIPCChannel >= 0)
+			p.Values[p.MainIPCChannel].store((float)Delta.GetIPC(), std::memory_order_relaxed);
+
+		const MemoryTracking::Stats Memory = MemoryTracking::GetStats();
+		uint64_t FrameAllocations = 0;
+		int64_t LiveBytes = 0;
+		for (const MemoryTracking::TagStats& t : Memory.Tags)
+		{
+			FrameAllocations += t.FrameAllocations;
+			LiveBytes += t.LiveBytes;
+		}
+		p.Values[kChannelFrameAllocations].store((float)FrameAllocations, std::memory_order_relaxed);
+		p.Values[kChannelRenderLoopAllocations].store((float)Memory.RenderLoopAllocations, std::memory_order_relaxed);
+		p.Values[kChannelLiveMB].store((float)(LiveBytes / (1024.0 * 1024.0)), std::memory_order_relaxed);
+
+		const AsyncIO::Stats IO = AsyncIO::GetStats();
+		p.Values[kChannelReadsInFlight].store((float)IO.InFlight, std::memory_order_relaxed);
+		p.Values[kChannelReadMB].store((float)((IO.BytesRead - p.LastBytesRead) / (1024.0 * 1024.0)), std::memory_order_relaxed);
+		p.LastBytesRead = IO.BytesRead;
+
+		const FrameCounters::Counts Render = FrameCounters::GetFrameCounts();
+		p.Values[kChannelDrawCalls].store((float)Render[FrameCounters::kDrawCalls], std::memory_order_relaxed);
+		p.Values[kChannelTriangles].store((float)Render[FrameCounters::kTriangles], std::memory_order_relaxed);
+	}
+}
+
+bool HolographicEngine::MetricsPublisher::Initialize(uint32_t capacity)
+{
+	Publisher& p = GetPublisher();
+	ASSERT(p.Ring == nullptr && capacity > 0);
+
+	const std::wstring Path = GetRingPath();
+	if (Path.empty())
+		return false;
+
+	// Opened, not recreated, since a reader may still have the last session's file mapped, which would
+	// make truncating it fail.  Mapping it at its new size grows it when needed.
+	p.File = CreateFile2(Path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_ALWAYS, nullptr);
+	if (p.File == INVALID_HANDLE_VALUE)
+		return false;
+
+	const size_t Size = GetSize(capacity);
+	p.Mapping = CreateFileMappingFromApp(p.File, nullptr, PAGE_READWRITE, Size, nullptr);
+	Header* Ring = p.Mapping != nullptr ? (Header*)MapViewOfFileFromApp(p.Mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, Size) : nullptr;
+	if (Ring == nullptr)
+	{
+		Shutdown();
+		return false;
+	}
+
+	// Invalidate the old session before touching anything a reader of it could be copying.
+	Ring->Magic.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memset(GetRecords(Ring), 0, (size_t)capacity * sizeof(Record));
+
+	p.StartTick = SystemTime::GetCurrentTick();
+	HardwareCounters::Read(p.LastCounts);
+	p.LastBytesRead = AsyncIO::GetStats().BytesRead;
+
+	{
+		std::lock_guard<std::mutex> guard(p.ChannelMutex);
+		Ring->Version = kVersion;
+		Ring->Capacity = capacity;
+		Ring->Session = (uint64_t)p.StartTick;
+		Ring->WriteCount.store(0, std::memory_order_relaxed);
+		memcpy(Ring->ChannelNames, p.Names, sizeof(p.Names));
+		Ring->NumChannels.store(p.NumChannels, std::memory_order_relaxed);
+		Ring->Magic.store(kMagic, std::memory_order_release);
+		p.Ring = Ring;
+	}
+
+	return true;
+}
+
+void HolographicEngine::MetricsPublisher::Shutdown(void)
+{
+	Publisher& p = GetPublisher();
+	std::lock_guard<std::mutex> guard(p.ChannelMutex);
+
+	if (p.Ring != nullptr)
+		UnmapViewOfFile(p.Ring);
+	if (p.Mapping != nullptr)
+		CloseHandle(p.Mapping);
+	if (p.File != INVALID_HANDLE_VALUE)
+		CloseHandle(p.File);
+
+	p.Ring = nullptr;
+	p.Mapping = nullptr;
+	p.File = INVALID_HANDLE_VALUE;
+}
+
+int HolographicEngine::MetricsPublisher::AddChannel(const char* name)
+{
+	Publisher& p = GetPublisher();
+	std::lock_guard<std::mutex> guard(p.ChannelMutex);
+
+	const uint32_t Channel = p.NumChannels.load(std::memory_order_relaxed);
+	if (Channel == kMaxChannels)
+		return -1;
+
+	strncpy_s(p.Names[Channel], name, kMaxNameLength - 1);
+	p.Values[Channel].store(0.0f, std::memory_order_relaxed);
+	p.NumChannels.store(Channel + 1, std::memory_order_release);
+
+	if (p.Ring != nullptr)
+	{
+		memcpy(p.Ring->ChannelNames[Channel], p.Names[Channel], kMaxNameLength);
+		p.Ring->NumChannels.store(Channel + 1, std::memory_order_release);
+	}
+
+	return (int)Channel;
+}
+
+void HolographicEngine::MetricsPublisher::SetValue(int channel, float value)
+{
+	if (channel >= 0 && channel < (int)kMaxChannels)
+		GetPublisher().Values[channel].store(value, std::memory_order_relaxed);
+}
+
+void HolographicEngine::MetricsPublisher::Update(void)
+{
+	Publisher& p = GetPublisher();
+	if (p.Ring == nullptr || !s_MetricsExport)
+		return;
+
+	SetBuiltInValues(p);
+
+	Sample Published;
+	Published.Frame = Graphics::GetFrameCount();
+	Published.Time = SystemTime::TimeBetweenTicks(p.StartTick, SystemTime::GetCurrentTick());
+
+	const uint32_t NumChannels = p.NumChannels.load(std::memory_order_acquire);
+	for (uint32_t i = 0; i < kMaxChannels; ++i)
+		Published.Values[i] = i < NumChannels ? p.Values[i].load(std::memory_order_relaxed) : 0.0f;
+
+	Write(p.Ring, Published);
+}
+
+uint64_t HolographicEngine::MetricsPublisher::GetPublishedCount(void)
+{
+	Publisher& p = GetPublisher();
+	return p.Ring != nullptr ? p.Ring->WriteCount.load(std::memory_order_relaxed) : 0;
+}
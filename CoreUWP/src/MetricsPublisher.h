@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "MetricsRing.h"
+
+// Publishes a record of metrics every frame into a ring in shared memory, for a viewer running outside
+// the app such as Tools/MetricsReader.
+//
+// The ring is a mapping of EngineMetrics.bin in the app's local folder.  A file rather than a named
+// section, since a desktop process cannot open the app container's named objects but can map the same
+// file, and the views of one file are coherent between processes.
+//
+// Each record has the frame time, the main thread's cycles and instructions per cycle, the allocations
+// from MemoryTracking, the reads from AsyncIO and the draws and triangles from FrameCounters, all read
+// from atomics.  The game can add channels of its own and set them from any thread.  Publishing never
+// takes a lock or waits for the reader, and is skipped while the "Profiling/Metrics Export" setting is
+// off, which it is by default unless the build defines HE_INSTRUMENTATION.
+
+namespace HolographicEngine::MetricsPublisher
+{
+	// 68 seconds at 60 Hz, about 640 KB.
+	const uint32_t kDefaultCapacity = 4096;
+
+	// Maps the ring and starts a new session in it.  False when there is nowhere to keep it, in which
+	// case the other functions do nothing.
+	bool Initialize(uint32_t capacity = kDefaultCapacity);
+	void Shutdown(void);
+
+	// Adds a channel, returning its index, or -1 once there are MetricsRing::kMaxChannels.  Meant for
+	// startup; the reader picks up later ones but does not show them in the records before.
+	int AddChannel(const char* name);
+
+	// The channel's value in the records published from now on.  Any thread.
+	void SetValue(int channel, float value);
+
+	// Writes the record for the frame that just ended.  Called once per frame, on the main thread.
+	void Update(void);
+
+	uint64_t GetPublishedCount(void);
+}
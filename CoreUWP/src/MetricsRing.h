@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// The layout of the metrics ring that MetricsPublisher writes and Tools/MetricsReader reads, shared by
+// both, so it depends on nothing else in the engine.
+//
+// A Header, then Capacity records.  Record n of the session is in slot n % Capacity.  Its Sequence is
+// 2n+1 while it is written and 2n+2 once done, so a reader that copies a record between two loads of
+// the same even value has a whole one, and the writer never waits for readers.  WriteCount is the
+// number of records written.  Session changes whenever the app starts again on the same file.
+
+namespace HolographicEngine::MetricsRing
+{
+	const uint32_t kMagic = 0x524D4548;		// "HEMR"
+	const uint32_t kVersion = 1;
+	const uint32_t kMaxChannels = 32;
+	const uint32_t kMaxNameLength = 32;
+
+	struct Header
+	{
+		std::atomic<uint32_t> Magic;		// Written last, once the rest is valid
+		uint32_t Version;
+		uint32_t Capacity;
+		std::atomic<uint32_t> NumChannels;	// A channel's name is written before the count includes it
+		uint64_t Session;
+		std::atomic<uint64_t> WriteCount;
+		char ChannelNames[kMaxChannels][kMaxNameLength];
+	};
+
+	struct Sample
+	{
+		uint64_t Frame;
+		double Time;						// Seconds since the session started
+		float Values[kMaxChannels];
+	};
+
+	struct Record
+	{
+		std::atomic<uint64_t> Sequence;
+		Sample Data;
+	};
+
+	static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "The layout is shared between processes");
+
+	inline size_t GetSize(uint32_t capacity)
+	{
+		return sizeof(Header) + (size_t)capacity * sizeof(Record);
+	}
+
+	inline Record* GetRecords(Header* header)
+	{
+		return reinterpret_cast<Record*>(header + 1);
+	}
+
+	inline const Record* GetRecords(const Header* header)
+	{
+		return reinterpret_cast<const Record*>(header + 1);
+	}
+
+	// Copies record n.  False if it is being written, or was overwritten by a later one.
+	inline bool Read(const Header* header, uint64_t n, Sample& sample)
+	{
+		const Record& r = GetRecords(header)[n % header->Capacity];
+		const uint64_t Done = 2 * n + 2;
+		if (r.Sequence.load(std::memory_order_acquire) != Done)
+			return false;
+
+		memcpy(&sample, &r.Data, sizeof(sample));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return r.Sequence.load(std::memory_order_relaxed) == Done;
+	}
+
+	// Only one thread may write.
+	inline void Write(Header* header, const Sample& sample)
+	{
+		const uint64_t n = header->WriteCount.load(std::memory_order_relaxed);
+		Record& r = GetRecords(header)[n % header->Capacity];
+
+		r.Sequence.store(2 * n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy(&r.Data, &sample, sizeof(sample));
+		r.Sequence.store(2 * n + 2, std::memory_order_release);
+
+		header->WriteCount.store(n + 1, std::memory_order_release);
+	}
+}
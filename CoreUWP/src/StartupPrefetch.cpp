@@ -0,0 +1,275 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "StartupPrefetch.h"
+#include "FileUtility.h"
+#include "InstrumentedMutex.h"
+#include "SystemTime.h"
+#include <atomic>
+#include <unordered_set>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Utility;
+
+namespace
+{
+	const wchar_t* kManifestName = L"StartupManifest.txt";
+	const char* kManifestHeader = "# Files opened during startup, in order.  Written by StartupPrefetch.\n";
+	const size_t kMaxEntries = 1024;
+
+	struct Recorder
+	{
+		InstrumentedMutex Mutex{ "IO/Startup Prefetch" };
+		std::atomic<bool> Recording = false;
+		int64_t StartTick = 0;
+		float RecordSeconds = 0.0f;
+		std::wstring ManifestPath;
+
+		std::vector<std::wstring> Recorded;
+		std::unordered_set<std::wstring> Seen;
+
+		std::vector<std::wstring> Prefetched;
+
+		// Kept mapped while the prefetches are in flight and until the recording window ends.
+		std::vector<shared_ptr<MappedFile> > Mappings;
+	};
+
+	Recorder& GetRecorder(void)
+	{
+		static Recorder s_Recorder;
+		return s_Recorder;
+	}
+
+	// Set on the threads that open files on the manifest's behalf, so that prefetching a file does not
+	// count as a request for it.
+	thread_local bool t_Prefetching = false;
+
+	std::wstring GetManifestPath(void)
+	{
+		try
+		{
+			using namespace winrt::Windows::Storage;
+			return std::wstring(ApplicationData::Current().LocalFolder().Path().c_str()) + L"\\" + kManifestName;
+		}
+		catch (winrt::hresult_error const&)
+		{
+			// No package identity, so nowhere to keep the manifest.
+			return std::wstring();
+		}
+	}
+
+	// Package files are recorded by URI; mapping them needs a path relative to the install folder.
+	std::wstring ToFilePath(const std::wstring& fileName)
+	{
+		const wchar_t* kAppxPrefix = L"ms-appx:///";
+		if (fileName.compare(0, wcslen(kAppxPrefix), kAppxPrefix) != 0)
+			return fileName;
+
+		std::wstring Path = fileName.substr(wcslen(kAppxPrefix));
+		for (wchar_t& c : Path)
+		{
+			if (c == L'/')
+				c = L'\\';
+		}
+		return Path;
+	}
+
+	// Stops recording and writes what was recorded.  Returns the mappings to release outside the lock.
+	std::vector<shared_ptr<MappedFile> > StopLocked(Recorder& r, std::string& Manifest)
+	{
+		r.Recording = false;
+		Manifest = StartupPrefetch::FormatManifest(r.Recorded);
+		return std::move(r.Mappings);
+	}
+
+	void SaveManifest(const std::wstring& Path, const std::string& Manifest)
+	{
+		if (!Path.empty() && !WriteFileSync(Path, Manifest.data(), Manifest.size()))
+			Utility::Printf("StartupPrefetch: could not write %ws\n", Path.c_str());
+	}
+}
+
+std::string HolographicEngine::StartupPrefetch::FormatManifest(const std::vector<std::wstring>& fileNames)
+{
+	std::string Text = kManifestHeader;
+
+	for (const std::wstring& Name : fileNames)
+	{
+		const int NumBytes = WideCharToMultiByte(CP_UTF8, 0, Name.c_str(), (int)Name.size(), nullptr, 0, nullptr, nullptr);
+		const size_t Start = Text.size();
+		Text.resize(Start + NumBytes);
+		WideCharToMultiByte(CP_UTF8, 0, Name.c_str(), (int)Name.size(), &Text[Start], NumBytes, nullptr, nullptr);
+		Text += '\n';
+	}
+
+	return Text;
+}
+
+std::vector<std::wstring> HolographicEngine::StartupPrefetch::ParseManifest(const char* text, size_t size)
+{
+	std::vector<std::wstring> Names;
+	const char* End = text + size;
+
+	for (const char* Line = text; Line < End; )
+	{
+		const char* LineEnd = (const char*)memchr(Line, '\n', End - Line);
+		if (LineEnd == nullptr)
+			LineEnd = End;
+
+		size_t Length = LineEnd - Line;
+		if (Length > 0 && Line[Length - 1] == '\r')
+			--Length;
+
+		if (Length > 0 && Line[0] != '#')
+		{
+			const int NumChars = MultiByteToWideChar(CP_UTF8, 0, Line, (int)Length, nullptr, 0);
+			std::wstring Name(NumChars, L'\0');
+			MultiByteToWideChar(CP_UTF8, 0, Line, (int)Length, &Name[0], NumChars);
+			Names.push_back(std::move(Name));
+		}
+
+		Line = LineEnd + 1;
+	}
+
+	return Names;
+}
+
+void HolographicEngine::StartupPrefetch::Initialize(float recordSeconds)
+{
+	Recorder& r = GetRecorder();
+	std::vector<std::wstring> Manifest;
+
+	{
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+		r.ManifestPath = GetManifestPath();
+
+		if (!r.ManifestPath.empty())
+		{
+			t_Prefetching = true;
+			shared_ptr<MappedFile> File = MappedFile::Open(r.ManifestPath, kMapSequential);
+			t_Prefetching = false;
+
+			if (File != nullptr)
+				Manifest = ParseManifest((const char*)File->View().Data(), File->Size());
+		}
+
+		r.Prefetched = Manifest;
+		r.Recorded.clear();
+		r.Seen.clear();
+		r.StartTick = SystemTime::GetCurrentTick();
+		r.RecordSeconds = recordSeconds;
+		r.Recording = !r.ManifestPath.empty();
+	}
+
+	// MappedFile::Open reports what it opens here; the other readers call RecordRequest themselves.
+	SetOpenObserver(&RecordRequest);
+
+	if (Manifest.empty())
+		return;
+
+	// Opening and mapping is quick; the reads themselves are queued by the OS all at once and complete
+	// in the background while the rest of the engine starts up.
+	create_task([Manifest]
+	{
+		t_Prefetching = true;
+
+		std::vector<shared_ptr<MappedFile> > Mappings;
+		for (const std::wstring& Name : Manifest)
+		{
+			shared_ptr<MappedFile> File = MappedFile::Open(ToFilePath(Name), kMapWillNeed);
+			if (File != nullptr)
+				Mappings.push_back(std::move(File));
+		}
+
+		t_Prefetching = false;
+
+		Recorder& r = GetRecorder();
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+		// If recording already ended the mappings are simply released when this returns.
+		if (r.Recording)
+			r.Mappings = std::move(Mappings);
+	});
+}
+
+void HolographicEngine::StartupPrefetch::Update(void)
+{
+	Recorder& r = GetRecorder();
+	if (!r.Recording)
+		return;
+
+	std::string Manifest;
+	std::vector<shared_ptr<MappedFile> > Mappings;
+	std::wstring Path;
+
+	{
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+		const double Elapsed = SystemTime::TimeBetweenTicks(r.StartTick, SystemTime::GetCurrentTick());
+		if (!r.Recording || Elapsed < r.RecordSeconds)
+			return;
+
+		Mappings = StopLocked(r, Manifest);
+		Path = r.ManifestPath;
+	}
+
+	// Keep the file write off the frame.
+	create_task([Path, Manifest] { SaveManifest(Path, Manifest); });
+}
+
+void HolographicEngine::StartupPrefetch::Shutdown(void)
+{
+	Recorder& r = GetRecorder();
+	std::string Manifest;
+	std::vector<shared_ptr<MappedFile> > Mappings;
+	std::wstring Path;
+
+	{
+		std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+		if (!r.Recording)
+			return;
+
+		Mappings = StopLocked(r, Manifest);
+		Path = r.ManifestPath;
+	}
+
+	SaveManifest(Path, Manifest);
+}
+
+void HolographicEngine::StartupPrefetch::RecordRequest(const std::wstring& fileName)
+{
+	Recorder& r = GetRecorder();
+	if (!r.Recording || t_Prefetching)
+		return;
+
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+
+	if (!r.Recording || r.Recorded.size() >= kMaxEntries)
+		return;
+
+	if (SystemTime::TimeBetweenTicks(r.StartTick, SystemTime::GetCurrentTick()) >= r.RecordSeconds)
+		return;
+
+	if (r.Seen.insert(fileName).second)
+		r.Recorded.push_back(fileName);
+}
+
+std::vector<std::wstring> HolographicEngine::StartupPrefetch::GetPrefetchedFiles(void)
+{
+	Recorder& r = GetRecorder();
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+	return r.Prefetched;
+}
+
+std::vector<std::wstring> HolographicEngine::StartupPrefetch::GetRecordedFiles(void)
+{
+	Recorder& r = GetRecorder();
+	std::lock_guard<InstrumentedMutex> Guard(r.Mutex);
+	return r.Recorded;
+}
@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Takes file IO off the startup critical path.
+//
+// During the first seconds of a run every file the engine opens is recorded, in the order first opened, and
+// the list is then saved as a manifest in the app's local folder.  On the next launch Initialize reads that
+// manifest and asks the OS to read every file on it at once, in the background, before the game's
+// Startup asks for the first one.  By the time code opens a file its pages are usually already in memory.
+//
+// Files are recorded where they are actually opened: MappedFile::Open, through the open observer that
+// Initialize sets, AsyncIO::File::Open and ReadFileUWPSync.  A file that fails to open is not recorded.
+
+namespace HolographicEngine::StartupPrefetch
+{
+	const float kDefaultRecordSeconds = 10.0f;
+
+	// Loads the manifest from the previous run, starts prefetching it, and starts recording this run.
+	void Initialize(float recordSeconds = kDefaultRecordSeconds);
+
+	// Called every frame.  Saves the manifest once the recording window has passed.
+	void Update(void);
+
+	// Saves the manifest now if it has not been saved yet, and stops recording.
+	void Shutdown(void);
+
+	// Notes that a file was opened.  Does nothing outside the recording window.
+	void RecordRequest(const std::wstring& fileName);
+
+	// Manifest entries from the previous run, and files recorded so far in this one.
+	std::vector<std::wstring> GetPrefetchedFiles(void);
+	std::vector<std::wstring> GetRecordedFiles(void);
+
+	// The manifest text, one UTF-8 path per line.  Lines starting with '#' are comments.
+	std::string FormatManifest(const std::vector<std::wstring>& fileNames);
+	std::vector<std::wstring> ParseManifest(const char* text, size_t size);
+}
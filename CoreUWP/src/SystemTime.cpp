@@ -7,27 +7,228 @@
 
 #include "pch.h"
 #include "SystemTime.h"
+#include "CpuFeatures.h"
+
+#if !defined(_WIN32)
+#include <time.h>
+#elif !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 double HolographicEngine::SystemTime::sm_CpuTickDelta = 0.0;
+double HolographicEngine::SystemTime::sm_OSTickDelta = 0.0;
+bool HolographicEngine::SystemTime::sm_UseTsc = false;
+
+namespace
+{
+	bool s_Initialized = false;
+
+	// How long the TSC is measured against the OS clock.  The error in the OS clock readings is well
+	// under a microsecond, so this is accurate to better than 100 parts per million.
+	const double kCalibrationSeconds = 0.01;
+
+	// Never spin for less than this, since the OS clock and the wake-up itself have some jitter.  Nor for
+	// more than the maximum, since a wake-up that late is the scheduler preempting the thread, which
+	// spinning cannot reliably make up for.
+	const double kMinSpinSeconds = 0.0002;
+	const double kMaxSpinSeconds = 0.004;
+
+	double GetOSTickDelta(void)
+	{
+#if defined(_WIN32)
+		LARGE_INTEGER frequency;
+		ASSERT(TRUE == QueryPerformanceFrequency(&frequency), "Unable to query performance counter frequency");
+		return 1.0 / static_cast<double>(frequency.QuadPart);
+#else
+		return 1e-9;
+#endif
+	}
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+	// Reads the TSC between two reads of the OS clock, and takes the OS time to be halfway between them.
+	// The tightest of a few tries is kept, in case the thread was interrupted.
+	void SampleClocks(int64_t& OSTick, uint64_t& Tsc)
+	{
+		int64_t BestSpread = INT64_MAX;
+		for (int i = 0; i < 5; ++i)
+		{
+			const int64_t Before = HolographicEngine::SystemTime::GetOSTick();
+			const uint64_t Counter = __rdtsc();
+			const int64_t After = HolographicEngine::SystemTime::GetOSTick();
+
+			if (After - Before < BestSpread)
+			{
+				BestSpread = After - Before;
+				OSTick = Before + (After - Before) / 2;
+				Tsc = Counter;
+			}
+		}
+	}
+
+	// Returns the seconds per TSC tick, or 0 if the TSC does not look usable.
+	double CalibrateTsc(double OSTickDelta)
+	{
+		int64_t StartTick, EndTick;
+		uint64_t StartTsc, EndTsc;
+
+		SampleClocks(StartTick, StartTsc);
+		const int64_t EndAfter = StartTick + static_cast<int64_t>(kCalibrationSeconds / OSTickDelta);
+		while (HolographicEngine::SystemTime::GetOSTick() < EndAfter)
+			_mm_pause();
+		SampleClocks(EndTick, EndTsc);
+
+		if (EndTsc <= StartTsc)
+			return 0.0;
+
+		const double TscDelta = (EndTick - StartTick) * OSTickDelta / static_cast<double>(EndTsc - StartTsc);
+
+		// Anything outside 100 MHz to 10 GHz means the counter is not what it claims to be.
+		return TscDelta > 1e-10 && TscDelta < 1e-8 ? TscDelta : 0.0;
+	}
+
+#endif
+
+	__forceinline void SpinPause(void)
+	{
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+		_mm_pause();
+#elif defined(_M_ARM) || defined(_M_ARM64)
+		__yield();
+#endif
+	}
+
+	// What each thread has learned about how late the OS wakes it, and the timer it waits on.
+	struct SleepState
+	{
+		SleepState()
+		{
+#if defined(_WIN32)
+			// High resolution timers wake within a fraction of a millisecond instead of at the next
+			// scheduler tick, but only exist on Windows 10 1803 and later.
+			Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+			if (Timer == nullptr)
+				Timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+#endif
+		}
+
+		~SleepState()
+		{
+#if defined(_WIN32)
+			if (Timer != nullptr)
+				CloseHandle(Timer);
+#endif
+		}
+
+		// Blocks in the OS for about Seconds.
+		void Wait(double Seconds)
+		{
+#if defined(_WIN32)
+			LARGE_INTEGER DueTime;
+			DueTime.QuadPart = -static_cast<LONGLONG>(Seconds * 1e7);    // Relative, in 100 ns units
 
-// Query the performance counter frequency
-void HolographicEngine::SystemTime::Initialize(void)
+			if (Timer != nullptr && SetWaitableTimerEx(Timer, &DueTime, 0, nullptr, nullptr, nullptr, 0))
+				WaitForSingleObjectEx(Timer, INFINITE, FALSE);
+			else
+				Sleep(static_cast<DWORD>(Seconds * 1000.0));
+#else
+			timespec Duration;
+			Duration.tv_sec = static_cast<time_t>(Seconds);
+			Duration.tv_nsec = static_cast<long>((Seconds - Duration.tv_sec) * 1e9);
+			clock_nanosleep(CLOCK_MONOTONIC, 0, &Duration, nullptr);
+#endif
+		}
+
+		// Spin long enough to cover the usual lateness and a few deviations of it.
+		double GetSpinSeconds(void) const
+		{
+			return min(kMaxSpinSeconds, max(kMinSpinSeconds, LateMean + 4.0 * LateDeviation));
+		}
+
+		void AddLateness(double Seconds)
+		{
+			// Moving averages, so the estimate follows changes in system load and timer resolution.
+			LateMean += (Seconds - LateMean) * 0.1;
+			LateDeviation += (fabs(Seconds - LateMean) - LateDeviation) * 0.1;
+		}
+
+#if defined(_WIN32)
+		HANDLE Timer = nullptr;
+#endif
+		// Start out cautious until there is something to learn from.
+		double LateMean = 0.001;
+		double LateDeviation = 0.0005;
+	};
+
+	thread_local SleepState t_SleepState;
+}
+
+void HolographicEngine::SystemTime::Initialize(bool allowTsc)
 {
-	LARGE_INTEGER frequency;
-	ASSERT(TRUE == QueryPerformanceFrequency(&frequency), "Unable to query performance counter frequency");
-	sm_CpuTickDelta = 1.0 / static_cast<double>(frequency.QuadPart);
+	if (s_Initialized)
+		return;
+	s_Initialized = true;
+
+	sm_OSTickDelta = GetOSTickDelta();
+	sm_CpuTickDelta = sm_OSTickDelta;
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	// Without an invariant TSC the counter rate changes with the clock speed, or differs between cores.
+	if (allowTsc && CpuFeatures::Has(CpuFeatures::kFeatureInvariantTSC))
+	{
+		const double TscDelta = CalibrateTsc(sm_OSTickDelta);
+		if (TscDelta > 0.0)
+		{
+			sm_CpuTickDelta = TscDelta;
+			sm_UseTsc = true;
+		}
+	}
+#endif
+
+	Utility::Printf("Clock: %s at %.3f MHz\n", sm_UseTsc ? "TSC" : "OS clock", 1e-6 / sm_CpuTickDelta);
 }
 
-// Query the current value of the performance counter
-int64_t HolographicEngine::SystemTime::GetCurrentTick(void)
+// Query the current value of the OS clock
+int64_t HolographicEngine::SystemTime::GetOSTick(void)
 {
+#if defined(_WIN32)
 	LARGE_INTEGER currentTick;
 	ASSERT(TRUE == QueryPerformanceCounter(&currentTick), "Unable to query performance counter value");
 	return static_cast<int64_t>(currentTick.QuadPart);
+#else
+	timespec Now;
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return static_cast<int64_t>(Now.tv_sec) * 1000000000 + Now.tv_nsec;
+#endif
 }
 
 void HolographicEngine::SystemTime::BusyLoopSleep(float SleepTime)
 {
 	int64_t finalTick = (int64_t)((double)SleepTime / sm_CpuTickDelta) + GetCurrentTick();
 	while (GetCurrentTick() < finalTick);
-}
\ No newline at end of file
+}
+
+void HolographicEngine::SystemTime::HybridSleep(float SleepTime)
+{
+	SleepUntil(GetCurrentTick() + SecondsToTicks(SleepTime));
+}
+
+void HolographicEngine::SystemTime::SleepUntil(int64_t DeadlineTick)
+{
+	SleepState& State = t_SleepState;
+
+	for (;;)
+	{
+		const double Remaining = TimeBetweenTicks(GetCurrentTick(), DeadlineTick);
+		const double SleepSeconds = Remaining - State.GetSpinSeconds();
+		if (SleepSeconds <= 0.0)
+			break;
+
+		const int64_t Start = GetCurrentTick();
+		State.Wait(SleepSeconds);
+		State.AddLateness(TimeBetweenTicks(Start, GetCurrentTick()) - SleepSeconds);
+	}
+
+	while (GetCurrentTick() < DeadlineTick)
+		SpinPause();
+}
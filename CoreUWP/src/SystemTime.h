@@ -7,21 +7,51 @@
 
 #pragma once
 
+#if !defined(_MSC_VER) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#endif
+
 namespace HolographicEngine
 {
 
+	// Ticks come from the time stamp counter when the CPU has an invariant one, calibrated against the
+	// OS clock at startup, and from the OS clock otherwise: QueryPerformanceCounter on Windows and
+	// CLOCK_MONOTONIC elsewhere.  Reading the TSC is a single instruction, where the OS clock may not be,
+	// so GetCurrentTick is cheap enough for hot loops.  Either way ticks only mean something relative to
+	// each other, through TicksToSeconds.
+
 	class SystemTime
 	{
 	public:
 
-		// Query the performance counter frequency
-		static void Initialize(void);
+		// Picks and calibrates the clock.  Only the first call does anything, so that ticks taken
+		// earlier stay comparable.  Pass false to keep to the OS clock.
+		static void Initialize(bool allowTsc = true);
+
+		// Query the current value of the clock
+		static inline int64_t GetCurrentTick(void)
+		{
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+			if (sm_UseTsc)
+				return static_cast<int64_t>(__rdtsc());
+#endif
+			return GetOSTick();
+		}
+
+		// The OS clock, regardless of which clock GetCurrentTick uses.
+		static int64_t GetOSTick(void);
 
-		// Query the current value of the performance counter
-		static int64_t GetCurrentTick(void);
+		static bool IsUsingTsc(void) { return sm_UseTsc; }
 
+		// Spins until the time has passed, keeping a core busy the whole time.
 		static void BusyLoopSleep(float SleepTime);
 
+		// Sleeps in the OS for most of the time and spins only for the last part, so the wait is as
+		// precise as BusyLoopSleep without burning a core.  How long to spin is learned from how late
+		// the OS wakes the calling thread, and is usually a few hundred microseconds.
+		static void HybridSleep(float SleepTime);
+		static void SleepUntil(int64_t DeadlineTick);
+
 		static inline double TicksToSeconds(int64_t TickCount)
 		{
 			return TickCount * sm_CpuTickDelta;
@@ -32,6 +62,11 @@ namespace HolographicEngine
 			return TickCount * sm_CpuTickDelta * 1000.0;
 		}
 
+		static inline int64_t SecondsToTicks(double Seconds)
+		{
+			return static_cast<int64_t>(Seconds / sm_CpuTickDelta);
+		}
+
 		static inline double TimeBetweenTicks(int64_t tick1, int64_t tick2)
 		{
 			return TicksToSeconds(tick2 - tick1);
@@ -39,8 +74,10 @@ namespace HolographicEngine
 
 	private:
 
-		// The amount of time that elapses between ticks of the performance counter
+		// The amount of time that elapses between ticks of the clock
 		static double sm_CpuTickDelta;
+		static double sm_OSTickDelta;
+		static bool sm_UseTsc;
 	};
 
 	class CpuTimer
@@ -13,129 +13,394 @@
 
 #include "pch.h"
 #include "Utility.h"
+#include "CpuFeatures.h"
 #include <string>
-#include <xmmintrin.h>
 
-namespace HolographicEngine
+namespace
 {
-	// A faster version of memcopy that uses SSE instructions.  TODO:  Write an ARM variant if necessary.
-	void SIMDMemCopy(void* __restrict _Dest, const void* __restrict _Source, size_t NumQuadwords)
+	typedef void (*MemCopyKernel)(void* __restrict Dest, const void* __restrict Source, size_t NumBytes);
+	typedef void (*MemFillKernel)(void* __restrict Dest, const unsigned char* Pattern, size_t NumBytes);
+
+	// Copies larger than this bypass the cache with non-temporal stores.  Below it the destination is
+	// likely to be read again soon, so it is better left in the cache.  The default is above the size of
+	// a typical last-level cache.
+	size_t s_StreamingThreshold = 8 * 1024 * 1024;
+
+	// Copies of fewer than 64 bytes.  Two overlapping moves of the largest size that fits avoid a loop.
+	__forceinline void CopySmall(unsigned char* __restrict Dest, const unsigned char* __restrict Source, size_t NumBytes)
 	{
-		ASSERT(Math::IsAligned(_Dest, 16));
-		ASSERT(Math::IsAligned(_Source, 16));
+		if (NumBytes >= 32)
+		{
+			memcpy(Dest, Source, 32);
+			memcpy(Dest + NumBytes - 32, Source + NumBytes - 32, 32);
+		}
+		else if (NumBytes >= 16)
+		{
+			memcpy(Dest, Source, 16);
+			memcpy(Dest + NumBytes - 16, Source + NumBytes - 16, 16);
+		}
+		else if (NumBytes >= 8)
+		{
+			memcpy(Dest, Source, 8);
+			memcpy(Dest + NumBytes - 8, Source + NumBytes - 8, 8);
+		}
+		else if (NumBytes >= 4)
+		{
+			memcpy(Dest, Source, 4);
+			memcpy(Dest + NumBytes - 4, Source + NumBytes - 4, 4);
+		}
+		else
+		{
+			for (size_t i = 0; i < NumBytes; ++i)
+				Dest[i] = Source[i];
+		}
+	}
 
-		__m128i* __restrict Dest = (__m128i * __restrict)_Dest;
-		const __m128i* __restrict Source = (const __m128i * __restrict)_Source;
+	void CopyScalar(void* __restrict Dest, const void* __restrict Source, size_t NumBytes)
+	{
+		memcpy(Dest, Source, NumBytes);
+	}
 
-		// Discover how many quadwords precede a cache line boundary.  Copy them separately.
-		size_t InitialQuadwordCount = (4 - ((size_t)Source >> 4) & 3) & 3;
-		if (InitialQuadwordCount > NumQuadwords)
-			InitialQuadwordCount = NumQuadwords;
+	void FillScalar(void* __restrict _Dest, const unsigned char* Pattern, size_t NumBytes)
+	{
+		unsigned char* Dest = (unsigned char*)_Dest;
+
+		for (; NumBytes >= 16; NumBytes -= 16, Dest += 16)
+			memcpy(Dest, Pattern, 16);
+
+		for (size_t i = 0; i < NumBytes; ++i)
+			Dest[i] = Pattern[i];
+	}
 
-		switch (InitialQuadwordCount)
+#if defined(_M_IX86) || defined(_M_X64)
+
+	// The pattern repeated three times, so that an unaligned load at offset k (0-15) yields the pattern
+	// rotated by k bytes for either a 16 or a 32 byte register.
+	struct RotatedPattern
+	{
+		RotatedPattern(const unsigned char* Pattern)
 		{
-		case 3: _mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));     // Fall through
-		case 2: _mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));     // Fall through
-		case 1: _mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));     // Fall through
-		default:
-			break;
+			memcpy(Bytes + 0, Pattern, 16);
+			memcpy(Bytes + 16, Pattern, 16);
+			memcpy(Bytes + 32, Pattern, 16);
 		}
 
-		if (NumQuadwords == InitialQuadwordCount)
+		const unsigned char* AtPhase(size_t Offset) const { return Bytes + (Offset & 15); }
+
+		alignas(16) unsigned char Bytes[48];
+	};
+
+	void CopySSE2(void* __restrict _Dest, const void* __restrict _Source, size_t NumBytes)
+	{
+		unsigned char* __restrict Dest = (unsigned char*)_Dest;
+		const unsigned char* __restrict Source = (const unsigned char*)_Source;
+
+		if (NumBytes < 64)
+		{
+			CopySmall(Dest, Source, NumBytes);
 			return;
+		}
 
-		Dest += InitialQuadwordCount;
-		Source += InitialQuadwordCount;
-		NumQuadwords -= InitialQuadwordCount;
+		if (NumBytes <= 128)
+		{
+			// Four vectors from each end cover everything, overlapping in the middle.
+			const __m128i* SourceEnd = (const __m128i*)(Source + NumBytes) - 4;
+			__m128i* DestEnd = (__m128i*)(Dest + NumBytes) - 4;
 
-		size_t CacheLines = NumQuadwords >> 2;
+			__m128i H0 = _mm_loadu_si128((const __m128i*)Source + 0);
+			__m128i H1 = _mm_loadu_si128((const __m128i*)Source + 1);
+			__m128i H2 = _mm_loadu_si128((const __m128i*)Source + 2);
+			__m128i H3 = _mm_loadu_si128((const __m128i*)Source + 3);
+			__m128i T0 = _mm_loadu_si128(SourceEnd + 0);
+			__m128i T1 = _mm_loadu_si128(SourceEnd + 1);
+			__m128i T2 = _mm_loadu_si128(SourceEnd + 2);
+			__m128i T3 = _mm_loadu_si128(SourceEnd + 3);
 
-		switch (CacheLines)
+			_mm_storeu_si128((__m128i*)Dest + 0, H0);
+			_mm_storeu_si128((__m128i*)Dest + 1, H1);
+			_mm_storeu_si128((__m128i*)Dest + 2, H2);
+			_mm_storeu_si128((__m128i*)Dest + 3, H3);
+			_mm_storeu_si128(DestEnd + 0, T0);
+			_mm_storeu_si128(DestEnd + 1, T1);
+			_mm_storeu_si128(DestEnd + 2, T2);
+			_mm_storeu_si128(DestEnd + 3, T3);
+			return;
+		}
+
+		// The first and last 16 bytes are written unaligned.  Everything in between is written to
+		// 16-byte aligned destinations, overlapping the head and tail where necessary.
+		const __m128i Tail = _mm_loadu_si128((const __m128i*)(Source + NumBytes - 16));
+		unsigned char* const TailDest = Dest + NumBytes - 16;
+
+		_mm_storeu_si128((__m128i*)Dest, _mm_loadu_si128((const __m128i*)Source));
+
+		const size_t Skew = 16 - ((size_t)Dest & 15);
+		Dest += Skew;
+		Source += Skew;
+		NumBytes -= Skew;
+
+		size_t CacheLines = NumBytes >> 6;
+
+		if (NumBytes >= s_StreamingThreshold)
 		{
-		default:
-		case 10: _mm_prefetch((char*)(Source + 36), _MM_HINT_NTA);    // Fall through
-		case 9:  _mm_prefetch((char*)(Source + 32), _MM_HINT_NTA);    // Fall through
-		case 8:  _mm_prefetch((char*)(Source + 28), _MM_HINT_NTA);    // Fall through
-		case 7:  _mm_prefetch((char*)(Source + 24), _MM_HINT_NTA);    // Fall through
-		case 6:  _mm_prefetch((char*)(Source + 20), _MM_HINT_NTA);    // Fall through
-		case 5:  _mm_prefetch((char*)(Source + 16), _MM_HINT_NTA);    // Fall through
-		case 4:  _mm_prefetch((char*)(Source + 12), _MM_HINT_NTA);    // Fall through
-		case 3:  _mm_prefetch((char*)(Source + 8), _MM_HINT_NTA);    // Fall through
-		case 2:  _mm_prefetch((char*)(Source + 4), _MM_HINT_NTA);    // Fall through
-		case 1:  _mm_prefetch((char*)(Source + 0), _MM_HINT_NTA);    // Fall through
+			for (; CacheLines > 0; --CacheLines)
+			{
+				_mm_prefetch((const char*)(Source + 640), _MM_HINT_NTA);
 
-			// Do four quadwords per loop to minimize stalls.
-			for (size_t i = CacheLines; i > 0; --i)
+				_mm_stream_si128((__m128i*)Dest + 0, _mm_loadu_si128((const __m128i*)Source + 0));
+				_mm_stream_si128((__m128i*)Dest + 1, _mm_loadu_si128((const __m128i*)Source + 1));
+				_mm_stream_si128((__m128i*)Dest + 2, _mm_loadu_si128((const __m128i*)Source + 2));
+				_mm_stream_si128((__m128i*)Dest + 3, _mm_loadu_si128((const __m128i*)Source + 3));
+
+				Dest += 64;
+				Source += 64;
+			}
+
+			// Non-temporal stores must be globally visible before the ordinary tail stores below.
+			_mm_sfence();
+		}
+		else
+		{
+			for (; CacheLines > 0; --CacheLines)
 			{
-				// If this is a large copy, start prefetching future cache lines.  This also prefetches the
-				// trailing quadwords that are not part of a whole cache line.
-				if (i >= 10)
-					_mm_prefetch((char*)(Source + 40), _MM_HINT_NTA);
-
-				_mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));
-				_mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));
-				_mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));
-				_mm_stream_si128(Dest + 3, _mm_load_si128(Source + 3));
-
-				Dest += 4;
-				Source += 4;
+				_mm_store_si128((__m128i*)Dest + 0, _mm_loadu_si128((const __m128i*)Source + 0));
+				_mm_store_si128((__m128i*)Dest + 1, _mm_loadu_si128((const __m128i*)Source + 1));
+				_mm_store_si128((__m128i*)Dest + 2, _mm_loadu_si128((const __m128i*)Source + 2));
+				_mm_store_si128((__m128i*)Dest + 3, _mm_loadu_si128((const __m128i*)Source + 3));
+
+				Dest += 64;
+				Source += 64;
 			}
+		}
 
-		case 0:    // No whole cache lines to read
-			break;
+		// Copy the remaining whole quadwords, then finish with the overlapping tail.
+		for (size_t Remaining = NumBytes & 63; Remaining >= 16; Remaining -= 16)
+		{
+			_mm_store_si128((__m128i*)Dest, _mm_loadu_si128((const __m128i*)Source));
+			Dest += 16;
+			Source += 16;
 		}
 
-		// Copy the remaining quadwords
-		switch (NumQuadwords & 3)
+		_mm_storeu_si128((__m128i*)TailDest, Tail);
+	}
+
+	void CopyAVX2(void* __restrict _Dest, const void* __restrict _Source, size_t NumBytes)
+	{
+		if (NumBytes <= 128)
 		{
-		case 3: _mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));     // Fall through
-		case 2: _mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));     // Fall through
-		case 1: _mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));     // Fall through
-		default:
-			break;
+			CopySSE2(_Dest, _Source, NumBytes);
+			return;
 		}
 
-		_mm_sfence();
+		unsigned char* __restrict Dest = (unsigned char*)_Dest;
+		const unsigned char* __restrict Source = (const unsigned char*)_Source;
+
+		const __m256i Tail = _mm256_loadu_si256((const __m256i*)(Source + NumBytes - 32));
+		unsigned char* const TailDest = Dest + NumBytes - 32;
+
+		_mm256_storeu_si256((__m256i*)Dest, _mm256_loadu_si256((const __m256i*)Source));
+
+		const size_t Skew = 32 - ((size_t)Dest & 31);
+		Dest += Skew;
+		Source += Skew;
+		NumBytes -= Skew;
+
+		// Two cache lines per iteration.
+		size_t Blocks = NumBytes >> 7;
+
+		if (NumBytes >= s_StreamingThreshold)
+		{
+			for (; Blocks > 0; --Blocks)
+			{
+				_mm_prefetch((const char*)(Source + 1024), _MM_HINT_NTA);
+				_mm_prefetch((const char*)(Source + 1088), _MM_HINT_NTA);
+
+				_mm256_stream_si256((__m256i*)Dest + 0, _mm256_loadu_si256((const __m256i*)Source + 0));
+				_mm256_stream_si256((__m256i*)Dest + 1, _mm256_loadu_si256((const __m256i*)Source + 1));
+				_mm256_stream_si256((__m256i*)Dest + 2, _mm256_loadu_si256((const __m256i*)Source + 2));
+				_mm256_stream_si256((__m256i*)Dest + 3, _mm256_loadu_si256((const __m256i*)Source + 3));
+
+				Dest += 128;
+				Source += 128;
+			}
+
+			_mm_sfence();
+		}
+		else
+		{
+			for (; Blocks > 0; --Blocks)
+			{
+				_mm256_store_si256((__m256i*)Dest + 0, _mm256_loadu_si256((const __m256i*)Source + 0));
+				_mm256_store_si256((__m256i*)Dest + 1, _mm256_loadu_si256((const __m256i*)Source + 1));
+				_mm256_store_si256((__m256i*)Dest + 2, _mm256_loadu_si256((const __m256i*)Source + 2));
+				_mm256_store_si256((__m256i*)Dest + 3, _mm256_loadu_si256((const __m256i*)Source + 3));
+
+				Dest += 128;
+				Source += 128;
+			}
+		}
+
+		for (size_t Remaining = NumBytes & 127; Remaining >= 32; Remaining -= 32)
+		{
+			_mm256_store_si256((__m256i*)Dest, _mm256_loadu_si256((const __m256i*)Source));
+			Dest += 32;
+			Source += 32;
+		}
+
+		_mm256_storeu_si256((__m256i*)TailDest, Tail);
+		_mm256_zeroupper();
 	}
 
-	void SIMDMemFill(void* __restrict _Dest, __m128 FillVector, size_t NumQuadwords)
+	void FillSSE2(void* __restrict _Dest, const unsigned char* Pattern, size_t NumBytes)
 	{
-		ASSERT(Math::IsAligned(_Dest, 16));
+		if (NumBytes < 32)
+		{
+			FillScalar(_Dest, Pattern, NumBytes);
+			return;
+		}
+
+		unsigned char* __restrict Dest = (unsigned char*)_Dest;
+		const RotatedPattern Rotated(Pattern);
+
+		// Writing at an offset from the start shifts the phase of the pattern by the same amount.
+		const size_t TailOffset = NumBytes - 16;
+		const __m128i Tail = _mm_loadu_si128((const __m128i*)Rotated.AtPhase(TailOffset));
+		unsigned char* const TailDest = Dest + TailOffset;
+
+		_mm_storeu_si128((__m128i*)Dest, _mm_loadu_si128((const __m128i*)Pattern));
 
-		register const __m128i Source = _mm_castps_si128(FillVector);
-		__m128i* __restrict Dest = (__m128i * __restrict)_Dest;
+		const size_t Skew = 16 - ((size_t)Dest & 15);
+		Dest += Skew;
+		NumBytes -= Skew;
 
-		switch (((size_t)Dest >> 4) & 3)
+		const __m128i Source = _mm_loadu_si128((const __m128i*)Rotated.AtPhase(Skew));
+		size_t CacheLines = NumBytes >> 6;
+
+		if (NumBytes >= s_StreamingThreshold)
+		{
+			for (; CacheLines > 0; --CacheLines, Dest += 64)
+			{
+				_mm_stream_si128((__m128i*)Dest + 0, Source);
+				_mm_stream_si128((__m128i*)Dest + 1, Source);
+				_mm_stream_si128((__m128i*)Dest + 2, Source);
+				_mm_stream_si128((__m128i*)Dest + 3, Source);
+			}
+
+			_mm_sfence();
+		}
+		else
 		{
-		case 1: _mm_stream_si128(Dest++, Source); --NumQuadwords;     // Fall through
-		case 2: _mm_stream_si128(Dest++, Source); --NumQuadwords;     // Fall through
-		case 3: _mm_stream_si128(Dest++, Source); --NumQuadwords;     // Fall through
-		default:
-			break;
+			for (; CacheLines > 0; --CacheLines, Dest += 64)
+			{
+				_mm_store_si128((__m128i*)Dest + 0, Source);
+				_mm_store_si128((__m128i*)Dest + 1, Source);
+				_mm_store_si128((__m128i*)Dest + 2, Source);
+				_mm_store_si128((__m128i*)Dest + 3, Source);
+			}
 		}
 
-		size_t WholeCacheLines = NumQuadwords >> 2;
+		for (size_t Remaining = NumBytes & 63; Remaining >= 16; Remaining -= 16, Dest += 16)
+			_mm_store_si128((__m128i*)Dest, Source);
 
-		// Do four quadwords per loop to minimize stalls.
-		while (WholeCacheLines--)
+		_mm_storeu_si128((__m128i*)TailDest, Tail);
+	}
+
+	void FillAVX2(void* __restrict _Dest, const unsigned char* Pattern, size_t NumBytes)
+	{
+		if (NumBytes < 128)
 		{
-			_mm_stream_si128(Dest++, Source);
-			_mm_stream_si128(Dest++, Source);
-			_mm_stream_si128(Dest++, Source);
-			_mm_stream_si128(Dest++, Source);
+			FillSSE2(_Dest, Pattern, NumBytes);
+			return;
 		}
 
-		// Copy the remaining quadwords
-		switch (NumQuadwords & 3)
+		unsigned char* __restrict Dest = (unsigned char*)_Dest;
+		const RotatedPattern Rotated(Pattern);
+
+		const size_t TailOffset = NumBytes - 32;
+		const __m256i Tail = _mm256_loadu_si256((const __m256i*)Rotated.AtPhase(TailOffset));
+		unsigned char* const TailDest = Dest + TailOffset;
+
+		_mm256_storeu_si256((__m256i*)Dest, _mm256_loadu_si256((const __m256i*)Rotated.AtPhase(0)));
+
+		const size_t Skew = 32 - ((size_t)Dest & 31);
+		Dest += Skew;
+		NumBytes -= Skew;
+
+		const __m256i Source = _mm256_loadu_si256((const __m256i*)Rotated.AtPhase(Skew));
+		size_t Blocks = NumBytes >> 7;
+
+		if (NumBytes >= s_StreamingThreshold)
 		{
-		case 3: _mm_stream_si128(Dest++, Source);     // Fall through
-		case 2: _mm_stream_si128(Dest++, Source);     // Fall through
-		case 1: _mm_stream_si128(Dest++, Source);     // Fall through
-		default:
-			break;
+			for (; Blocks > 0; --Blocks, Dest += 128)
+			{
+				_mm256_stream_si256((__m256i*)Dest + 0, Source);
+				_mm256_stream_si256((__m256i*)Dest + 1, Source);
+				_mm256_stream_si256((__m256i*)Dest + 2, Source);
+				_mm256_stream_si256((__m256i*)Dest + 3, Source);
+			}
+
+			_mm_sfence();
 		}
+		else
+		{
+			for (; Blocks > 0; --Blocks, Dest += 128)
+			{
+				_mm256_store_si256((__m256i*)Dest + 0, Source);
+				_mm256_store_si256((__m256i*)Dest + 1, Source);
+				_mm256_store_si256((__m256i*)Dest + 2, Source);
+				_mm256_store_si256((__m256i*)Dest + 3, Source);
+			}
+		}
+
+		for (size_t Remaining = NumBytes & 127; Remaining >= 32; Remaining -= 32, Dest += 32)
+			_mm256_store_si256((__m256i*)Dest, Source);
+
+		_mm256_storeu_si256((__m256i*)TailDest, Tail);
+		_mm256_zeroupper();
+	}
+
+#endif
+
+	using HolographicEngine::CpuFeatures::DispatchTable;
+
+#if defined(_M_IX86) || defined(_M_X64)
+	DispatchTable<MemCopyKernel> s_CopyKernels(CopyScalar, CopySSE2, nullptr, CopyAVX2);
+	DispatchTable<MemFillKernel> s_FillKernels(FillScalar, FillSSE2, nullptr, FillAVX2);
+#else
+	DispatchTable<MemCopyKernel> s_CopyKernels(CopyScalar);
+	DispatchTable<MemFillKernel> s_FillKernels(FillScalar);
+#endif
+}
 
-		_mm_sfence();
+namespace HolographicEngine
+{
+	void SIMDMemCopy(void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords)
+	{
+		s_CopyKernels.Get()(Dest, Source, NumQuadwords * 16);
+	}
+
+	void SIMDMemCopyBytes(void* __restrict Dest, const void* __restrict Source, size_t NumBytes)
+	{
+		s_CopyKernels.Get()(Dest, Source, NumBytes);
+	}
+
+	void SIMDMemFill(void* __restrict Dest, DirectX::XMVECTOR FillVector, size_t NumQuadwords)
+	{
+		alignas(16) unsigned char Pattern[16];
+		memcpy(Pattern, &FillVector, 16);
+		s_FillKernels.Get()(Dest, Pattern, NumQuadwords * 16);
+	}
+
+	void SIMDMemFillBytes(void* __restrict Dest, unsigned char Value, size_t NumBytes)
+	{
+		alignas(16) unsigned char Pattern[16];
+		memset(Pattern, Value, 16);
+		s_FillKernels.Get()(Dest, Pattern, NumBytes);
+	}
+
+	void SIMDMemSetStreamingThreshold(size_t NumBytes)
+	{
+		s_StreamingThreshold = NumBytes;
 	}
 
 	std::wstring MakeWStr(const std::string& str)
@@ -7,48 +7,56 @@
 
 #pragma once
 
+#include "EngineLog.h"
+
 namespace HolographicEngine::Utility
 {
-	inline void Print(const char* msg) { printf("%s", msg); }
-	inline void Print(const wchar_t* msg) { wprintf(L"%ws", msg); }
+	// Output goes through EngineLog, which formats and writes it on a background thread.
+	inline void Print(const char* msg) { EngineLog::WriteString(msg); }
+	inline void Print(const wchar_t* msg) { EngineLog::WriteString(msg); }
 
-	inline void Printf(const char* format, ...)
+	// The format string must outlive the call; a string literal always does.
+	template <typename... Args>
+	inline void Printf(const char* format, const Args&... args)
 	{
-		char buffer[256];
-		va_list ap;
-		va_start(ap, format);
-		vsprintf_s(buffer, 256, format, ap);
-		Print(buffer);
+		EngineLog::Write(format, args...);
+	}
+
+	// Wide strings are formatted on the calling thread, then written like Print.
+	inline std::wstring VFormat(const wchar_t* format, va_list ap)
+	{
+		va_list sizing;
+		va_copy(sizing, ap);
+		std::wstring buffer(_vscwprintf(format, sizing), L'\0');
+		va_end(sizing);
+
+		vswprintf(&buffer[0], buffer.size() + 1, format, ap);
+		return buffer;
 	}
 
 	inline void Printf(const wchar_t* format, ...)
 	{
-		wchar_t buffer[256];
 		va_list ap;
 		va_start(ap, format);
-		vswprintf(buffer, 256, format, ap);
-		Print(buffer);
+		Print(VFormat(format, ap).c_str());
+		va_end(ap);
 	}
 
 #ifndef RELEASE
-	inline void PrintSubMessage(const char* format, ...)
+	template <typename... Args>
+	inline void PrintSubMessage(const char* format, const Args&... args)
 	{
 		Print("--> ");
-		char buffer[256];
-		va_list ap;
-		va_start(ap, format);
-		vsprintf_s(buffer, 256, format, ap);
-		Print(buffer);
+		Printf(format, args...);
 		Print("\n");
 	}
 	inline void PrintSubMessage(const wchar_t* format, ...)
 	{
 		Print("--> ");
-		wchar_t buffer[256];
 		va_list ap;
 		va_start(ap, format);
-		vswprintf(buffer, 256, format, ap);
-		Print(buffer);
+		Print(VFormat(format, ap).c_str());
+		va_end(ap);
 		Print("\n");
 	}
 	inline void PrintSubMessage(void)
@@ -67,7 +75,7 @@ namespace HolographicEngine::Utility
 #undef HALT
 #endif
 
-#define HALT( ... ) ERROR( __VA_ARGS__ ) __debugbreak();
+#define HALT( ... ) ERROR( __VA_ARGS__ ) HolographicEngine::EngineLog::Flush(); __debugbreak();
 
 #ifdef RELEASE
 
@@ -88,6 +96,7 @@ namespace HolographicEngine::Utility
             HolographicEngine::Utility::PrintSubMessage("\'" #isFalse "\' is false"); \
             HolographicEngine::Utility::PrintSubMessage(__VA_ARGS__); \
             HolographicEngine::Utility::Print("\n"); \
+            HolographicEngine::EngineLog::Flush(); \
             __debugbreak(); \
         }
 
@@ -97,6 +106,7 @@ namespace HolographicEngine::Utility
             HolographicEngine::Utility::PrintSubMessage("hr = 0x%08X", hr); \
             HolographicEngine::Utility::PrintSubMessage(__VA_ARGS__); \
             HolographicEngine::Utility::Print("\n"); \
+            HolographicEngine::EngineLog::Flush(); \
             __debugbreak(); \
         }
 
@@ -128,7 +138,16 @@ namespace HolographicEngine::Utility
 
 namespace HolographicEngine
 {
+	// SIMD versions of memcpy and memset, dispatched to the active CpuFeatures tier.  Neither pointer
+	// needs to be aligned, and copies at or above the streaming threshold use non-temporal stores so
+	// that they do not evict the working set.  The buffers must not overlap.
 	void SIMDMemCopy(void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords);
-	void SIMDMemFill(void* __restrict Dest, __m128 FillVector, size_t NumQuadwords);
+	void SIMDMemCopyBytes(void* __restrict Dest, const void* __restrict Source, size_t NumBytes);
+	void SIMDMemFill(void* __restrict Dest, DirectX::XMVECTOR FillVector, size_t NumQuadwords);
+	void SIMDMemFillBytes(void* __restrict Dest, unsigned char Value, size_t NumBytes);
+
+	// Defaults to 8 MB.
+	void SIMDMemSetStreamingThreshold(size_t NumBytes);
+
 	std::wstring MakeWStr(const std::string& str);
 }
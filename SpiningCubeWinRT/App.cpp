@@ -2,6 +2,8 @@
 #include "GameCore.h"
 #include "VectorMath.h"
 #include "FileUtility.h"
+#include "FrameCounters.h"
+#include "Graphics/ShaderCache.h"
 #include "Graphics/GraphicsCore.h"
 #include "SystemTime.h"
 
@@ -44,20 +46,18 @@ public:
 
 private:
 	bool m_loadingComplete = false;
-	bool m_usingVprtShaders = false;
 	int m_indexCount = 0;
 	float m_degreesPerSecond = 1;
 
 	// Direct3D resources for cube geometry.
 	// TODO(Sergio): Abstract all those thing away using the Engine API.
-	ComPtr<ID3D11InputLayout>       m_inputLayout{ nullptr };
 	ComPtr<ID3D11Buffer>            m_vertexBuffer{ nullptr };
 	ComPtr<ID3D11Buffer>            m_indexBuffer{ nullptr };
-	ComPtr<ID3D11VertexShader>      m_vertexShader{ nullptr };
-	ComPtr<ID3D11GeometryShader>    m_geometryShader{ nullptr };
-	ComPtr<ID3D11PixelShader>       m_pixelShader{ nullptr };
 	ComPtr<ID3D11Buffer>            m_modelConstantBuffer{ nullptr };
 
+	// Shared with any other user of the same bytecode through the shader cache.
+	Graphics::ShaderProgram         m_shaders;
+
 	// System resources for cube geometry.
 	ModelConstantBuffer                             m_modelConstantBufferData;
 };
@@ -66,54 +66,31 @@ CREATE_APPLICATION(SpiningCubeApp)
 
 void SpiningCubeApp::Startup()
 {
-	m_usingVprtShaders = Graphics::g_supportsVprt;
-
-	// On devices that do support the D3D11_FEATURE_D3D11_OPTIONS3::
-	// VPAndRTArrayIndexFromAnyShaderFeedingRasterizer optional feature
-	// we can avoid using a pass-through geometry shader to set the render
-	// target array index, thus avoiding any overhead that would be
-	// incurred by setting the geometry shader stage.
-	std::wstring vertexShaderFileName = m_usingVprtShaders ? L"ms-appx:///VprtVertexShader.cso" : L"ms-appx:///VertexShader.cso";
-
-	// Load shaders asynchronously.
-	Utility::ByteArray vertexShaderBytes = HolographicEngine::Utility::ReadFileUWPSync(vertexShaderFileName);
-
-	Utility::ByteArray pixelShaderBytes = HolographicEngine::Utility::ReadFileUWPSync(L"ms-appx:///PixelShader.cso");
-
-	Utility::ByteArray geometryShaderBytes;
-
-	if (!m_usingVprtShaders)
-	{
-		// Load the pass-through geometry shader.
-		geometryShaderBytes = HolographicEngine::Utility::ReadFileUWPSync(L"ms-appx:///GeometryShader.cso");
-	}
-
-	winrt::check_hresult(Graphics::g_Device->CreateVertexShader(vertexShaderBytes->data(), vertexShaderBytes->size(), nullptr, &m_vertexShader));
-
 	constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 2> vertexDesc =
 	{ {
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "COLOR",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	} };
 
-	winrt::check_hresult(Graphics::g_Device->CreateInputLayout(vertexDesc.data(), static_cast<UINT>(vertexDesc.size()), vertexShaderBytes->data(),
-		static_cast<UINT>(vertexShaderBytes->size()),
-		&m_inputLayout
-	)
-	);
-
-	winrt::check_hresult(Graphics::g_Device->CreatePixelShader(pixelShaderBytes->data(), pixelShaderBytes->size(), nullptr, &m_pixelShader));
+	// On devices that do support the D3D11_FEATURE_D3D11_OPTIONS3::
+	// VPAndRTArrayIndexFromAnyShaderFeedingRasterizer optional feature
+	// the shader cache picks the VPRT vertex shader, which avoids the
+	// overhead of a pass-through geometry shader setting the render
+	// target array index.
+	Graphics::ShaderProgramDesc shaderDesc;
+	shaderDesc.VprtVertexShader = L"ms-appx:///VprtVertexShader.cso";
+	shaderDesc.VertexShader = L"ms-appx:///VertexShader.cso";
+	shaderDesc.GeometryShader = L"ms-appx:///GeometryShader.cso";
+	shaderDesc.PixelShader = L"ms-appx:///PixelShader.cso";
+	shaderDesc.InputElements = vertexDesc.data();
+	shaderDesc.NumInputElements = static_cast<uint32_t>(vertexDesc.size());
+
+	m_shaders = Graphics::g_ShaderCache.LoadProgram(shaderDesc);
 
 	const CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ModelConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
 
 	winrt::check_hresult(Graphics::g_Device->CreateBuffer(&constantBufferDesc, nullptr, &m_modelConstantBuffer));
 
-	if (!m_usingVprtShaders)
-	{
-		winrt::check_hresult(Graphics::g_Device->CreateGeometryShader(geometryShaderBytes->data(), geometryShaderBytes->size(), nullptr, &m_geometryShader));
-		return;
-	}
-
 	// Load mesh vertices. Each vertex has a position and a color.
 	// Note that the cube size has changed from the default DirectX app
 	// template. Windows Holographic is scaled in meters, so to draw the
@@ -236,6 +213,7 @@ void SpiningCubeApp::Update(float deltaT)
 
 	// Update the model transform buffer for the hologram.
 	context->UpdateSubresource(m_modelConstantBuffer.Get(), 0, nullptr, &m_modelConstantBufferData, 0, 0);
+	FrameCounters::Add(FrameCounters::kConstantBufferBytes, sizeof(m_modelConstantBufferData));
 }
 
 void SpiningCubeApp::RenderScene()
@@ -256,26 +234,20 @@ void SpiningCubeApp::RenderScene()
 	context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
 	context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	context->IASetInputLayout(m_inputLayout.Get());
+	FrameCounters::Add(FrameCounters::kStateChanges, 3);
 
-	// Attach the vertex shader.
-	context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+	// Attach the shaders and the input layout.  Devices without VPRT support
+	// also get the pass-through geometry shader that sets the render target
+	// array index.
+	m_shaders.Bind(context);
 
 	// Apply the model constant buffer to the vertex shader.
 	context->VSSetConstantBuffers(0, 1, m_modelConstantBuffer.GetAddressOf());
+	FrameCounters::Add(FrameCounters::kStateChanges);
 
-	if (!m_usingVprtShaders)
-	{
-		// On devices that do not support the D3D11_FEATURE_D3D11_OPTIONS3::
-		// VPAndRTArrayIndexFromAnyShaderFeedingRasterizer optional feature,
-		// a pass-through geometry shader is used to set the render target
-		// array index.
-		context->GSSetShader(m_geometryShader.Get(), nullptr, 0);
-	}
-
-	// Attach the pixel shader.
-	context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
-
-	// Draw the objects.
+	// Draw the objects.  The one cube is never culled; both eyes are drawn at once, as two instances.
 	context->DrawIndexedInstanced(m_indexCount, 2, 0, 0, 0);
+	FrameCounters::CountCulling(1, 1);
+	FrameCounters::Add(FrameCounters::kObjectsDrawn);
+	FrameCounters::CountDraw(m_indexCount, 2);
 }
\ No newline at end of file
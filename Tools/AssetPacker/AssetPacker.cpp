@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+// Packs files into an archive the engine opens with Utility::Archive; see Archive.h.
+//
+//   AssetPacker [-c codec] -o archive file...
+//
+// Each file is added under its name without the directory, which is the name the app loads it by from
+// its package: VertexShader.cso is found as ms-appx:///VertexShader.cso.  With -c, entries are compressed
+// with the named codec where that makes them smaller.  The archive is opened and read back before the
+// packer exits, so a build step that runs it fails instead of shipping a bad archive.
+//
+// SpiningCubeWinRT runs it after compiling its shaders to build the Shaders.pak that ShaderCache loads.
+
+#include "pch.h"
+#include "Archive.h"
+#include "Compression.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace HolographicEngine;
+
+namespace
+{
+	struct Options
+	{
+		std::wstring OutputPath;
+		std::string CodecName;
+		std::vector<std::wstring> Files;
+	};
+
+	bool ParseOptions(int argc, wchar_t** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::wstring Arg = argv[i];
+			if (Arg == L"-o" && i + 1 < argc)
+			{
+				options.OutputPath = argv[++i];
+			}
+			else if (Arg == L"-c" && i + 1 < argc)
+			{
+				const std::wstring Codec = argv[++i];
+				options.CodecName.assign(Codec.begin(), Codec.end());
+			}
+			else if (Arg[0] != L'-')
+			{
+				options.Files.push_back(Arg);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return !options.OutputPath.empty() && !options.Files.empty();
+	}
+
+	std::wstring GetEntryName(const std::wstring& path)
+	{
+		const size_t Slash = path.find_last_of(L"\\/");
+		return Slash == std::wstring::npos ? path : path.substr(Slash + 1);
+	}
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+	Options Parsed;
+	if (!ParseOptions(argc, argv, Parsed))
+	{
+		printf("Usage: AssetPacker [-c codec] -o archive file...\n");
+		return 1;
+	}
+
+	const Compression::Codec* Codec = nullptr;
+	if (!Parsed.CodecName.empty())
+	{
+		Codec = Compression::FindCodecByName(Parsed.CodecName.c_str());
+		if (Codec == nullptr)
+		{
+			printf("AssetPacker: unknown codec %s\n", Parsed.CodecName.c_str());
+			return 1;
+		}
+	}
+
+	Utility::ArchiveWriter Writer;
+	for (const std::wstring& File : Parsed.Files)
+	{
+		if (!Writer.AddFile(GetEntryName(File), File, Codec))
+		{
+			printf("AssetPacker: cannot add %ls; it is missing or its name is already taken\n", File.c_str());
+			return 1;
+		}
+	}
+
+	if (!Writer.Write(Parsed.OutputPath))
+	{
+		printf("AssetPacker: cannot write %ls\n", Parsed.OutputPath.c_str());
+		return 1;
+	}
+
+	std::shared_ptr<Utility::Archive> Packed = Utility::Archive::Open(Parsed.OutputPath);
+	if (Packed == nullptr || Packed->GetNumEntries() != Writer.GetNumEntries())
+	{
+		printf("AssetPacker: %ls did not read back\n", Parsed.OutputPath.c_str());
+		return 1;
+	}
+
+	for (const std::wstring& File : Parsed.Files)
+	{
+		if (Packed->Read(GetEntryName(File)) == Utility::NullFile)
+		{
+			printf("AssetPacker: %ls did not read back from %ls\n", File.c_str(), Parsed.OutputPath.c_str());
+			return 1;
+		}
+	}
+
+	printf("AssetPacker: packed %u files into %ls\n", Packed->GetNumEntries(), Parsed.OutputPath.c_str());
+	return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Math/BatchKernels.h"
+#include "CpuFeatures.h"
+#include "EngineProfiling.h"
+#include "HardwareCounters.h"
+#include "Math/Random.h"
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Math;
+using HardwareCounters::CounterTimer;
+
+namespace
+{
+	// Repeat each measurement over ~64M items so that small sizes are timed from a warm cache and the
+	// timer resolution is irrelevant.
+	size_t GetIterations(size_t Count)
+	{
+		return max((size_t)2, (size_t)(64 * 1024 * 1024) / Count);
+	}
+
+	// The counts of the fastest of three runs are kept.
+	template <typename Operation>
+	CounterTimer Measure(size_t Count, Operation op)
+	{
+		const size_t Iterations = GetIterations(Count);
+		CounterTimer Best;
+
+		for (int Run = 0; Run < 3; ++Run)
+		{
+			CounterTimer Timer;
+			Timer.Start();
+			for (size_t i = 0; i < Iterations; ++i)
+				op();
+			Timer.Stop();
+
+			if (Run == 0 || Timer.GetTime() < Best.GetTime())
+				Best = Timer;
+		}
+
+		return Best;
+	}
+
+	void PrintRow(const char* Kernel, size_t Count, const CounterTimer& Timer)
+	{
+		using namespace HardwareCounters;
+
+		const double Items = (double)Count * GetIterations(Count);
+		const Sample& Counts = Timer.GetCounts();
+
+		Utility::Printf("%-18s %10zu %8.3f", Kernel, Count, Timer.GetTime() * 1e9 / Items);
+		if (IsAvailable(kInstructions))
+		{
+			Utility::Printf(" %6.2f %8.4f %8.4f %8.4f\n", Counts.GetIPC(), Counts[kL1DMisses] / Items,
+				Counts[kLLCMisses] / Items, Counts[kBranchMisses] / Items);
+		}
+		else
+		{
+			Utility::Printf(" %8.2f cycles\n", Counts[kCycles] / Items);
+		}
+	}
+}
+
+void HolographicEngine::Benchmarks::RunBatchKernelBenchmark(size_t MaxCount)
+{
+	SystemTime::Initialize();
+
+	// Points and spheres scattered all around a camera looking down -Z, so the visible spheres come in
+	// no predictable order.
+	RandomNumberGenerator Rng;
+	Rng.SetSeed(1);
+
+	std::vector<float> X(MaxCount), Y(MaxCount), Z(MaxCount);
+	std::vector<float> OutX(MaxCount), OutY(MaxCount), OutZ(MaxCount);
+	std::vector<XMFLOAT4> Spheres(MaxCount);
+	std::vector<uint32_t> Visible(MaxCount);
+	for (size_t i = 0; i < MaxCount; ++i)
+	{
+		X[i] = Rng.NextFloat(-100.0f, 100.0f);
+		Y[i] = Rng.NextFloat(-100.0f, 100.0f);
+		Z[i] = Rng.NextFloat(-100.0f, 100.0f);
+		Spheres[i] = XMFLOAT4(X[i], Y[i], Z[i], Rng.NextFloat(0.0f, 2.0f));
+	}
+
+	const Matrix4 Transform(XMMatrixRotationRollPitchYaw(0.3f, 0.7f, 0.1f) * XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+	const Frustum ViewFrustum(Matrix4(XMMatrixPerspectiveFovRH(XM_PIDIV4, 1.0f, 1.0f, 100.0f)));
+
+	Utility::Printf("\nBatch kernels, per item: ns; with %s: IPC, L1D, LLC and branch misses\n%-18s %10s %8s\n",
+		HardwareCounters::IsAvailable(HardwareCounters::kInstructions) ? "perf counters" : "cycles only", "Kernel", "Items", "ns");
+
+	// The kernels' own counter scopes would read the counters on every call, inside what is measured.
+	EngineProfiling::ScopedCountersSuspended CountersSuspended;
+
+	size_t Sink = 0;
+	for (int Tier = 0; Tier <= CpuFeatures::GetMaxTier(); ++Tier)
+	{
+		if (!CpuFeatures::ForceTier((CpuFeatures::SimdTier)Tier))
+			continue;
+
+		Utility::Printf("%s\n", CpuFeatures::GetTierName((CpuFeatures::SimdTier)Tier));
+
+		// From L1 resident, through L2 and the last level, to main memory.
+		for (size_t Count = 1024; Count <= MaxCount; Count *= 16)
+		{
+			PrintRow("TransformPointsSoA", Count, Measure(Count, [&]
+			{
+				TransformPointsSoA(Transform, X.data(), Y.data(), Z.data(), OutX.data(), OutY.data(), OutZ.data(), Count);
+			}));
+
+			PrintRow("CullSpheres", Count, Measure(Count, [&]
+			{
+				Sink += CullSpheres(ViewFrustum, Spheres.data(), Count, Visible.data());
+			}));
+		}
+	}
+	CpuFeatures::ResetTier();
+
+	Utility::Printf("(checksum %zu)\n", Sink);
+}
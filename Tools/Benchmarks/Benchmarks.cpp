@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+// Runs the engine's benchmarks on the development machine.
+//
+//   Benchmarks [simd] [hash] [batch] [compression file...]
+//
+// Runs the named benchmarks, or all of them when none is named, and prints the results to the console.
+// The compression benchmark takes every argument after it as a file to compress and is skipped when
+// there are none.
+
+#include "pch.h"
+#include "Benchmarks.h"
+#include "CpuFeatures.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace HolographicEngine;
+
+int wmain(int argc, wchar_t** argv)
+{
+	bool runSIMDMem = argc == 1;
+	bool runHash = argc == 1;
+	bool runBatchKernels = argc == 1;
+	std::vector<std::wstring> compressionFiles;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::wstring name = argv[i];
+		if (name == L"simd")
+			runSIMDMem = true;
+		else if (name == L"hash")
+			runHash = true;
+		else if (name == L"batch")
+			runBatchKernels = true;
+		else if (name == L"compression")
+		{
+			compressionFiles.assign(argv + i + 1, argv + argc);
+			break;
+		}
+		else
+		{
+			printf("Usage: Benchmarks [simd] [hash] [batch] [compression file...]\n");
+			return 1;
+		}
+	}
+
+	CpuFeatures::Initialize();
+
+	if (runSIMDMem)
+		Benchmarks::RunSIMDMemBenchmark();
+	if (runHash)
+		Benchmarks::RunHashBenchmark();
+	if (runBatchKernels)
+		Benchmarks::RunBatchKernelBenchmark();
+	if (!compressionFiles.empty())
+		Benchmarks::RunCompressionBenchmark(compressionFiles);
+
+	return 0;
+}
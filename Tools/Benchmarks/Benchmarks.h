@@ -0,0 +1,33 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#pragma once
+
+#include "Compression.h"
+#include <string>
+#include <vector>
+
+// The engine's benchmarks, run by Benchmarks.cpp.  Each prints its results through Utility::Printf.
+
+namespace HolographicEngine::Benchmarks
+{
+	// Times every supported CpuFeatures tier against memcpy and memset from 64 bytes to MaxBytes and
+	// prints the throughput of each.  Allocates two buffers of MaxBytes.
+	void RunSIMDMemBenchmark(size_t MaxBytes = 256 * 1024 * 1024);
+
+	// Times both hashes, and Crc32C on each path this CPU supports, and prints the throughput in GB/s.
+	void RunHashBenchmark(size_t maxBytes = 64 * 1024 * 1024);
+
+	// Times each Math batch kernel on every tier the CPU supports, from cache-resident sizes up to
+	// MaxCount items, and prints the time, instructions per cycle and cache and branch misses per item
+	// where the hardware counters are available.
+	void RunBatchKernelBenchmark(size_t MaxCount = 4 * 1024 * 1024);
+
+	// Compresses each file with every registered codec and prints the ratio and the compression and
+	// decompression throughput.
+	void RunCompressionBenchmark(const std::vector<std::wstring>& fileNames, int level = Compression::kMaxLevel);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Compression.h"
+#include "SystemTime.h"
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Compression;
+using namespace HolographicEngine::Utility;
+
+namespace
+{
+	struct CodecTotals
+	{
+		uint64_t SourceBytes = 0;
+		uint64_t CompressedBytes = 0;
+		double CompressSeconds = 0.0;
+		double DecompressSeconds = 0.0;
+		bool Failed = false;
+	};
+
+	// Decompression is repeated until it has run for a while and the best time is kept, so small files
+	// are measured from a warm cache.
+	double TimeDecompress(const Codec& codec, const ByteArray& compressed, vector<unsigned char>& output, bool& matched, const FileView& source)
+	{
+		double BestSeconds = DBL_MAX;
+		double TotalSeconds = 0.0;
+
+		for (int Run = 0; Run < 100 && (Run < 3 || TotalSeconds < 0.25); ++Run)
+		{
+			int64_t Start = SystemTime::GetCurrentTick();
+			bool Succeeded = codec.DecompressInto(compressed->data(), compressed->size(), output.data(), output.size());
+			int64_t End = SystemTime::GetCurrentTick();
+
+			if (!Succeeded)
+			{
+				matched = false;
+				return 0.0;
+			}
+
+			const double Seconds = SystemTime::TimeBetweenTicks(Start, End);
+			BestSeconds = min(BestSeconds, Seconds);
+			TotalSeconds += Seconds;
+		}
+
+		matched = memcmp(output.data(), source.Data(), source.Size()) == 0;
+		return BestSeconds;
+	}
+
+	double Throughput(uint64_t NumBytes, double Seconds)
+	{
+		return Seconds > 0.0 ? NumBytes / Seconds / (1024.0 * 1024.0) : 0.0;
+	}
+}
+
+void HolographicEngine::Benchmarks::RunCompressionBenchmark(const std::vector<std::wstring>& fileNames, int level)
+{
+	SystemTime::Initialize();
+
+	const std::vector<const Codec*> Codecs = GetCodecs();
+	std::vector<CodecTotals> Totals(Codecs.size());
+
+	Utility::Printf("\nCompression benchmark, level %d\n%-10s %-40s %12s %12s %8s %12s %12s\n", level,
+		"Codec", "File", "Bytes", "Compressed", "Ratio", "Comp MB/s", "Decomp MB/s");
+
+	for (const std::wstring& fileName : fileNames)
+	{
+		shared_ptr<MappedFile> file = MappedFile::Open(fileName, kMapWillNeed);
+		if (file == nullptr || file->Size() == 0)
+		{
+			Utility::Printf("Skipping %ws, which is missing or empty\n", fileName);
+			continue;
+		}
+
+		const FileView Source = file->View();
+		std::vector<unsigned char> Output(Source.Size());
+
+		for (size_t c = 0; c < Codecs.size(); ++c)
+		{
+			const Codec& codec = *Codecs[c];
+
+			int64_t Start = SystemTime::GetCurrentTick();
+			ByteArray Compressed = codec.Compress(Source.Data(), Source.Size(), level);
+			const double CompressSeconds = SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick());
+
+			bool Matched = false;
+			const double DecompressSeconds = Compressed != NullFile ? TimeDecompress(codec, Compressed, Output, Matched, Source) : 0.0;
+
+			if (!Matched)
+			{
+				Utility::Printf("%-10s %-40ws FAILED to round trip\n", codec.GetName(), fileName);
+				Totals[c].Failed = true;
+				continue;
+			}
+
+			Utility::Printf("%-10s %-40ws %12zu %12zu %8.3f %12.1f %12.1f\n", codec.GetName(), fileName,
+				Source.Size(), Compressed->size(), (double)Source.Size() / Compressed->size(),
+				Throughput(Source.Size(), CompressSeconds), Throughput(Source.Size(), DecompressSeconds));
+
+			Totals[c].SourceBytes += Source.Size();
+			Totals[c].CompressedBytes += Compressed->size();
+			Totals[c].CompressSeconds += CompressSeconds;
+			Totals[c].DecompressSeconds += DecompressSeconds;
+		}
+	}
+
+	Utility::Print("\nTotals\n");
+	for (size_t c = 0; c < Codecs.size(); ++c)
+	{
+		const CodecTotals& Total = Totals[c];
+		if (Total.CompressedBytes == 0)
+			continue;
+
+		Utility::Printf("%-10s %-40s %12llu %12llu %8.3f %12.1f %12.1f%s\n", Codecs[c]->GetName(), "(all files)",
+			Total.SourceBytes, Total.CompressedBytes, (double)Total.SourceBytes / Total.CompressedBytes,
+			Throughput(Total.SourceBytes, Total.CompressSeconds), Throughput(Total.SourceBytes, Total.DecompressSeconds),
+			Total.Failed ? " (some files failed)" : "");
+	}
+}
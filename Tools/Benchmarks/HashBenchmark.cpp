@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Hash.h"
+#include "SystemTime.h"
+#include "CpuFeatures.h"
+
+using namespace HolographicEngine;
+
+namespace
+{
+	// Repeat each measurement enough to hash ~256 MB so that small sizes are timed from a warm cache and
+	// the timer resolution is irrelevant.  The best of three runs is reported, in GB/s.  The results are
+	// summed so that the hashing cannot be optimized away.
+	template <typename Operation>
+	double MeasureThroughput(size_t NumBytes, uint64_t& Sink, Operation op)
+	{
+		const size_t Iterations = max((size_t)2, (size_t)(256 * 1024 * 1024) / NumBytes);
+		double BestSeconds = DBL_MAX;
+
+		for (int Run = 0; Run < 3; ++Run)
+		{
+			int64_t Start = SystemTime::GetCurrentTick();
+			for (size_t i = 0; i < Iterations; ++i)
+				Sink += op();
+			int64_t End = SystemTime::GetCurrentTick();
+
+			BestSeconds = min(BestSeconds, SystemTime::TimeBetweenTicks(Start, End));
+		}
+
+		return (double)NumBytes * Iterations / max(BestSeconds, 1e-9) / 1e9;
+	}
+}
+
+void HolographicEngine::Benchmarks::RunHashBenchmark(size_t maxBytes)
+{
+	SystemTime::Initialize();
+
+	std::unique_ptr<unsigned char[]> Buffer(new unsigned char[maxBytes]);
+	for (size_t i = 0; i < maxBytes; ++i)
+		Buffer[i] = (unsigned char)(i * 2654435761u >> 13);
+
+	const unsigned char* Data = Buffer.get();
+	const bool HasSSE42 = CpuFeatures::Has(CpuFeatures::kFeatureSSE42) && CpuFeatures::GetMaxTier() >= CpuFeatures::kSSE41;
+	uint64_t Sink = 0;
+
+	Utility::Printf("\nHash throughput, GB/s\n%12s %12s %12s %12s\n", "Bytes", "CRC32C", "CRC32C SSE42", "Hash64");
+
+	for (size_t NumBytes = 64; NumBytes <= maxBytes; NumBytes *= 4)
+	{
+		CpuFeatures::ForceTier(CpuFeatures::kScalar);
+		Utility::Printf("%12zu %12.2f", NumBytes, MeasureThroughput(NumBytes, Sink, [=] { return Hash::Crc32C(Data, NumBytes); }));
+		CpuFeatures::ResetTier();
+
+		if (HasSSE42)
+			Utility::Printf(" %12.2f", MeasureThroughput(NumBytes, Sink, [=] { return Hash::Crc32C(Data, NumBytes); }));
+		else
+			Utility::Printf(" %12s", "-");
+
+		Utility::Printf(" %12.2f\n", MeasureThroughput(NumBytes, Sink, [=] { return Hash::Hash64(Data, NumBytes); }));
+	}
+
+	Utility::Printf("(checksum %llx)\n", Sink);
+}
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Utility.h"
+#include "SystemTime.h"
+#include "CpuFeatures.h"
+
+using namespace HolographicEngine;
+
+namespace
+{
+	// Repeat each measurement enough to move ~256 MB so that small sizes are timed from a warm cache and
+	// the timer resolution is irrelevant.  The best of three runs is reported, in GB/s.
+	template <typename Operation>
+	double MeasureThroughput(size_t NumBytes, Operation op)
+	{
+		const size_t Iterations = max((size_t)2, (size_t)(256 * 1024 * 1024) / NumBytes);
+		double BestSeconds = DBL_MAX;
+
+		for (int Run = 0; Run < 3; ++Run)
+		{
+			int64_t Start = SystemTime::GetCurrentTick();
+			for (size_t i = 0; i < Iterations; ++i)
+				op();
+			int64_t End = SystemTime::GetCurrentTick();
+
+			BestSeconds = min(BestSeconds, SystemTime::TimeBetweenTicks(Start, End));
+		}
+
+		return (double)NumBytes * Iterations / max(BestSeconds, 1e-9) / 1e9;
+	}
+
+	void PrintHeader(const char* Title, const char* PassName)
+	{
+		Utility::Printf("\n%s, %s\n%12s %10s", Title, PassName, "Bytes", "CRT");
+		for (int Tier = 0; Tier < CpuFeatures::kNumSimdTiers; ++Tier)
+			Utility::Printf(" %10s", CpuFeatures::GetTierName((CpuFeatures::SimdTier)Tier));
+		Utility::Print("\n");
+	}
+}
+
+void HolographicEngine::Benchmarks::RunSIMDMemBenchmark(size_t MaxBytes)
+{
+	SystemTime::Initialize();
+
+	const int MaxTier = CpuFeatures::GetMaxTier();
+
+	// A little slack lets the unaligned pass offset both pointers.
+	std::unique_ptr<unsigned char[]> SourceBuffer(new unsigned char[MaxBytes + 128]);
+	std::unique_ptr<unsigned char[]> DestBuffer(new unsigned char[MaxBytes + 128]);
+	memset(SourceBuffer.get(), 0x5A, MaxBytes + 128);
+	memset(DestBuffer.get(), 0, MaxBytes + 128);
+
+	struct Pass { const char* Name; size_t SourceOffset; size_t DestOffset; };
+	const Pass Passes[] = { { "aligned", 0, 0 }, { "unaligned", 3, 7 } };
+
+	for (const Pass& pass : Passes)
+	{
+		unsigned char* Source = Math::AlignUp(SourceBuffer.get(), 64) + pass.SourceOffset;
+		unsigned char* Dest = Math::AlignUp(DestBuffer.get(), 64) + pass.DestOffset;
+
+		PrintHeader("SIMDMemCopy vs memcpy", pass.Name);
+		for (size_t NumBytes = 64; NumBytes <= MaxBytes; NumBytes *= 4)
+		{
+			Utility::Printf("%12zu %10.2f", NumBytes, MeasureThroughput(NumBytes, [=] { memcpy(Dest, Source, NumBytes); }));
+
+			for (int Tier = 0; Tier < CpuFeatures::kNumSimdTiers; ++Tier)
+			{
+				if (Tier > MaxTier)
+				{
+					Utility::Printf(" %10s", "-");
+					continue;
+				}
+
+				CpuFeatures::ForceTier((CpuFeatures::SimdTier)Tier);
+				Utility::Printf(" %10.2f", MeasureThroughput(NumBytes, [=] { SIMDMemCopyBytes(Dest, Source, NumBytes); }));
+			}
+			Utility::Print("\n");
+		}
+
+		PrintHeader("SIMDMemFill vs memset", pass.Name);
+		for (size_t NumBytes = 64; NumBytes <= MaxBytes; NumBytes *= 4)
+		{
+			Utility::Printf("%12zu %10.2f", NumBytes, MeasureThroughput(NumBytes, [=] { memset(Dest, 0x3C, NumBytes); }));
+
+			for (int Tier = 0; Tier < CpuFeatures::kNumSimdTiers; ++Tier)
+			{
+				if (Tier > MaxTier)
+				{
+					Utility::Printf(" %10s", "-");
+					continue;
+				}
+
+				CpuFeatures::ForceTier((CpuFeatures::SimdTier)Tier);
+				Utility::Printf(" %10.2f", MeasureThroughput(NumBytes, [=] { SIMDMemFillBytes(Dest, 0x3C, NumBytes); }));
+			}
+			Utility::Print("\n");
+		}
+	}
+
+	CpuFeatures::ResetTier();
+}
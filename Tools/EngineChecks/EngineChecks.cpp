@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+// Checks engine code that can run without a GPU, a window or a package.
+//
+//   EngineChecks
+//
+// Prints each check that fails and exits with the number that did, so it can run as a build step.
+
+#include "pch.h"
+#include "Graphics/ShaderCache.h"
+#include <cstdio>
+
+using namespace HolographicEngine;
+using namespace HolographicEngine::Graphics;
+
+namespace
+{
+	// Runs a cache over a NullShaderDevice and made-up bytecode: identical bytecode is created once, each
+	// variant gets its own stages, a missing stage throws and SetDevice drops everything.
+	bool CheckShaderCache(void)
+	{
+		bool passed = true;
+		auto check = [&passed](bool condition, const char* what)
+		{
+			if (!condition)
+			{
+				printf("EngineChecks: shader cache: %s\n", what);
+				passed = false;
+			}
+		};
+
+		auto makeBytecode = [](std::initializer_list<unsigned char> bytes)
+		{
+			return std::make_shared<std::vector<unsigned char> >(bytes);
+		};
+
+		// Two names for the same bytecode, as when a shader is shipped under two file names.
+		std::unordered_map<std::wstring, Utility::ByteArray> files;
+		files[L"VertexShader.cso"] = makeBytecode({ 1, 2, 3, 4 });
+		files[L"CopyOfVertexShader.cso"] = makeBytecode({ 1, 2, 3, 4 });
+		files[L"VprtVertexShader.cso"] = makeBytecode({ 5, 6, 7, 8 });
+		files[L"GeometryShader.cso"] = makeBytecode({ 9, 10 });
+		files[L"PixelShader.cso"] = makeBytecode({ 11, 12 });
+
+		std::shared_ptr<NullShaderDevice> device = std::make_shared<NullShaderDevice>();
+		ShaderCache cache;
+		cache.SetDevice(device);
+		cache.SetLoader([files](const std::wstring& fileName)
+		{
+			auto file = files.find(fileName);
+			return file != files.end() ? file->second : Utility::NullFile;
+		});
+
+		cache.GetVertexShader(cache.LoadBytecode(L"VertexShader.cso"));
+		cache.GetVertexShader(cache.LoadBytecode(L"CopyOfVertexShader.cso"));
+		check(device->GetNumCreated() == 1, "identical bytecode was created twice");
+		check(cache.GetStats().Hits == 1, "identical bytecode was not a hit");
+
+		const D3D11_INPUT_ELEMENT_DESC element = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+		ShaderProgramDesc desc;
+		desc.VprtVertexShader = L"VprtVertexShader.cso";
+		desc.VertexShader = L"VertexShader.cso";
+		desc.GeometryShader = L"GeometryShader.cso";
+		desc.PixelShader = L"PixelShader.cso";
+		desc.InputElements = &element;
+		desc.NumInputElements = 1;
+
+		// The vertex shader is already there; the pixel and geometry shaders and the layout are new.
+		ShaderProgram program = cache.LoadProgram(desc, false);
+		check(!program.UsesVprt && device->GetNumCreated() == 4, "the geometry shader variant created the wrong objects");
+
+		// Another vertex shader, and a layout validated against it; the pixel shader is shared.
+		program = cache.LoadProgram(desc, true);
+		check(program.UsesVprt && device->GetNumCreated() == 6, "the VPRT variant created the wrong objects");
+
+		cache.LoadProgram(desc, true);
+		check(device->GetNumCreated() == 6, "loading a program again created objects");
+
+		ShaderProgramDesc missing = desc;
+		missing.PixelShader = L"MissingPixelShader.cso";
+		bool threw = false;
+		try
+		{
+			cache.LoadProgram(missing, true);
+		}
+		catch (const winrt::hresult_error&)
+		{
+			threw = true;
+		}
+		check(threw, "a missing pixel shader did not throw");
+
+		// Only the VPRT variant may do without a geometry shader.
+		missing = desc;
+		missing.GeometryShader.clear();
+		check(cache.LoadProgram(missing, true).GeometryShader == nullptr, "the VPRT variant needed a geometry shader");
+
+		cache.SetDevice(std::make_shared<NullShaderDevice>());
+		check(cache.GetStats().NumShaders == 0 && cache.GetStats().NumInputLayouts == 0, "a new device kept the old objects");
+
+		return passed;
+	}
+}
+
+int wmain(int, wchar_t**)
+{
+	int failed = 0;
+	if (!CheckShaderCache())
+		++failed;
+
+	printf("EngineChecks: %d failed\n", failed);
+	return failed;
+}
@@ -0,0 +1,298 @@
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+// Tails the metrics ring that an app built on the engine publishes; see MetricsPublisher.h.
+//
+//   MetricsReader [-p channel] [-n every] [file]
+//
+// Without a file, reads the most recently written EngineMetrics.bin among the installed packages' local
+// folders.  Prints a row per record, or with -p a bar per record for one channel, named or numbered,
+// scaled to the largest value seen.  -n prints only every nth record.  Waits for the app to start, and
+// follows it when it starts again.  The app's frame loop is never involved: the reader only maps the
+// file, read only, and a record it falls behind on is skipped, not waited for.
+
+#include <windows.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "../../CoreUWP/src/MetricsRing.h"
+
+using namespace HolographicEngine;
+
+namespace
+{
+	const wchar_t* kRingName = L"EngineMetrics.bin";
+	const DWORD kPollMilliseconds = 50;
+	const int kBarWidth = 60;
+
+	struct Options
+	{
+		std::wstring Path;
+		std::string PlotChannel;
+		uint64_t Every = 1;
+	};
+
+	class MappedRing
+	{
+	public:
+		~MappedRing() { Close(); }
+
+		bool Open(const std::wstring& path)
+		{
+			m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			LARGE_INTEGER Size;
+			if (m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_File, &Size) || Size.QuadPart < (LONGLONG)sizeof(MetricsRing::Header))
+			{
+				Close();
+				return false;
+			}
+
+			m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			m_Header = m_Mapping != nullptr ? (const MetricsRing::Header*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+			m_Size = (size_t)Size.QuadPart;
+			if (m_Header == nullptr)
+			{
+				Close();
+				return false;
+			}
+
+			return true;
+		}
+
+		void Close(void)
+		{
+			if (m_Header != nullptr)
+				UnmapViewOfFile(m_Header);
+			if (m_Mapping != nullptr)
+				CloseHandle(m_Mapping);
+			if (m_File != INVALID_HANDLE_VALUE)
+				CloseHandle(m_File);
+
+			m_File = INVALID_HANDLE_VALUE;
+			m_Mapping = nullptr;
+			m_Header = nullptr;
+		}
+
+		// Whether the file holds a session this reader understands, all of it inside the mapping.
+		bool IsValid(void) const
+		{
+			return m_Header != nullptr && m_Header->Magic.load(std::memory_order_acquire) == MetricsRing::kMagic &&
+				m_Header->Version == MetricsRing::kVersion && m_Header->Capacity > 0 &&
+				MetricsRing::GetSize(m_Header->Capacity) <= m_Size;
+		}
+
+		const MetricsRing::Header* GetHeader(void) const { return m_Header; }
+
+	private:
+		HANDLE m_File = INVALID_HANDLE_VALUE;
+		HANDLE m_Mapping = nullptr;
+		const MetricsRing::Header* m_Header = nullptr;
+		size_t m_Size = 0;
+	};
+
+	// The EngineMetrics.bin written last, in any package's LocalState folder.
+	std::wstring FindRing(void)
+	{
+		wchar_t LocalAppData[MAX_PATH];
+		if (GetEnvironmentVariableW(L"LOCALAPPDATA", LocalAppData, MAX_PATH) == 0)
+			return std::wstring();
+
+		const std::wstring Packages = std::wstring(LocalAppData) + L"\\Packages\\";
+		WIN32_FIND_DATAW Found;
+		HANDLE Find = FindFirstFileW((Packages + L"*").c_str(), &Found);
+		if (Find == INVALID_HANDLE_VALUE)
+			return std::wstring();
+
+		std::wstring Newest;
+		FILETIME NewestTime = {};
+		do
+		{
+			if (!(Found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || Found.cFileName[0] == L'.')
+				continue;
+
+			const std::wstring Path = Packages + Found.cFileName + L"\\LocalState\\" + kRingName;
+			WIN32_FILE_ATTRIBUTE_DATA Attributes;
+			if (GetFileAttributesExW(Path.c_str(), GetFileExInfoStandard, &Attributes) &&
+				CompareFileTime(&Attributes.ftLastWriteTime, &NewestTime) > 0)
+			{
+				Newest = Path;
+				NewestTime = Attributes.ftLastWriteTime;
+			}
+		} while (FindNextFileW(Find, &Found));
+
+		FindClose(Find);
+		return Newest;
+	}
+
+	// The channel named, or numbered, by the option, or -1.
+	int FindChannel(const MetricsRing::Header* header, uint32_t numChannels, const std::string& name)
+	{
+		char* End = nullptr;
+		const long Index = strtol(name.c_str(), &End, 10);
+		if (!name.empty() && *End == 0)
+			return Index >= 0 && Index < (long)numChannels ? (int)Index : -1;
+
+		for (uint32_t i = 0; i < numChannels; ++i)
+		{
+			if (_strnicmp(header->ChannelNames[i], name.c_str(), MetricsRing::kMaxNameLength) == 0)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	void PrintColumns(const MetricsRing::Header* header, uint32_t numChannels)
+	{
+		printf("%10s %9s", "Frame", "Seconds");
+		for (uint32_t i = 0; i < numChannels; ++i)
+			printf(" %12.12s", header->ChannelNames[i]);
+		printf("\n");
+	}
+
+	void PrintRow(const MetricsRing::Sample& sample, uint32_t numChannels)
+	{
+		printf("%10llu %9.3f", (unsigned long long)sample.Frame, sample.Time);
+		for (uint32_t i = 0; i < numChannels; ++i)
+			printf(" %12.3f", sample.Values[i]);
+		printf("\n");
+	}
+
+	void PrintBar(const MetricsRing::Sample& sample, int channel, float& largest)
+	{
+		const float Value = sample.Values[channel];
+		largest = Value > largest ? Value : largest;
+
+		const int Length = largest > 0.0f ? (int)(Value / largest * kBarWidth + 0.5f) : 0;
+		printf("%10llu %12.3f |%s\n", (unsigned long long)sample.Frame, Value,
+			std::string(Length > 0 ? Length : 0, '#').c_str());
+	}
+
+	// Follows one session of the app until it ends or starts again.
+	void Tail(const MappedRing& ring, const Options& options)
+	{
+		const MetricsRing::Header* Header = ring.GetHeader();
+		const uint64_t Session = Header->Session;
+		const uint32_t Capacity = Header->Capacity;
+
+		uint32_t NumChannels = 0;
+		int PlotChannel = -1;
+		float Largest = 0.0f;
+		uint64_t Next = Header->WriteCount.load(std::memory_order_acquire);
+		uint64_t Skipped = 0;
+
+		while (ring.IsValid() && Header->Session == Session)
+		{
+			const uint32_t Channels = Header->NumChannels.load(std::memory_order_acquire);
+			if (Channels != NumChannels)
+			{
+				NumChannels = Channels < MetricsRing::kMaxChannels ? Channels : MetricsRing::kMaxChannels;
+				if (options.PlotChannel.empty())
+				{
+					PrintColumns(Header, NumChannels);
+				}
+				else
+				{
+					PlotChannel = FindChannel(Header, NumChannels, options.PlotChannel);
+					if (PlotChannel >= 0)
+						printf("%10s %12.12s\n", "Frame", Header->ChannelNames[PlotChannel]);
+				}
+			}
+
+			const uint64_t Count = Header->WriteCount.load(std::memory_order_acquire);
+			if (Count - Next > Capacity)
+			{
+				// Lapped by the writer; start from the oldest record it is not about to overwrite.
+				Skipped += Count - Capacity + 1 - Next;
+				Next = Count - Capacity + 1;
+			}
+
+			for (; Next < Count; ++Next)
+			{
+				MetricsRing::Sample Record;
+				if (!MetricsRing::Read(Header, Next, Record))
+				{
+					++Skipped;
+					continue;
+				}
+
+				if (Skipped != 0)
+				{
+					printf("(%llu records skipped)\n", (unsigned long long)Skipped);
+					Skipped = 0;
+				}
+
+				if (Next % options.Every != 0)
+					continue;
+
+				if (options.PlotChannel.empty())
+					PrintRow(Record, NumChannels);
+				else if (PlotChannel >= 0)
+					PrintBar(Record, PlotChannel, Largest);
+			}
+
+			Sleep(kPollMilliseconds);
+		}
+	}
+
+	bool ParseOptions(int argc, wchar_t** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::wstring Arg = argv[i];
+			if (Arg == L"-p" && i + 1 < argc)
+			{
+				const std::wstring Channel = argv[++i];
+				options.PlotChannel.assign(Channel.begin(), Channel.end());
+			}
+			else if (Arg == L"-n" && i + 1 < argc)
+			{
+				options.Every = _wcstoui64(argv[++i], nullptr, 10);
+				if (options.Every == 0)
+					return false;
+			}
+			else if (Arg[0] != L'-' && options.Path.empty())
+			{
+				options.Path = Arg;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+	Options Parsed;
+	if (!ParseOptions(argc, argv, Parsed))
+	{
+		printf("Usage: MetricsReader [-p channel] [-n every] [file]\n");
+		return 1;
+	}
+
+	bool Waiting = false;
+	for (;;)
+	{
+		const std::wstring Path = Parsed.Path.empty() ? FindRing() : Parsed.Path;
+
+		MappedRing Ring;
+		if (Path.empty() || !Ring.Open(Path) || !Ring.IsValid())
+		{
+			if (!Waiting)
+				printf("Waiting for an app to publish metrics...\n");
+			Waiting = true;
+			Sleep(500);
+			continue;
+		}
+
+		Waiting = false;
+		printf("Reading %ls\n", Path.c_str());
+		Tail(Ring, Parsed);
+	}
+}